@@ -62,10 +62,13 @@ USpatialActorChannel::USpatialActorChannel(const FObjectInitializer& ObjectIniti
 	: Super(ObjectInitializer)
 	, EntityId(0)
 	, bFirstTick(true)
+	, bNetOwned(false)
+	, bCachedHasPlayerState(false)
 	, NetDriver(nullptr)
 	, LastSpatialPosition(FVector::ZeroVector)
 	, LastSpatialRotation(FRotator::ZeroRotator)
 	, bCreatingNewEntity(false)
+	, ReplicationBytesWritten(0)
 {
 }
 
@@ -129,6 +132,11 @@ bool USpatialActorChannel::CleanUp(const bool bForDestroy)
 	}
 #endif
 
+	if (NetDriver != nullptr)
+	{
+		NetDriver->RemoveOwnershipTracking(this, CachedOwner);
+	}
+
 	return UActorChannel::CleanUp(bForDestroy);
 }
 
@@ -207,6 +215,9 @@ int64 USpatialActorChannel::ReplicateActor()
 	check(Connection);
 	check(Connection->PackageMap);
 
+	// Owners are set by game code (SetOwner, Possess) without notifying the net driver, pick the change up here.
+	CheckOwnershipChanged();
+
 	const UWorld* const ActorWorld = Actor->GetWorld();
 
 	// Time how long it takes to replicate this particular actor
@@ -220,6 +231,7 @@ int64 USpatialActorChannel::ReplicateActor()
 	}
 
 	bIsReplicatingActor = true;
+	ReplicationBytesWritten = 0;
 	FReplicationFlags RepFlags;
 
 	// Send initial stuff.
@@ -310,7 +322,7 @@ int64 USpatialActorChannel::ReplicateActor()
 	{
 		if (bCreatingNewEntity)
 		{
-			Sender->SendCreateEntityRequest(this);
+			ReplicationBytesWritten += Sender->SendCreateEntityRequest(this);
 
 			// Since we've tried to create this Actor in Spatial, we no longer have authority over the actor since it hasn't been delegated to us.
 			Actor->Role = ROLE_SimulatedProxy;
@@ -319,7 +331,7 @@ int64 USpatialActorChannel::ReplicateActor()
 		else
 		{
 			FRepChangeState RepChangeState = { RepChanged, GetObjectRepLayout(Actor) };
-			Sender->SendComponentUpdates(Actor, Info, this, &RepChangeState, &HandoverChangeState);
+			ReplicationBytesWritten += Sender->SendComponentUpdates(Actor, Info, this, &RepChangeState, &HandoverChangeState);
 		}
 
 		bWroteSomethingImportant = true;
@@ -371,7 +383,7 @@ int64 USpatialActorChannel::ReplicateActor()
 			FHandoverChangeState SubobjectHandoverChangeState = GetHandoverChangeList(SubobjectHandoverShadowData->Get(), Subobject);
 			if (SubobjectHandoverChangeState.Num() > 0)
 			{
-				Sender->SendComponentUpdates(Subobject, SubobjectInfo, this, nullptr, &SubobjectHandoverChangeState);
+				ReplicationBytesWritten += Sender->SendComponentUpdates(Subobject, SubobjectInfo, this, nullptr, &SubobjectHandoverChangeState);
 			}
 		}
 	}
@@ -387,7 +399,8 @@ int64 USpatialActorChannel::ReplicateActor()
 
 	bForceCompareProperties = false;		// Only do this once per frame when set
 
-	return (bWroteSomethingImportant) ? 1 : 0;	// TODO: return number of bits written (UNR-664)
+	// An update may still come out empty, it has to report that something was written.
+	return bWroteSomethingImportant ? FMath::Max<int64>(ReplicationBytesWritten * 8, 1) : 0;
 }
 
 bool USpatialActorChannel::ReplicateSubobject(UObject* Object, FClassInfo* Info, const FReplicationFlags& RepFlags)
@@ -427,7 +440,7 @@ bool USpatialActorChannel::ReplicateSubobject(UObject* Object, FClassInfo* Info,
 	if (RepChanged.Num() > 0)
 	{
 		FRepChangeState RepChangeState = { RepChanged, GetObjectRepLayout(Object) };
-		Sender->SendComponentUpdates(Object, Info, this, &RepChangeState, nullptr);
+		ReplicationBytesWritten += Sender->SendComponentUpdates(Object, Info, this, &RepChangeState, nullptr);
 		Replicator.RepState->HistoryEnd++;
 	}
 
@@ -545,6 +558,11 @@ void USpatialActorChannel::SetChannelActor(AActor* InActor)
 		return;
 	}
 
+	CheckOwnershipChanged();
+	NetDriver->MarkOwnershipDirty(this);
+
+	TransformSettings = NetDriver->GetTransformReplicationSettings(InActor->GetClass());
+
 	// Get the entity ID from the entity registry (or return 0 if it doesn't exist).
 	check(NetDriver->GetEntityRegistry());
 	EntityId = NetDriver->GetEntityRegistry()->GetEntityIdFromActor(InActor);
@@ -605,6 +623,12 @@ void USpatialActorChannel::PostReceiveSpatialUpdate(UObject* TargetObject, const
 	TargetObject->PostNetReceive();
 	Replicator.RepNotifies = RepNotifies;
 	Replicator.CallRepNotifies(false);
+
+	// The update may have carried a new owner or player state.
+	if (TargetObject == Actor)
+	{
+		CheckOwnershipChanged();
+	}
 }
 
 void USpatialActorChannel::RegisterEntityId(const Worker_EntityId& ActorEntityId)
@@ -671,6 +695,7 @@ void USpatialActorChannel::OnCreateEntityResponse(const Worker_CreateEntityRespo
 		if (Op.status_code == WORKER_STATUS_CODE_TIMEOUT)
 		{
 			UE_LOG(LogSpatialActorChannel, Warning, TEXT("Failed to create entity for actor %s Reason: %s. Retrying..."), *Actor->GetName(), UTF8_TO_TCHAR(Op.message));
+			// Sent from op processing, so unlike the first attempt it isn't charged to the replication budget.
 			Sender->SendCreateEntityRequest(this);
 		}
 		else
@@ -691,15 +716,14 @@ void USpatialActorChannel::UpdateSpatialPosition()
 	// of the PlayerController and PlayerState at the same time as the pawn.
 
 	// Check that it has moved sufficiently far to be updated
-	const float SpatialPositionThreshold = 100.0f * 100.0f; // 1m (100cm)
 	FVector ActorSpatialPosition = GetActorSpatialPosition(Actor);
-	if (FVector::DistSquared(ActorSpatialPosition, LastSpatialPosition) < SpatialPositionThreshold)
+	if (FVector::DistSquared(ActorSpatialPosition, LastSpatialPosition) < FMath::Square(TransformSettings.PositionThreshold))
 	{
 		return;
 	}
 
 	LastSpatialPosition = ActorSpatialPosition;
-	Sender->SendPositionUpdate(EntityId, LastSpatialPosition);
+	ReplicationBytesWritten += Sender->SendPositionUpdate(EntityId, LastSpatialPosition);
 
 	// If we're a pawn and are controlled by a player controller, update the player controller and the player state positions too.
 	if (APawn* Pawn = Cast<APawn>(Actor))
@@ -711,7 +735,7 @@ void USpatialActorChannel::UpdateSpatialPosition()
 				bool bHasControllerAuthority = NetDriver->StaticComponentView->HasAuthority(ControllerActorChannel->GetEntityId(), SpatialConstants::POSITION_COMPONENT_ID);
 				if (bHasControllerAuthority)
 				{
-					Sender->SendPositionUpdate(ControllerActorChannel->GetEntityId(), LastSpatialPosition);
+					ReplicationBytesWritten += Sender->SendPositionUpdate(ControllerActorChannel->GetEntityId(), LastSpatialPosition);
 				}
 			}
 
@@ -720,7 +744,7 @@ void USpatialActorChannel::UpdateSpatialPosition()
 				bool bHasPlayerStateAuthority = NetDriver->StaticComponentView->HasAuthority(PlayerStateActorChannel->GetEntityId(), SpatialConstants::POSITION_COMPONENT_ID);
 				if (bHasPlayerStateAuthority)
 				{
-					Sender->SendPositionUpdate(PlayerStateActorChannel->GetEntityId(), LastSpatialPosition);
+					ReplicationBytesWritten += Sender->SendPositionUpdate(PlayerStateActorChannel->GetEntityId(), LastSpatialPosition);
 				}
 			}
 		}
@@ -732,16 +756,15 @@ void USpatialActorChannel::UpdateSpatialRotation()
 	FRotator ActorSpatialRotation = Actor->GetActorRotation();
 
 	// Only update the Actor's rotation if it has rotated far enough
-	const float SpatialRotationThreshold = 0.1f;  // 0.1 radian (~5.7 degrees)
 	FQuat RotationDelta = (ActorSpatialRotation - LastSpatialRotation).Quaternion();
 	RotationDelta.Normalize();
-	if (RotationDelta.GetAngle() < SpatialRotationThreshold)
+	if (RotationDelta.GetAngle() < TransformSettings.RotationThreshold)
 	{
 		return;
 	}
 
 	LastSpatialRotation = ActorSpatialRotation;
-	Sender->SendRotationUpdate(EntityId, Actor->GetActorRotation());
+	ReplicationBytesWritten += Sender->SendRotationUpdate(EntityId, Actor->GetActorRotation(), TransformSettings.bQuantizeRotation);
 }
 
 FVector USpatialActorChannel::GetActorSpatialPosition(AActor* InActor)
@@ -763,39 +786,70 @@ FVector USpatialActorChannel::GetActorSpatialPosition(AActor* InActor)
 	}
 }
 
-void USpatialActorChannel::SpatialViewTick()
+bool USpatialActorChannel::SpatialViewTick()
 {
-	if (Actor != nullptr && !Actor->IsPendingKill() && IsReadyForReplication())
+	if (Actor == nullptr || Actor->IsPendingKill() || !IsReadyForReplication())
 	{
-		bool bOldNetOwned = bNetOwned;
+		// Marked dirty again once the entity ID is registered or authority is gained.
+		return false;
+	}
+
+	bool bOldNetOwned = bNetOwned;
 
-		// Use Actor's connection to determine if client owned
-		bNetOwned = false;
-		if (UNetConnection* NetConnection = Actor->GetNetConnection())
+	// Use Actor's connection to determine if client owned
+	bNetOwned = false;
+	if (UNetConnection* NetConnection = Actor->GetNetConnection())
+	{
+		if (APlayerController* PlayerController = NetConnection->PlayerController)
 		{
-			if (APlayerController* PlayerController = NetConnection->PlayerController)
-			{
-				bNetOwned = PlayerController->PlayerState != nullptr;
-			}
+			bNetOwned = PlayerController->PlayerState != nullptr;
 		}
+	}
 
-		if (bFirstTick || bOldNetOwned != bNetOwned)
+	if (bFirstTick || bOldNetOwned != bNetOwned)
+	{
+		if (IsAuthoritativeServer())
 		{
-			if (IsAuthoritativeServer())
-			{
-				bool bSuccess = Sender->UpdateEntityACLs(Actor, GetEntityId());
+			bool bSuccess = Sender->UpdateEntityACLs(Actor, GetEntityId());
 
-				if (bFirstTick && bSuccess)
-				{
-					bFirstTick = false;
-				}
-			}
-			else if (!NetDriver->IsServer())
+			if (bFirstTick && bSuccess)
 			{
-				Sender->SendComponentInterest(Actor, GetEntityId());
-
 				bFirstTick = false;
 			}
+
+			// Keep trying until the initial ACLs have been sent.
+			return bFirstTick;
+		}
+		else if (!NetDriver->IsServer())
+		{
+			Sender->SendComponentInterest(Actor, GetEntityId());
+
+			bFirstTick = false;
 		}
 	}
+
+	return false;
+}
+
+void USpatialActorChannel::CheckOwnershipChanged()
+{
+	if (Actor == nullptr)
+	{
+		return;
+	}
+
+	AActor* NewOwner = Actor->GetOwner();
+
+	bool bNewHasPlayerState = false;
+	if (APlayerController* PlayerController = Cast<APlayerController>(Actor))
+	{
+		bNewHasPlayerState = PlayerController->PlayerState != nullptr;
+	}
+
+	if (CachedOwner != TWeakObjectPtr<AActor>(NewOwner) || bNewHasPlayerState != bCachedHasPlayerState)
+	{
+		NetDriver->OnChannelOwnerChanged(this, CachedOwner, NewOwner);
+		CachedOwner = NewOwner;
+		bCachedHasPlayerState = bNewHasPlayerState;
+	}
 }
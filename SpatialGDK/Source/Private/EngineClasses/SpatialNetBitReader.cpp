@@ -13,6 +13,11 @@ FSpatialNetBitReader::FSpatialNetBitReader(USpatialPackageMapClient* InPackageMa
 	: FNetBitReader(InPackageMap, Source, CountBits)
 	, UnresolvedRefs(InUnresolvedRefs) {}
 
+// FBitReader copies Source into its own buffer on construction, so it is never written through.
+FSpatialNetBitReader::FSpatialNetBitReader(USpatialPackageMapClient* InPackageMap, TArrayView<const uint8> Source, int64 CountBits, TSet<FUnrealObjectRef>& InUnresolvedRefs)
+	: FNetBitReader(InPackageMap, const_cast<uint8*>(Source.GetData()), CountBits)
+	, UnresolvedRefs(InUnresolvedRefs) {}
+
 void FSpatialNetBitReader::DeserializeObjectRef(FUnrealObjectRef& ObjectRef)
 {
 	*this << ObjectRef.Entity;
@@ -2,6 +2,7 @@
 
 #include "EngineClasses/SpatialNetDriver.h"
 
+#include "Async/Async.h"
 #include "EngineGlobals.h"
 #include "Engine/ActorChannel.h"
 #include "Engine/ChildConnection.h"
@@ -10,6 +11,9 @@
 #include "GameFramework/GameModeBase.h"
 #include "GameFramework/GameNetworkManager.h"
 #include "Net/DataReplication.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
 #include "Net/RepLayout.h"
 #include "SocketSubsystem.h"
 #include "UObject/UObjectIterator.h"
@@ -17,7 +21,9 @@
 #include "Interop/Connection/SpatialWorkerConnection.h"
 #include "Interop/GlobalStateManager.h"
 #include "Interop/SnapshotManager.h"
+#include "Interop/SpatialActorPool.h"
 #include "Interop/SpatialPlayerSpawner.h"
+#include "Interop/SpatialRetryScheduler.h"
 #include "Interop/SpatialReceiver.h"
 #include "Interop/SpatialSender.h"
 #include "Interop/SpatialTypebindingManager.h"
@@ -32,6 +38,11 @@
 
 DEFINE_LOG_CATEGORY(LogSpatialOSNetDriver);
 
+DECLARE_CYCLE_STAT(TEXT("ProcessOps"), STAT_SpatialProcessOps, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ownership channels ticked"), STAT_SpatialOwnershipChannelsTicked, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replicated bytes"), STAT_SpatialReplicatedBytes, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Actors deferred by replication budget"), STAT_SpatialActorsDeferredByBudget, STATGROUP_SpatialNet);
+
 bool USpatialNetDriver::InitBase(bool bInitAsClient, FNetworkNotify* InNotify, const FURL& URL, bool bReuseAddressAndPort, FString& Error)
 {
 	if (!Super::InitBase(bInitAsClient, InNotify, URL, bReuseAddressAndPort, Error))
@@ -42,6 +53,21 @@ bool USpatialNetDriver::InitBase(bool bInitAsClient, FNetworkNotify* InNotify, c
 	bConnectAsClient = bInitAsClient;
 	bAuthoritativeDestruction = true;
 
+	ReplicationBytesPerTick = SpatialConstants::REPLICATION_DEFAULT_BYTES_PER_TICK;
+	FParse::Value(FCommandLine::Get(), TEXT("replicationBytesPerTick"), ReplicationBytesPerTick);
+	ReplicationBytesThisTick = 0;
+	LastOwnershipSweepTime = 0.0;
+
+	FString ReplicationSettingsPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("replicationSettings"), ReplicationSettingsPath))
+	{
+		ReplicationSettings = LoadObject<USpatialReplicationSettings>(nullptr, *ReplicationSettingsPath);
+		if (ReplicationSettings == nullptr)
+		{
+			UE_LOG(LogSpatialOSNetDriver, Warning, TEXT("Couldn't load replication settings %s, using the defaults."), *ReplicationSettingsPath);
+		}
+	}
+
 	FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &USpatialNetDriver::OnMapLoaded);
 
 	// Make absolutely sure that the actor channel that we are using is our Spatial actor channel
@@ -186,7 +212,16 @@ void USpatialNetDriver::OnMapLoadedAndConnected()
 	PlayerSpawner = NewObject<USpatialPlayerSpawner>();
 	StaticComponentView = NewObject<USpatialStaticComponentView>();
 	SnapshotManager = NewObject<USnapshotManager>();
+	ActorPool = NewObject<USpatialActorPool>();
+	RetryScheduler = NewObject<USpatialRetryScheduler>();
 
+	float PositionIndexCellSize;
+	if (FParse::Value(FCommandLine::Get(), TEXT("positionIndexCellSize"), PositionIndexCellSize))
+	{
+		StaticComponentView->SetPositionIndexCellSize(PositionIndexCellSize);
+	}
+
+	RetryScheduler->Init(this, TimerManager);
 	PlayerSpawner->Init(this, TimerManager);
 
 	// Each connection stores a URL with various optional settings (host, port, map, netspeed...)
@@ -214,12 +249,15 @@ void USpatialNetDriver::OnMapLoadedAndConnected()
 
 	PackageMap = Cast<USpatialPackageMapClient>(GetSpatialOSNetConnection()->PackageMap);
 
+	ActorPool->Init(this);
 	Dispatcher->Init(this);
 	Sender->Init(this);
 	Receiver->Init(this, TimerManager);
 	GlobalStateManager->Init(this, TimerManager);
 	SnapshotManager->Init(this);
 
+	InitViewCache();
+
 	// Bind the ProcessServerTravel delegate to the spatial variant. This ensures that if ServerTravel is called and Spatial networking is enabled, we can travel properly.
 	GetWorld()->SpatialProcessServerTravelDelegate.BindStatic(SpatialProcessServerTravel);
 
@@ -427,6 +465,112 @@ void USpatialNetDriver::NotifyActorDestroyed(AActor* ThisActor, bool IsSeamlessT
 	RenamedStartupActors.Remove(ThisActor->GetFName());
 }
 
+void USpatialNetDriver::Shutdown()
+{
+	if (Dispatcher != nullptr)
+	{
+		Dispatcher->Shutdown();
+	}
+
+	if (Receiver != nullptr)
+	{
+		Receiver->Shutdown();
+	}
+
+	if (RetryScheduler != nullptr)
+	{
+		RetryScheduler->Shutdown();
+	}
+
+	if (Sender != nullptr)
+	{
+		Sender->Shutdown();
+	}
+
+	if (TimerManager != nullptr)
+	{
+		TimerManager->ClearTimer(ViewCacheSaveTimer);
+		TimerManager->ClearTimer(ViewCacheReleaseTimer);
+	}
+
+	// The final save below writes the same file.
+	if (ViewCacheWriteTask.IsValid())
+	{
+		ViewCacheWriteTask.Wait();
+	}
+
+	if (!ViewCacheFilePath.IsEmpty() && StaticComponentView != nullptr)
+	{
+		ReleaseViewCache();
+		SaveViewCache();
+	}
+
+	Super::Shutdown();
+}
+
+void USpatialNetDriver::InitViewCache()
+{
+	if (!FParse::Value(FCommandLine::Get(), TEXT("viewCacheFile"), ViewCacheFilePath))
+	{
+		return;
+	}
+
+	// The world may already be gone by the time the cache is saved on shutdown.
+	ViewCacheMapName = GetWorld()->GetMapName();
+
+	ViewCache = MakeUnique<FSpatialViewCache>();
+	if (ViewCache->Load(ViewCacheFilePath, ViewCacheMapName))
+	{
+		ViewCache->PrewarmClasses(TypebindingManager);
+		StaticComponentView->SetWarmStartCache(ViewCache.Get());
+
+		TimerManager->SetTimer(ViewCacheReleaseTimer, FTimerDelegate::CreateUObject(this, &USpatialNetDriver::ReleaseViewCache), SpatialConstants::VIEW_CACHE_VALIDATION_WINDOW_SECONDS, false);
+	}
+	else
+	{
+		ViewCache.Reset();
+	}
+
+	float SaveInterval = SpatialConstants::VIEW_CACHE_DEFAULT_SAVE_INTERVAL_SECONDS;
+	FParse::Value(FCommandLine::Get(), TEXT("viewCacheSaveInterval"), SaveInterval);
+	if (SaveInterval > 0.0f)
+	{
+		TimerManager->SetTimer(ViewCacheSaveTimer, FTimerDelegate::CreateUObject(this, &USpatialNetDriver::SaveViewCacheAsync), SaveInterval, true);
+	}
+}
+
+void USpatialNetDriver::SaveViewCache()
+{
+	FSpatialViewCache::Save(ViewCacheFilePath, ViewCacheMapName, StaticComponentView, EntityRegistry);
+}
+
+void USpatialNetDriver::SaveViewCacheAsync()
+{
+	if (ViewCacheWriteTask.IsValid() && !ViewCacheWriteTask.IsReady())
+	{
+		UE_LOG(LogSpatialOSNetDriver, Verbose, TEXT("Skipping view cache save, the previous one is still being written."));
+		return;
+	}
+
+	TArray<uint8> SnapshotBytes = FSpatialViewCache::Snapshot(ViewCacheMapName, StaticComponentView, EntityRegistry);
+	ViewCacheWriteTask = Async<bool>(EAsyncExecution::ThreadPool, [FilePath = ViewCacheFilePath, SnapshotBytes = MoveTemp(SnapshotBytes)]()
+	{
+		return FSpatialViewCache::WriteToFile(FilePath, SnapshotBytes);
+	});
+}
+
+void USpatialNetDriver::ReleaseViewCache()
+{
+	if (!ViewCache.IsValid())
+	{
+		return;
+	}
+
+	StaticComponentView->SetWarmStartCache(nullptr);
+	ViewCache->LogValidationSummary();
+	ViewCache.Reset();
+}
+
 //SpatialGDK: Functions in the ifdef block below are modified versions of the UNetDriver:: implementations.
 #if WITH_SERVER_CODE
 
@@ -610,6 +754,13 @@ int32 USpatialNetDriver::ServerReplicateActors_PrioritizeActors(UNetConnection*
 				OutPriorityList[FinalSortedCount] = FActorPriority(PriorityConnection, Channel, ActorInfo, ConnectionViewers, bLowNetBandwidth);
 				OutPriorityActors[FinalSortedCount] = OutPriorityList + FinalSortedCount;
 
+				// Actors that were left over by the replication budget last tick add on the priority they had then, so they can't be starved.
+				int32 CarriedOverPriority;
+				if (CarriedOverPriorities.RemoveAndCopyValue(Actor, CarriedOverPriority))
+				{
+					OutPriorityList[FinalSortedCount].Priority = FMath::Min<int64>((int64)OutPriorityList[FinalSortedCount].Priority + CarriedOverPriority, MAX_int32);
+				}
+
 				FinalSortedCount++;
 
 				if (DebugRelevantActors)
@@ -640,7 +791,7 @@ int32 USpatialNetDriver::ServerReplicateActors_PrioritizeActors(UNetConnection*
 
 int32 USpatialNetDriver::ServerReplicateActors_ProcessPrioritizedActors(UNetConnection* InConnection, const TArray<FNetViewer>& ConnectionViewers, FActorPriority** PriorityActors, const int32 FinalSortedCount, int32& OutUpdated)
 {
-	if (!InConnection->IsNetReady(0))
+	if (!InConnection->IsNetReady(0) || IsReplicationBudgetSpent())
 	{
 		// Connection saturated, don't process any actors
 		return 0;
@@ -758,7 +909,11 @@ int32 USpatialNetDriver::ServerReplicateActors_ProcessPrioritizedActors(UNetConn
 							LastRelevantActors.Add(Actor);
 						}
 
-						if (Channel->ReplicateActor())
+						const int64 BitsWritten = Channel->ReplicateActor();
+						ReplicationBytesThisTick += BitsWritten / 8;
+						INC_DWORD_STAT_BY(STAT_SpatialReplicatedBytes, BitsWritten / 8);
+
+						if (BitsWritten > 0)
 						{
 							ActorUpdatesThisConnectionSent++;
 							if (DebugRelevantActors)
@@ -785,6 +940,12 @@ int32 USpatialNetDriver::ServerReplicateActors_ProcessPrioritizedActors(UNetConn
 						// We can bail out now since this connection is saturated, we'll return how far we got though
 						return j;
 					}
+
+					// The Spatial connection never saturates, the replication budget is what holds the remaining actors back.
+					if (IsReplicationBudgetSpent())
+					{
+						return j + 1;
+					}
 				}
 			}
 
@@ -805,6 +966,11 @@ int32 USpatialNetDriver::ServerReplicateActors_ProcessPrioritizedActors(UNetConn
 
 	return FinalSortedCount;
 }
+
+bool USpatialNetDriver::IsReplicationBudgetSpent() const
+{
+	return ReplicationBytesPerTick > 0 && ReplicationBytesThisTick >= ReplicationBytesPerTick;
+}
 #endif
 
 // SpatialGDK: This is a modified and simplified version of UNetDriver::ServerReplicateActors.
@@ -825,6 +991,10 @@ int32 USpatialNetDriver::ServerReplicateActors(float DeltaSeconds)
 	// Bump the ReplicationFrame value to invalidate any properties marked as "unchanged" for this frame.
 	ReplicationFrame++;
 
+	ReplicationBytesThisTick = 0;
+	CarriedOverPriorities = MoveTemp(DeferredPriorities);
+	DeferredPriorities.Reset();
+
 	const int32 NumClientsToTick = ServerReplicateActors_PrepConnections(DeltaSeconds);
 
 	//SpatialGDK: This is a formality as there is at least one "perfect" Spatial connection in our design.
@@ -916,6 +1086,9 @@ int32 USpatialNetDriver::ServerReplicateActors(float DeltaSeconds)
 			// Process the sorted list of actors for this connection
 			const int32 LastProcessedActor = ServerReplicateActors_ProcessPrioritizedActors(SpatialConnection, ConnectionViewers, PriorityActors, FinalSortedCount, Updated);
 
+			// Processing only stops early on a saturated connection or a spent budget, tell the two apart for the stats.
+			const bool bDeferredByBudget = IsReplicationBudgetSpent();
+
 			// relevant actors that could not be processed this frame are marked to be considered for next frame
 			for (int32 k = LastProcessedActor; k < FinalSortedCount; k++)
 			{
@@ -929,6 +1102,12 @@ int32 USpatialNetDriver::ServerReplicateActors(float DeltaSeconds)
 
 				UActorChannel* Channel = PriorityActors[k]->Channel;
 
+				DeferredPriorities.Add(Actor, PriorityActors[k]->Priority);
+				if (bDeferredByBudget)
+				{
+					INC_DWORD_STAT(STAT_SpatialActorsDeferredByBudget);
+				}
+
 				UE_LOG(LogNetTraffic, Verbose, TEXT("Saturated. %s"), *Actor->GetName());
 				if (Channel != NULL && Time - Channel->RelevantTime <= 1.f)
 				{
@@ -990,11 +1169,29 @@ void USpatialNetDriver::TickDispatch(float DeltaTime)
 
 	if (Connection != nullptr && Connection->IsConnected())
 	{
-		Worker_OpList* OpList = Connection->GetOpList();
+		// Ops left over from a tick that ran out of op processing budget are processed before new ones are pulled in,
+		// which also keeps a replayed recording from running ahead of the dispatcher.
+		if (!Dispatcher->HasPendingOps())
+		{
+			if (Connection->IsUsingOpListThread())
+			{
+				// The ingest thread has already pulled these off the connection, so only processing cost is paid here.
+				TArray<Worker_OpList*> OpLists;
+				Connection->DequeueOpLists(OpLists);
 
-		Dispatcher->ProcessOps(OpList);
+				for (Worker_OpList* OpList : OpLists)
+				{
+					Dispatcher->QueueOpList(OpList);
+				}
+			}
+			else
+			{
+				Dispatcher->QueueOpList(Connection->GetOpList());
+			}
+		}
 
-		Worker_OpList_Destroy(OpList);
+		SCOPE_CYCLE_COUNTER(STAT_SpatialProcessOps);
+		Dispatcher->ProcessOps();
 	}
 }
 
@@ -1035,12 +1232,18 @@ void USpatialNetDriver::ProcessRemoteFunction(
 
 	if (Function->FunctionFlags & FUNC_Net)
 	{
-		Sender->SendRPC(MakeShared<FPendingRPCParams>(CallingObject, Function, Parameters));
+		Sender->SendRPC(Sender->CreateRPCParams(CallingObject, Function, Parameters));
 	}
 }
 
 void USpatialNetDriver::TickFlush(float DeltaTime)
 {
+	// RPCs called this frame go out ahead of the property updates replicated below, as they would without batching.
+	if (Sender != nullptr)
+	{
+		Sender->FlushRPCBatches();
+	}
+
 	// Super::TickFlush() will not call ReplicateActors() because Spatial connections have InternalAck set to true.
 	// In our case, our Spatial actor interop is triggered through ReplicateActors() so we want to call it regardless.
 
@@ -1072,9 +1275,28 @@ void USpatialNetDriver::TickFlush(float DeltaTime)
 #endif // WITH_SERVER_CODE
 	}
 
+	if (Sender != nullptr)
+	{
+		Sender->FlushComponentUpdates();
+		// Anything batched while replicating.
+		Sender->FlushRPCBatches();
+		Sender->FlushRingBufferRPCs();
+	}
+
 	Super::TickFlush(DeltaTime);
 }
 
+const FSpatialTransformReplicationSettings& USpatialNetDriver::GetTransformReplicationSettings(const UClass* ActorClass) const
+{
+	if (ReplicationSettings != nullptr)
+	{
+		return ReplicationSettings->GetTransformSettings(ActorClass);
+	}
+
+	static const FSpatialTransformReplicationSettings DefaultSettings;
+	return DefaultSettings;
+}
+
 USpatialNetConnection * USpatialNetDriver::GetSpatialOSNetConnection() const
 {
 	if (ServerConnection)
@@ -1195,10 +1417,114 @@ bool USpatialNetDriver::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& A
 	{
 		return HandleNetDumpCrossServerRPCCommand(Cmd, Ar);
 	}
+	else if (FParse::Command(&Cmd, TEXT("SPATIALRECORDOPS")))
+	{
+		return HandleRecordOpsCommand(Cmd, Ar);
+	}
+	else if (FParse::Command(&Cmd, TEXT("SPATIALOPSTATS")))
+	{
+		return HandleOpStatsCommand(Cmd, Ar);
+	}
+	else if (FParse::Command(&Cmd, TEXT("SPATIALVIEWBENCH")))
+	{
+		return HandleViewBenchmarkCommand(Cmd, Ar);
+	}
 #endif // !UE_BUILD_SHIPPING
 	return UNetDriver::Exec(InWorld, Cmd, Ar);
 }
 
+#if !UE_BUILD_SHIPPING
+// Usage: SPATIALRECORDOPS [FilePath] to start recording, SPATIALRECORDOPS STOP to stop.
+// The recording can be replayed offline by launching a worker with -replayOpListFile <FilePath>.
+bool USpatialNetDriver::HandleRecordOpsCommand(const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	if (Dispatcher == nullptr)
+	{
+		Ar.Logf(TEXT("Not connected to SpatialOS yet, nothing to record."));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("STOP")))
+	{
+		Dispatcher->StopRecording();
+		return true;
+	}
+
+	FString FilePath = FParse::Token(Cmd, false);
+	if (FilePath.IsEmpty())
+	{
+		FilePath = FPaths::ProjectSavedDir() / FString::Printf(TEXT("OpLists-%s.bin"), *FDateTime::Now().ToString());
+	}
+
+	if (!Dispatcher->StartRecording(FilePath))
+	{
+		Ar.Logf(TEXT("Failed to start recording op lists to %s"), *FilePath);
+	}
+
+	return true;
+}
+#endif // !UE_BUILD_SHIPPING
+
+#if !UE_BUILD_SHIPPING
+// Usage: SPATIALOPSTATS to dump per-op-type processing times, SPATIALOPSTATS RESET to start a new measurement window.
+bool USpatialNetDriver::HandleOpStatsCommand(const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	if (Dispatcher == nullptr)
+	{
+		Ar.Logf(TEXT("Not connected to SpatialOS yet, no ops have been processed."));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("RESET")))
+	{
+		Dispatcher->GetOpStats().Reset();
+		return true;
+	}
+
+	Dispatcher->GetOpStats().Dump(Ar);
+	return true;
+}
+
+// Usage: SPATIALVIEWBENCH [NumEntities] [NumIterations] for the lookup benchmark,
+// SPATIALVIEWBENCH SOAK [NumCycles] [NumLiveEntities] for the entity churn soak,
+// SPATIALVIEWBENCH PENDINGADD [NumEntities] [NumComponentsPerEntity] for the critical section component buffer.
+bool USpatialNetDriver::HandleViewBenchmarkCommand(const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	if (FParse::Command(&Cmd, TEXT("SOAK")))
+	{
+		const FString NumCyclesString = FParse::Token(Cmd, false);
+		const FString NumLiveEntitiesString = FParse::Token(Cmd, false);
+
+		const int32 NumCycles = NumCyclesString.IsEmpty() ? 5000000 : FCString::Atoi(*NumCyclesString);
+		const int32 NumLiveEntities = NumLiveEntitiesString.IsEmpty() ? 10000 : FCString::Atoi(*NumLiveEntitiesString);
+
+		USpatialStaticComponentView::RunChurnSoak(FMath::Max(NumCycles, 1), FMath::Max(NumLiveEntities, 1), Ar);
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("PENDINGADD")))
+	{
+		const FString NumEntitiesString = FParse::Token(Cmd, false);
+		const FString NumComponentsString = FParse::Token(Cmd, false);
+
+		const int32 NumEntities = NumEntitiesString.IsEmpty() ? 50000 : FCString::Atoi(*NumEntitiesString);
+		const int32 NumComponents = NumComponentsString.IsEmpty() ? 8 : FCString::Atoi(*NumComponentsString);
+
+		FPendingAddComponentBuffer::RunBenchmark(FMath::Max(NumEntities, 1), FMath::Max(NumComponents, 1), Ar);
+		return true;
+	}
+
+	const FString NumEntitiesString = FParse::Token(Cmd, false);
+	const FString NumIterationsString = FParse::Token(Cmd, false);
+
+	const int32 NumEntities = NumEntitiesString.IsEmpty() ? 30000 : FCString::Atoi(*NumEntitiesString);
+	const int32 NumIterations = NumIterationsString.IsEmpty() ? 10 : FCString::Atoi(*NumIterationsString);
+
+	USpatialStaticComponentView::RunLookupBenchmark(FMath::Max(NumEntities, 1), FMath::Max(NumIterations, 1), Ar);
+	return true;
+}
+#endif // !UE_BUILD_SHIPPING
+
 // This function is literally a copy paste of UNetDriver::HandleNetDumpServerRPCCommand. Didn't want to refactor to avoid divergence from engine.
 #if !UE_BUILD_SHIPPING
 bool USpatialNetDriver::HandleNetDumpCrossServerRPCCommand(const TCHAR* Cmd, FOutputDevice& Ar)
@@ -1331,6 +1657,9 @@ void USpatialPendingNetGame::SendJoin()
 void USpatialNetDriver::AddActorChannel(Worker_EntityId EntityId, USpatialActorChannel* Channel)
 {
 	EntityToActorChannel.Add(EntityId, Channel);
+
+	// The channel may have become ready for replication.
+	MarkOwnershipDirty(Channel);
 }
 
 void USpatialNetDriver::RemoveActorChannel(Worker_EntityId EntityId)
@@ -1349,6 +1678,112 @@ USpatialActorChannel* USpatialNetDriver::GetActorChannelByEntityId(Worker_Entity
 	return EntityToActorChannel.FindRef(EntityId);
 }
 
+void USpatialNetDriver::MarkOwnershipDirty(USpatialActorChannel* Channel)
+{
+	OwnershipDirtyChannels.Add(Channel);
+}
+
+void USpatialNetDriver::OnChannelOwnerChanged(USpatialActorChannel* Channel, const TWeakObjectPtr<AActor>& OldOwner, AActor* NewOwner)
+{
+	if (OldOwner != TWeakObjectPtr<AActor>(NewOwner))
+	{
+		if (TSet<USpatialActorChannel*>* OwnedChannels = ChannelsByOwner.Find(OldOwner))
+		{
+			OwnedChannels->Remove(Channel);
+			if (OwnedChannels->Num() == 0)
+			{
+				ChannelsByOwner.Remove(OldOwner);
+			}
+		}
+
+		if (NewOwner != nullptr)
+		{
+			ChannelsByOwner.FindOrAdd(NewOwner).Add(Channel);
+		}
+	}
+
+	MarkOwnershipDirty(Channel);
+}
+
+void USpatialNetDriver::RemoveOwnershipTracking(USpatialActorChannel* Channel, const TWeakObjectPtr<AActor>& Owner)
+{
+	OwnershipDirtyChannels.Remove(Channel);
+
+	if (TSet<USpatialActorChannel*>* OwnedChannels = ChannelsByOwner.Find(Owner))
+	{
+		OwnedChannels->Remove(Channel);
+		if (OwnedChannels->Num() == 0)
+		{
+			ChannelsByOwner.Remove(Owner);
+		}
+	}
+}
+
+void USpatialNetDriver::ProcessOwnershipChanges()
+{
+	const double Now = FPlatformTime::Seconds();
+	if (Now - LastOwnershipSweepTime >= SpatialConstants::OWNERSHIP_SWEEP_INTERVAL_SECONDS)
+	{
+		LastOwnershipSweepTime = Now;
+
+		for (const auto& Pair : EntityToActorChannel)
+		{
+			Pair.Value->CheckOwnershipChanged();
+		}
+
+		// Owners that were garbage collected have had their channels moved to a new owner by the checks above.
+		for (auto It = ChannelsByOwner.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	if (OwnershipDirtyChannels.Num() == 0)
+	{
+		SET_DWORD_STAT(STAT_SpatialOwnershipChannelsTicked, 0);
+		return;
+	}
+
+	TArray<USpatialActorChannel*> ChannelsToTick = OwnershipDirtyChannels.Array();
+	TSet<USpatialActorChannel*> VisitedChannels(OwnershipDirtyChannels);
+	OwnershipDirtyChannels.Reset();
+
+	// ChannelsToTick grows while iterating: when an actor's net ownership flips, so does the ownership of every actor it owns.
+	for (int32 i = 0; i < ChannelsToTick.Num(); i++)
+	{
+		USpatialActorChannel* Channel = ChannelsToTick[i];
+
+		const bool bOldNetOwned = Channel->IsNetOwned();
+		if (Channel->SpatialViewTick())
+		{
+			// Updating the ACLs failed, try again next tick.
+			OwnershipDirtyChannels.Add(Channel);
+		}
+
+		if (bOldNetOwned == Channel->IsNetOwned() || Channel->Actor == nullptr)
+		{
+			continue;
+		}
+
+		if (TSet<USpatialActorChannel*>* OwnedChannels = ChannelsByOwner.Find(TWeakObjectPtr<AActor>(Channel->Actor)))
+		{
+			for (USpatialActorChannel* OwnedChannel : *OwnedChannels)
+			{
+				if (!VisitedChannels.Contains(OwnedChannel))
+				{
+					VisitedChannels.Add(OwnedChannel);
+					ChannelsToTick.Add(OwnedChannel);
+				}
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SpatialOwnershipChannelsTicked, ChannelsToTick.Num());
+}
+
 void USpatialNetDriver::WipeWorld(const USpatialNetDriver::PostWorldWipeDelegate& LoadSnapshotAfterWorldWipe)
 {
 	if (Cast<USpatialGameInstance>(GetWorld()->GetGameInstance())->bResponsibleForSnapshotLoading)
@@ -0,0 +1,16 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "EngineClasses/SpatialReplicationSettings.h"
+
+const FSpatialTransformReplicationSettings& USpatialReplicationSettings::GetTransformSettings(const UClass* ActorClass) const
+{
+	for (const UClass* Class = ActorClass; Class != nullptr; Class = Class->GetSuperClass())
+	{
+		if (const FSpatialTransformReplicationSettings* Settings = ClassTransformSettings.Find(const_cast<UClass*>(Class)))
+		{
+			return *Settings;
+		}
+	}
+
+	return DefaultTransformSettings;
+}
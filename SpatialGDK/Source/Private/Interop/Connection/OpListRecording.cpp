@@ -0,0 +1,743 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "Interop/Connection/OpListRecording.h"
+
+#include "HAL/FileManager.h"
+#include "Serialization/Archive.h"
+
+DEFINE_LOG_CATEGORY(LogSpatialOpListRecording);
+
+namespace
+{
+	// "SOPL" in little endian.
+	const uint32 OP_LIST_FILE_MAGIC = 0x4C504F53;
+	const uint32 OP_LIST_FILE_VERSION = 1;
+}
+
+FOpListRecorder::~FOpListRecorder()
+{
+	Close();
+}
+
+bool FOpListRecorder::Open(const FString& FilePath, const FString& WorkerId)
+{
+	Close();
+
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!Writer.IsValid())
+	{
+		UE_LOG(LogSpatialOpListRecording, Error, TEXT("Could not open %s for op list recording."), *FilePath);
+		return false;
+	}
+
+	RecordingPath = FilePath;
+	StartTime = FPlatformTime::Seconds();
+	NumOpListsRecorded = 0;
+	NumOpsRecorded = 0;
+
+	uint32 Magic = OP_LIST_FILE_MAGIC;
+	uint32 Version = OP_LIST_FILE_VERSION;
+	*Writer << Magic;
+	*Writer << Version;
+	WriteString(TCHAR_TO_UTF8(*WorkerId));
+
+	UE_LOG(LogSpatialOpListRecording, Log, TEXT("Started recording op lists to %s"), *FilePath);
+	return true;
+}
+
+void FOpListRecorder::Close()
+{
+	if (!Writer.IsValid())
+	{
+		return;
+	}
+
+	Writer->Close();
+	Writer.Reset();
+
+	UE_LOG(LogSpatialOpListRecording, Log, TEXT("Stopped recording op lists to %s. Recorded %u op lists, %llu ops."), *RecordingPath, NumOpListsRecorded, NumOpsRecorded);
+}
+
+void FOpListRecorder::RecordOpList(const Worker_OpList* OpList)
+{
+	if (!Writer.IsValid())
+	{
+		return;
+	}
+
+	uint32 NumOps = 0;
+	for (size_t i = 0; i < OpList->op_count; ++i)
+	{
+		if (OpList->ops[i].op_type != WORKER_OP_TYPE_METRICS)
+		{
+			NumOps++;
+		}
+	}
+
+	double Timestamp = FPlatformTime::Seconds() - StartTime;
+	*Writer << Timestamp;
+	*Writer << NumOps;
+
+	for (size_t i = 0; i < OpList->op_count; ++i)
+	{
+		if (OpList->ops[i].op_type != WORKER_OP_TYPE_METRICS)
+		{
+			WriteOp(OpList->ops[i]);
+		}
+	}
+
+	NumOpListsRecorded++;
+	NumOpsRecorded += NumOps;
+
+	if (Writer->IsError())
+	{
+		UE_LOG(LogSpatialOpListRecording, Error, TEXT("Failed writing to %s, stopping op list recording."), *RecordingPath);
+		Close();
+	}
+}
+
+void FOpListRecorder::WriteOp(const Worker_Op& Op)
+{
+	uint8 OpType = Op.op_type;
+	*Writer << OpType;
+
+	switch (Op.op_type)
+	{
+	case WORKER_OP_TYPE_DISCONNECT:
+		WriteString(Op.disconnect.reason);
+		break;
+	case WORKER_OP_TYPE_FLAG_UPDATE:
+		WriteString(Op.flag_update.name);
+		WriteString(Op.flag_update.value);
+		break;
+	case WORKER_OP_TYPE_LOG_MESSAGE:
+	{
+		uint8 Level = Op.log_message.level;
+		*Writer << Level;
+		WriteString(Op.log_message.message);
+		break;
+	}
+	case WORKER_OP_TYPE_CRITICAL_SECTION:
+	{
+		uint8 bInCriticalSection = Op.critical_section.in_critical_section;
+		*Writer << bInCriticalSection;
+		break;
+	}
+	case WORKER_OP_TYPE_ADD_ENTITY:
+		WriteEntityId(Op.add_entity.entity_id);
+		break;
+	case WORKER_OP_TYPE_REMOVE_ENTITY:
+		WriteEntityId(Op.remove_entity.entity_id);
+		break;
+	case WORKER_OP_TYPE_RESERVE_ENTITY_ID_RESPONSE:
+	{
+		uint8 StatusCode = Op.reserve_entity_id_response.status_code;
+		WriteRequestId(Op.reserve_entity_id_response.request_id);
+		*Writer << StatusCode;
+		WriteString(Op.reserve_entity_id_response.message);
+		WriteEntityId(Op.reserve_entity_id_response.entity_id);
+		break;
+	}
+	case WORKER_OP_TYPE_RESERVE_ENTITY_IDS_RESPONSE:
+	{
+		uint8 StatusCode = Op.reserve_entity_ids_response.status_code;
+		uint32 NumberOfEntityIds = Op.reserve_entity_ids_response.number_of_entity_ids;
+		WriteRequestId(Op.reserve_entity_ids_response.request_id);
+		*Writer << StatusCode;
+		WriteString(Op.reserve_entity_ids_response.message);
+		WriteEntityId(Op.reserve_entity_ids_response.first_entity_id);
+		*Writer << NumberOfEntityIds;
+		break;
+	}
+	case WORKER_OP_TYPE_CREATE_ENTITY_RESPONSE:
+	{
+		uint8 StatusCode = Op.create_entity_response.status_code;
+		WriteRequestId(Op.create_entity_response.request_id);
+		*Writer << StatusCode;
+		WriteString(Op.create_entity_response.message);
+		WriteEntityId(Op.create_entity_response.entity_id);
+		break;
+	}
+	case WORKER_OP_TYPE_DELETE_ENTITY_RESPONSE:
+	{
+		uint8 StatusCode = Op.delete_entity_response.status_code;
+		WriteRequestId(Op.delete_entity_response.request_id);
+		WriteEntityId(Op.delete_entity_response.entity_id);
+		*Writer << StatusCode;
+		WriteString(Op.delete_entity_response.message);
+		break;
+	}
+	case WORKER_OP_TYPE_ENTITY_QUERY_RESPONSE:
+	{
+		const Worker_EntityQueryResponseOp& Response = Op.entity_query_response;
+		uint8 StatusCode = Response.status_code;
+		uint32 ResultCount = Response.result_count;
+		// Snapshot queries carry their results, count queries only carry result_count.
+		uint8 bHasResults = Response.results != nullptr;
+		WriteRequestId(Response.request_id);
+		*Writer << StatusCode;
+		WriteString(Response.message);
+		*Writer << ResultCount;
+		*Writer << bHasResults;
+		if (bHasResults)
+		{
+			for (uint32 i = 0; i < ResultCount; i++)
+			{
+				const Worker_Entity& Entity = Response.results[i];
+				uint32 ComponentCount = Entity.component_count;
+				WriteEntityId(Entity.entity_id);
+				*Writer << ComponentCount;
+				for (uint32 j = 0; j < ComponentCount; j++)
+				{
+					WriteComponentData(Entity.components[j]);
+				}
+			}
+		}
+		break;
+	}
+	case WORKER_OP_TYPE_ADD_COMPONENT:
+		WriteEntityId(Op.add_component.entity_id);
+		WriteComponentData(Op.add_component.data);
+		break;
+	case WORKER_OP_TYPE_REMOVE_COMPONENT:
+	{
+		uint32 ComponentId = Op.remove_component.component_id;
+		WriteEntityId(Op.remove_component.entity_id);
+		*Writer << ComponentId;
+		break;
+	}
+	case WORKER_OP_TYPE_AUTHORITY_CHANGE:
+	{
+		uint32 ComponentId = Op.authority_change.component_id;
+		uint8 Authority = Op.authority_change.authority;
+		WriteEntityId(Op.authority_change.entity_id);
+		*Writer << ComponentId;
+		*Writer << Authority;
+		break;
+	}
+	case WORKER_OP_TYPE_COMPONENT_UPDATE:
+		WriteEntityId(Op.component_update.entity_id);
+		WriteComponentUpdate(Op.component_update.update);
+		break;
+	case WORKER_OP_TYPE_COMMAND_REQUEST:
+	{
+		const Worker_CommandRequestOp& Request = Op.command_request;
+		uint32 TimeoutMillis = Request.timeout_millis;
+		uint32 AttributeCount = Request.caller_attribute_set.attribute_count;
+		uint32 ComponentId = Request.request.component_id;
+		uint32 CommandIndex = Schema_GetCommandRequestCommandIndex(Request.request.schema_type);
+		WriteRequestId(Request.request_id);
+		WriteEntityId(Request.entity_id);
+		*Writer << TimeoutMillis;
+		WriteString(Request.caller_worker_id);
+		*Writer << AttributeCount;
+		for (uint32 i = 0; i < AttributeCount; i++)
+		{
+			WriteString(Request.caller_attribute_set.attributes[i]);
+		}
+		*Writer << ComponentId;
+		*Writer << CommandIndex;
+		WriteSchemaObject(Schema_GetCommandRequestObject(Request.request.schema_type));
+		break;
+	}
+	case WORKER_OP_TYPE_COMMAND_RESPONSE:
+	{
+		const Worker_CommandResponseOp& Response = Op.command_response;
+		uint8 StatusCode = Response.status_code;
+		uint32 CommandId = Response.command_id;
+		uint32 ComponentId = Response.response.component_id;
+		// Failed commands don't carry a response object.
+		uint8 bHasResponse = Response.response.schema_type != nullptr;
+		WriteRequestId(Response.request_id);
+		WriteEntityId(Response.entity_id);
+		*Writer << StatusCode;
+		WriteString(Response.message);
+		*Writer << CommandId;
+		*Writer << ComponentId;
+		*Writer << bHasResponse;
+		if (bHasResponse)
+		{
+			WriteSchemaObject(Schema_GetCommandResponseObject(Response.response.schema_type));
+		}
+		break;
+	}
+	default:
+		checkf(false, TEXT("Unexpected op type %d while recording op list."), Op.op_type);
+		break;
+	}
+}
+
+void FOpListRecorder::WriteString(const char* String)
+{
+	uint32 Length = String != nullptr ? FCStringAnsi::Strlen(String) : 0;
+	*Writer << Length;
+	if (Length > 0)
+	{
+		Writer->Serialize(const_cast<char*>(String), Length);
+	}
+}
+
+void FOpListRecorder::WriteEntityId(Worker_EntityId EntityId)
+{
+	int64 Value = EntityId;
+	*Writer << Value;
+}
+
+void FOpListRecorder::WriteRequestId(Worker_RequestId RequestId)
+{
+	uint32 Value = RequestId;
+	*Writer << Value;
+}
+
+void FOpListRecorder::WriteSchemaObject(Schema_Object* Object)
+{
+	uint32 Length = Schema_GetWriteBufferLength(Object);
+	ScratchBuffer.SetNumUninitialized(Length, false);
+	Schema_WriteToBuffer(Object, ScratchBuffer.GetData());
+
+	*Writer << Length;
+	Writer->Serialize(ScratchBuffer.GetData(), Length);
+}
+
+void FOpListRecorder::WriteComponentData(const Worker_ComponentData& Data)
+{
+	uint32 ComponentId = Data.component_id;
+	*Writer << ComponentId;
+	WriteSchemaObject(Schema_GetComponentDataFields(Data.schema_type));
+}
+
+void FOpListRecorder::WriteComponentUpdate(const Worker_ComponentUpdate& Update)
+{
+	uint32 ComponentId = Update.component_id;
+	*Writer << ComponentId;
+	WriteSchemaObject(Schema_GetComponentUpdateFields(Update.schema_type));
+	WriteSchemaObject(Schema_GetComponentUpdateEvents(Update.schema_type));
+
+	TArray<Schema_FieldId> ClearedIds;
+	ClearedIds.SetNum(Schema_GetComponentUpdateClearedFieldCount(Update.schema_type));
+	Schema_GetComponentUpdateClearedFieldList(Update.schema_type, ClearedIds.GetData());
+
+	uint32 ClearedCount = ClearedIds.Num();
+	*Writer << ClearedCount;
+	for (Schema_FieldId& Id : ClearedIds)
+	{
+		*Writer << Id;
+	}
+}
+
+FOpListReplayer::~FOpListReplayer()
+{
+	ReleaseOpList();
+}
+
+bool FOpListReplayer::Open(const FString& FilePath)
+{
+	ReleaseOpList();
+
+	Reader.Reset(IFileManager::Get().CreateFileReader(*FilePath));
+	if (!Reader.IsValid())
+	{
+		UE_LOG(LogSpatialOpListRecording, Error, TEXT("Could not open op list recording %s."), *FilePath);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*Reader << Magic;
+	*Reader << Version;
+
+	if (Magic != OP_LIST_FILE_MAGIC || Version != OP_LIST_FILE_VERSION)
+	{
+		UE_LOG(LogSpatialOpListRecording, Error, TEXT("%s is not an op list recording or was written by an incompatible version (version %u, expected %u)."), *FilePath, Version, OP_LIST_FILE_VERSION);
+		Reader.Reset();
+		return false;
+	}
+
+	RecordedWorkerId = UTF8_TO_TCHAR(ReadString());
+	Strings.Empty();
+
+	bFinished = false;
+	NumOpListsReplayed = 0;
+	NumOpsReplayed = 0;
+	LastRecordedTime = 0.0;
+
+	UE_LOG(LogSpatialOpListRecording, Log, TEXT("Replaying op lists from %s, recorded by worker %s"), *FilePath, *RecordedWorkerId);
+	return true;
+}
+
+Worker_OpList* FOpListReplayer::ReadNextOpList()
+{
+	ReleaseOpList();
+
+	if (!Reader.IsValid() || bFinished)
+	{
+		return nullptr;
+	}
+
+	if (Reader->AtEnd())
+	{
+		bFinished = true;
+		return nullptr;
+	}
+
+	uint32 NumOps = 0;
+	*Reader << LastRecordedTime;
+	*Reader << NumOps;
+
+	Ops.SetNumZeroed(NumOps);
+	for (uint32 i = 0; i < NumOps; i++)
+	{
+		if (!ReadOp(Ops[i]) || Reader->IsError())
+		{
+			UE_LOG(LogSpatialOpListRecording, Error, TEXT("Op list recording is truncated or corrupt after %u op lists, stopping replay."), NumOpListsReplayed);
+			ReleaseOpList();
+			bFinished = true;
+			return nullptr;
+		}
+	}
+
+	NumOpListsReplayed++;
+	NumOpsReplayed += NumOps;
+
+	CurrentOpList.ops = Ops.GetData();
+	CurrentOpList.op_count = NumOps;
+	return &CurrentOpList;
+}
+
+void FOpListReplayer::ReleaseOpList()
+{
+	for (Schema_ComponentData* Data : SchemaComponentDatas)
+	{
+		Schema_DestroyComponentData(Data);
+	}
+	for (Schema_ComponentUpdate* Update : SchemaComponentUpdates)
+	{
+		Schema_DestroyComponentUpdate(Update);
+	}
+	for (Schema_CommandRequest* Request : SchemaCommandRequests)
+	{
+		Schema_DestroyCommandRequest(Request);
+	}
+	for (Schema_CommandResponse* Response : SchemaCommandResponses)
+	{
+		Schema_DestroyCommandResponse(Response);
+	}
+
+	// Reset keeps the allocations around for the next op list.
+	SchemaComponentDatas.Reset();
+	SchemaComponentUpdates.Reset();
+	SchemaCommandRequests.Reset();
+	SchemaCommandResponses.Reset();
+	Ops.Reset();
+	Strings.Reset();
+	AttributeSets.Reset();
+	QueryResults.Reset();
+	QueryComponents.Reset();
+
+	CurrentOpList.ops = nullptr;
+	CurrentOpList.op_count = 0;
+}
+
+bool FOpListReplayer::ReadOp(Worker_Op& Op)
+{
+	uint8 OpType = 0;
+	*Reader << OpType;
+	Op.op_type = OpType;
+
+	switch (OpType)
+	{
+	case WORKER_OP_TYPE_DISCONNECT:
+		Op.disconnect.reason = ReadString();
+		return true;
+	case WORKER_OP_TYPE_FLAG_UPDATE:
+		Op.flag_update.name = ReadString();
+		Op.flag_update.value = ReadString();
+		return true;
+	case WORKER_OP_TYPE_LOG_MESSAGE:
+	{
+		uint8 Level = 0;
+		*Reader << Level;
+		Op.log_message.level = Level;
+		Op.log_message.message = ReadString();
+		return true;
+	}
+	case WORKER_OP_TYPE_CRITICAL_SECTION:
+	{
+		uint8 bInCriticalSection = 0;
+		*Reader << bInCriticalSection;
+		Op.critical_section.in_critical_section = bInCriticalSection;
+		return true;
+	}
+	case WORKER_OP_TYPE_ADD_ENTITY:
+		Op.add_entity.entity_id = ReadEntityId();
+		return true;
+	case WORKER_OP_TYPE_REMOVE_ENTITY:
+		Op.remove_entity.entity_id = ReadEntityId();
+		return true;
+	case WORKER_OP_TYPE_RESERVE_ENTITY_ID_RESPONSE:
+	{
+		uint8 StatusCode = 0;
+		Op.reserve_entity_id_response.request_id = ReadRequestId();
+		*Reader << StatusCode;
+		Op.reserve_entity_id_response.status_code = StatusCode;
+		Op.reserve_entity_id_response.message = ReadString();
+		Op.reserve_entity_id_response.entity_id = ReadEntityId();
+		return true;
+	}
+	case WORKER_OP_TYPE_RESERVE_ENTITY_IDS_RESPONSE:
+	{
+		uint8 StatusCode = 0;
+		uint32 NumberOfEntityIds = 0;
+		Op.reserve_entity_ids_response.request_id = ReadRequestId();
+		*Reader << StatusCode;
+		Op.reserve_entity_ids_response.status_code = StatusCode;
+		Op.reserve_entity_ids_response.message = ReadString();
+		Op.reserve_entity_ids_response.first_entity_id = ReadEntityId();
+		*Reader << NumberOfEntityIds;
+		Op.reserve_entity_ids_response.number_of_entity_ids = NumberOfEntityIds;
+		return true;
+	}
+	case WORKER_OP_TYPE_CREATE_ENTITY_RESPONSE:
+	{
+		uint8 StatusCode = 0;
+		Op.create_entity_response.request_id = ReadRequestId();
+		*Reader << StatusCode;
+		Op.create_entity_response.status_code = StatusCode;
+		Op.create_entity_response.message = ReadString();
+		Op.create_entity_response.entity_id = ReadEntityId();
+		return true;
+	}
+	case WORKER_OP_TYPE_DELETE_ENTITY_RESPONSE:
+	{
+		uint8 StatusCode = 0;
+		Op.delete_entity_response.request_id = ReadRequestId();
+		Op.delete_entity_response.entity_id = ReadEntityId();
+		*Reader << StatusCode;
+		Op.delete_entity_response.status_code = StatusCode;
+		Op.delete_entity_response.message = ReadString();
+		return true;
+	}
+	case WORKER_OP_TYPE_ENTITY_QUERY_RESPONSE:
+	{
+		Worker_EntityQueryResponseOp& Response = Op.entity_query_response;
+		uint8 StatusCode = 0;
+		uint32 ResultCount = 0;
+		uint8 bHasResults = 0;
+		Response.request_id = ReadRequestId();
+		*Reader << StatusCode;
+		Response.status_code = StatusCode;
+		Response.message = ReadString();
+		*Reader << ResultCount;
+		*Reader << bHasResults;
+		Response.result_count = ResultCount;
+		Response.results = nullptr;
+
+		if (bHasResults)
+		{
+			TArray<Worker_Entity>& Results = QueryResults[QueryResults.AddDefaulted()];
+			Results.SetNumZeroed(ResultCount);
+			for (Worker_Entity& Entity : Results)
+			{
+				uint32 ComponentCount = 0;
+				Entity.entity_id = ReadEntityId();
+				*Reader << ComponentCount;
+
+				TArray<Worker_ComponentData>& Components = QueryComponents[QueryComponents.AddDefaulted()];
+				Components.SetNumZeroed(ComponentCount);
+				for (Worker_ComponentData& Data : Components)
+				{
+					if (!ReadComponentData(Data))
+					{
+						return false;
+					}
+				}
+
+				Entity.component_count = ComponentCount;
+				Entity.components = Components.GetData();
+			}
+			Response.results = Results.GetData();
+		}
+		return true;
+	}
+	case WORKER_OP_TYPE_ADD_COMPONENT:
+		Op.add_component.entity_id = ReadEntityId();
+		return ReadComponentData(Op.add_component.data);
+	case WORKER_OP_TYPE_REMOVE_COMPONENT:
+	{
+		uint32 ComponentId = 0;
+		Op.remove_component.entity_id = ReadEntityId();
+		*Reader << ComponentId;
+		Op.remove_component.component_id = ComponentId;
+		return true;
+	}
+	case WORKER_OP_TYPE_AUTHORITY_CHANGE:
+	{
+		uint32 ComponentId = 0;
+		uint8 Authority = 0;
+		Op.authority_change.entity_id = ReadEntityId();
+		*Reader << ComponentId;
+		*Reader << Authority;
+		Op.authority_change.component_id = ComponentId;
+		Op.authority_change.authority = Authority;
+		return true;
+	}
+	case WORKER_OP_TYPE_COMPONENT_UPDATE:
+		Op.component_update.entity_id = ReadEntityId();
+		return ReadComponentUpdate(Op.component_update.update);
+	case WORKER_OP_TYPE_COMMAND_REQUEST:
+	{
+		Worker_CommandRequestOp& Request = Op.command_request;
+		uint32 TimeoutMillis = 0;
+		uint32 AttributeCount = 0;
+		uint32 ComponentId = 0;
+		uint32 CommandIndex = 0;
+		Request.request_id = ReadRequestId();
+		Request.entity_id = ReadEntityId();
+		*Reader << TimeoutMillis;
+		Request.timeout_millis = TimeoutMillis;
+		Request.caller_worker_id = ReadString();
+		*Reader << AttributeCount;
+
+		TArray<const char*>& Attributes = AttributeSets[AttributeSets.AddDefaulted()];
+		Attributes.SetNumZeroed(AttributeCount);
+		for (const char*& Attribute : Attributes)
+		{
+			Attribute = ReadString();
+		}
+		Request.caller_attribute_set.attribute_count = AttributeCount;
+		Request.caller_attribute_set.attributes = Attributes.GetData();
+
+		*Reader << ComponentId;
+		*Reader << CommandIndex;
+		Request.request.component_id = ComponentId;
+		Request.request.schema_type = Schema_CreateCommandRequest(ComponentId, CommandIndex);
+		SchemaCommandRequests.Add(Request.request.schema_type);
+		return ReadSchemaObject(Schema_GetCommandRequestObject(Request.request.schema_type));
+	}
+	case WORKER_OP_TYPE_COMMAND_RESPONSE:
+	{
+		Worker_CommandResponseOp& Response = Op.command_response;
+		uint8 StatusCode = 0;
+		uint32 CommandId = 0;
+		uint32 ComponentId = 0;
+		uint8 bHasResponse = 0;
+		Response.request_id = ReadRequestId();
+		Response.entity_id = ReadEntityId();
+		*Reader << StatusCode;
+		Response.status_code = StatusCode;
+		Response.message = ReadString();
+		*Reader << CommandId;
+		*Reader << ComponentId;
+		*Reader << bHasResponse;
+		Response.command_id = CommandId;
+		Response.response.component_id = ComponentId;
+		Response.response.schema_type = nullptr;
+
+		if (bHasResponse)
+		{
+			Response.response.schema_type = Schema_CreateCommandResponse(ComponentId, CommandId);
+			SchemaCommandResponses.Add(Response.response.schema_type);
+			return ReadSchemaObject(Schema_GetCommandResponseObject(Response.response.schema_type));
+		}
+		return true;
+	}
+	default:
+		UE_LOG(LogSpatialOpListRecording, Error, TEXT("Unknown op type %d in op list recording."), OpType);
+		return false;
+	}
+}
+
+const char* FOpListReplayer::ReadString()
+{
+	uint32 Length = 0;
+	*Reader << Length;
+
+	if (Length > Reader->TotalSize() - Reader->Tell())
+	{
+		Reader->SetError();
+		Length = 0;
+	}
+
+	// The outer array may reallocate, but moving a TArray keeps its heap allocation, so handed out pointers stay valid.
+	TArray<ANSICHAR>& String = Strings[Strings.AddDefaulted()];
+	String.SetNumUninitialized(Length + 1);
+	if (Length > 0)
+	{
+		Reader->Serialize(String.GetData(), Length);
+	}
+	String[Length] = '\0';
+
+	return String.GetData();
+}
+
+Worker_EntityId FOpListReplayer::ReadEntityId()
+{
+	int64 Value = 0;
+	*Reader << Value;
+	return Value;
+}
+
+Worker_RequestId FOpListReplayer::ReadRequestId()
+{
+	uint32 Value = 0;
+	*Reader << Value;
+	return Value;
+}
+
+bool FOpListReplayer::ReadSchemaObject(Schema_Object* Object)
+{
+	uint32 Length = 0;
+	*Reader << Length;
+
+	if (Length > Reader->TotalSize() - Reader->Tell())
+	{
+		return false;
+	}
+
+	// Allocated through the schema object so the buffer lives as long as the object, same as DeepCopySchemaObject.
+	uint8* Buffer = Schema_AllocateBuffer(Object, Length);
+	Reader->Serialize(Buffer, Length);
+
+	return Schema_MergeFromBuffer(Object, Buffer, Length) != 0;
+}
+
+bool FOpListReplayer::ReadComponentData(Worker_ComponentData& OutData)
+{
+	uint32 ComponentId = 0;
+	*Reader << ComponentId;
+
+	OutData = {};
+	OutData.component_id = ComponentId;
+	OutData.schema_type = Schema_CreateComponentData(ComponentId);
+	SchemaComponentDatas.Add(OutData.schema_type);
+
+	return ReadSchemaObject(Schema_GetComponentDataFields(OutData.schema_type));
+}
+
+bool FOpListReplayer::ReadComponentUpdate(Worker_ComponentUpdate& OutUpdate)
+{
+	uint32 ComponentId = 0;
+	*Reader << ComponentId;
+
+	OutUpdate = {};
+	OutUpdate.component_id = ComponentId;
+	OutUpdate.schema_type = Schema_CreateComponentUpdate(ComponentId);
+	SchemaComponentUpdates.Add(OutUpdate.schema_type);
+
+	if (!ReadSchemaObject(Schema_GetComponentUpdateFields(OutUpdate.schema_type)) ||
+		!ReadSchemaObject(Schema_GetComponentUpdateEvents(OutUpdate.schema_type)))
+	{
+		return false;
+	}
+
+	uint32 ClearedCount = 0;
+	*Reader << ClearedCount;
+	for (uint32 i = 0; i < ClearedCount; i++)
+	{
+		Schema_FieldId Id = 0;
+		*Reader << Id;
+		Schema_AddComponentUpdateClearedField(OutUpdate.schema_type, Id);
+	}
+
+	return true;
+}
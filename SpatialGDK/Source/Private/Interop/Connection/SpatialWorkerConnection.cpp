@@ -3,9 +3,14 @@
 #include "Interop/Connection/SpatialWorkerConnection.h"
 
 #include "Async/Async.h"
+#include "HAL/RunnableThread.h"
 
 DEFINE_LOG_CATEGORY(LogSpatialWorkerConnection);
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Op lists dequeued"), STAT_SpatialOpListsDequeued, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Op lists queued"), STAT_SpatialOpListsQueued, STATGROUP_SpatialNet);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Op list max queueing delay (ms)"), STAT_SpatialOpListMaxQueueingDelay, STATGROUP_SpatialNet);
+
 void USpatialWorkerConnection::FinishDestroy()
 {
 	DestroyConnection();
@@ -15,6 +20,11 @@ void USpatialWorkerConnection::FinishDestroy()
 
 void USpatialWorkerConnection::DestroyConnection()
 {
+	// The ingest thread reads from WorkerConnection, so it has to be gone before the connection is destroyed.
+	StopOpListThread();
+
+	OpListReplayer.Reset();
+
 	if (WorkerConnection)
 	{
 		Worker_Connection_Destroy(WorkerConnection);
@@ -36,6 +46,12 @@ void USpatialWorkerConnection::Connect(bool bInitAsClient)
 		return;
 	}
 
+	if (!ReceptionistConfig.ReplayOpListFile.IsEmpty())
+	{
+		StartOpListReplay();
+		return;
+	}
+
 	if (ShouldConnectWithLocator())
 	{
 		ConnectToLocator();
@@ -86,8 +102,7 @@ void USpatialWorkerConnection::ConnectToReceptionist(bool bConnectAsClient)
 		{
 			AsyncTask(ENamedThreads::GameThread, [this]
 			{
-				this->bIsConnected = true;
-				this->OnConnected.ExecuteIfBound();
+				this->OnConnectionSucceeded();
 			});
 		}
 		else
@@ -195,8 +210,7 @@ void USpatialWorkerConnection::ConnectToLocator()
 			{
 				AsyncTask(ENamedThreads::GameThread, [SpatialConnection]
 				{
-					SpatialConnection->bIsConnected = true;
-					SpatialConnection->OnConnected.ExecuteIfBound();
+					SpatialConnection->OnConnectionSucceeded();
 				});
 			}
 			else
@@ -207,6 +221,151 @@ void USpatialWorkerConnection::ConnectToLocator()
 	});
 }
 
+void USpatialWorkerConnection::OnConnectionSucceeded()
+{
+	bIsConnected = true;
+
+	const bool bUseOpListThread = ShouldConnectWithLocator() ? LocatorConfig.UseOpListThread : ReceptionistConfig.UseOpListThread;
+	if (bUseOpListThread && !IsReplayingOpLists())
+	{
+		StartOpListThread();
+	}
+
+	OnConnected.ExecuteIfBound();
+}
+
+void USpatialWorkerConnection::StartOpListReplay()
+{
+	OpListReplayer = MakeUnique<FOpListReplayer>();
+	if (!OpListReplayer->Open(ReceptionistConfig.ReplayOpListFile))
+	{
+		OpListReplayer.Reset();
+		OnConnectFailed.ExecuteIfBound(FString::Printf(TEXT("Could not open op list recording %s"), *ReceptionistConfig.ReplayOpListFile));
+		return;
+	}
+
+	NextReplayRequestId = 1;
+	ReplayStartTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogSpatialWorkerConnection, Warning, TEXT("Replaying recorded op lists instead of connecting to SpatialOS. Outgoing messages will be dropped."));
+	OnConnectionSucceeded();
+}
+
+Worker_OpList* USpatialWorkerConnection::GetReplayedOpList()
+{
+	if (OpListReplayer->IsFinished())
+	{
+		return &EmptyReplayOpList;
+	}
+
+	if (Worker_OpList* OpList = OpListReplayer->ReadNextOpList())
+	{
+		return OpList;
+	}
+
+	UE_LOG(LogSpatialWorkerConnection, Log, TEXT("Finished replaying %u op lists (%llu ops). Recorded over %.3fs, replayed in %.3fs."),
+		OpListReplayer->GetNumOpListsReplayed(), OpListReplayer->GetNumOpsReplayed(), OpListReplayer->GetRecordedDuration(), FPlatformTime::Seconds() - ReplayStartTime);
+
+	if (ReceptionistConfig.ExitAfterOpListReplay)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+
+	return &EmptyReplayOpList;
+}
+
+void USpatialWorkerConnection::StartOpListThread()
+{
+	check(OpListThread == nullptr);
+
+	bOpListThreadRunning = true;
+	OpListThread = FRunnableThread::Create(this, TEXT("SpatialOpListIngest"), 0, TPri_AboveNormal);
+
+	if (OpListThread == nullptr)
+	{
+		UE_LOG(LogSpatialWorkerConnection, Warning, TEXT("Failed to create the op list ingest thread, falling back to polling op lists from TickDispatch."));
+		bOpListThreadRunning = false;
+		return;
+	}
+
+	UE_LOG(LogSpatialWorkerConnection, Log, TEXT("Started the op list ingest thread."));
+}
+
+void USpatialWorkerConnection::StopOpListThread()
+{
+	if (OpListThread == nullptr)
+	{
+		return;
+	}
+
+	// Kill calls Stop and waits for Run to return.
+	OpListThread->Kill(true);
+	delete OpListThread;
+	OpListThread = nullptr;
+
+	// Nobody will process these anymore.
+	FQueuedOpList QueuedOpList;
+	while (QueuedOpLists.Dequeue(QueuedOpList))
+	{
+		Worker_OpList_Destroy(QueuedOpList.OpList);
+	}
+	NumQueuedOpLists.Reset();
+}
+
+uint32 USpatialWorkerConnection::Run()
+{
+	while (bOpListThreadRunning)
+	{
+		// Blocks until ops arrive or the timeout expires, which keeps this loop from spinning on an idle connection.
+		Worker_OpList* OpList = Worker_Connection_GetOpList(WorkerConnection, SpatialConstants::OP_LIST_THREAD_GET_OP_LIST_TIMEOUT_MILLIS);
+
+		if (OpList->op_count == 0)
+		{
+			Worker_OpList_Destroy(OpList);
+		}
+		else
+		{
+			QueuedOpLists.Enqueue(FQueuedOpList{ OpList, FPlatformTime::Seconds() });
+			NumQueuedOpLists.Increment();
+		}
+
+		if (!Worker_Connection_IsConnected(WorkerConnection))
+		{
+			// The disconnect op has been queued above, nothing else will arrive on this connection.
+			UE_LOG(LogSpatialWorkerConnection, Log, TEXT("Worker connection lost, stopping the op list ingest thread."));
+			break;
+		}
+	}
+
+	return 0;
+}
+
+void USpatialWorkerConnection::Stop()
+{
+	bOpListThreadRunning = false;
+}
+
+void USpatialWorkerConnection::DequeueOpLists(TArray<Worker_OpList*>& OutOpLists)
+{
+	const double Now = FPlatformTime::Seconds();
+	double MaxQueueingDelay = 0.0;
+	int32 NumDequeued = 0;
+
+	FQueuedOpList QueuedOpList;
+	while (QueuedOpLists.Dequeue(QueuedOpList))
+	{
+		OutOpLists.Add(QueuedOpList.OpList);
+		MaxQueueingDelay = FMath::Max(MaxQueueingDelay, Now - QueuedOpList.EnqueueTime);
+		NumDequeued++;
+	}
+
+	const int32 NumRemaining = NumQueuedOpLists.Subtract(NumDequeued) - NumDequeued;
+
+	SET_DWORD_STAT(STAT_SpatialOpListsDequeued, NumDequeued);
+	SET_DWORD_STAT(STAT_SpatialOpListsQueued, NumRemaining);
+	SET_FLOAT_STAT(STAT_SpatialOpListMaxQueueingDelay, MaxQueueingDelay * 1000.0);
+}
+
 bool USpatialWorkerConnection::ShouldConnectWithLocator()
 {
 	return !LocatorConfig.LoginToken.IsEmpty();
@@ -232,47 +391,112 @@ void USpatialWorkerConnection::GetAndPrintConnectionFailureMessage()
 
 Worker_OpList* USpatialWorkerConnection::GetOpList()
 {
+	if (IsReplayingOpLists())
+	{
+		return GetReplayedOpList();
+	}
+
 	return Worker_Connection_GetOpList(WorkerConnection, 0);
 }
 
+void USpatialWorkerConnection::DestroyOpList(Worker_OpList* OpList)
+{
+	if (IsReplayingOpLists())
+	{
+		// Replayed op lists are owned by the replayer.
+		OpListReplayer->ReleaseOpList();
+		return;
+	}
+
+	Worker_OpList_Destroy(OpList);
+}
+
 Worker_RequestId USpatialWorkerConnection::SendReserveEntityIdRequest()
 {
+	if (IsReplayingOpLists())
+	{
+		return NextReplayRequestId++;
+	}
+
 	return Worker_Connection_SendReserveEntityIdRequest(WorkerConnection, nullptr);
 }
 
 Worker_RequestId USpatialWorkerConnection::SendReserveEntityIdsRequest(uint32_t NumOfEntities)
 {
+	if (IsReplayingOpLists())
+	{
+		return NextReplayRequestId++;
+	}
+
 	return Worker_Connection_SendReserveEntityIdsRequest(WorkerConnection, NumOfEntities, nullptr);
 }
 
 Worker_RequestId USpatialWorkerConnection::SendCreateEntityRequest(uint32_t ComponentCount, const Worker_ComponentData* Components, const Worker_EntityId* EntityId)
 {
+	if (IsReplayingOpLists())
+	{
+		// Sending would have taken ownership of the component data.
+		for (uint32_t i = 0; i < ComponentCount; i++)
+		{
+			Schema_DestroyComponentData(Components[i].schema_type);
+		}
+		return NextReplayRequestId++;
+	}
+
 	return Worker_Connection_SendCreateEntityRequest(WorkerConnection, ComponentCount, Components, EntityId, nullptr);
 }
 
 Worker_RequestId USpatialWorkerConnection::SendDeleteEntityRequest(Worker_EntityId EntityId)
 {
+	if (IsReplayingOpLists())
+	{
+		return NextReplayRequestId++;
+	}
+
 	return Worker_Connection_SendDeleteEntityRequest(WorkerConnection, EntityId, nullptr);
 }
 
 void USpatialWorkerConnection::SendComponentUpdate(Worker_EntityId EntityId, const Worker_ComponentUpdate* ComponentUpdate)
 {
+	if (IsReplayingOpLists())
+	{
+		Schema_DestroyComponentUpdate(ComponentUpdate->schema_type);
+		return;
+	}
+
 	Worker_Connection_SendComponentUpdate(WorkerConnection, EntityId, ComponentUpdate);
 }
 
 Worker_RequestId USpatialWorkerConnection::SendCommandRequest(Worker_EntityId EntityId, const Worker_CommandRequest* Request, uint32_t CommandId)
 {
+	if (IsReplayingOpLists())
+	{
+		Schema_DestroyCommandRequest(Request->schema_type);
+		return NextReplayRequestId++;
+	}
+
 	Worker_CommandParameters CommandParams{};
 	return Worker_Connection_SendCommandRequest(WorkerConnection, EntityId, Request, CommandId, nullptr, &CommandParams);
 }
 
 void USpatialWorkerConnection::SendCommandResponse(Worker_RequestId RequestId, const Worker_CommandResponse* Response)
 {
+	if (IsReplayingOpLists())
+	{
+		Schema_DestroyCommandResponse(Response->schema_type);
+		return;
+	}
+
 	return Worker_Connection_SendCommandResponse(WorkerConnection, RequestId, Response);
 }
 
 void USpatialWorkerConnection::SendLogMessage(const uint8_t Level, const char* LoggerName, const char* Message)
 {
+	if (IsReplayingOpLists())
+	{
+		return;
+	}
+
 	Worker_LogMessage LogMessage{};
 	LogMessage.level = Level;
 	LogMessage.logger_name = LoggerName;
@@ -283,15 +507,30 @@ void USpatialWorkerConnection::SendLogMessage(const uint8_t Level, const char* L
 
 void USpatialWorkerConnection::SendComponentInterest(Worker_EntityId EntityId, const TArray<Worker_InterestOverride>& ComponentInterest)
 {
+	if (IsReplayingOpLists())
+	{
+		return;
+	}
+
 	Worker_Connection_SendComponentInterest(WorkerConnection, EntityId, ComponentInterest.GetData(), ComponentInterest.Num());
 }
 
 FString USpatialWorkerConnection::GetWorkerId() const
 {
+	if (IsReplayingOpLists())
+	{
+		return OpListReplayer->GetRecordedWorkerId();
+	}
+
 	return FString(UTF8_TO_TCHAR(Worker_Connection_GetWorkerId(WorkerConnection)));
 }
 
 Worker_RequestId USpatialWorkerConnection::SendEntityQueryRequest(const Worker_EntityQuery* EntiyQuery)
 {
+	if (IsReplayingOpLists())
+	{
+		return NextReplayRequestId++;
+	}
+
 	return Worker_Connection_SendEntityQueryRequest(WorkerConnection, EntiyQuery, 0);
 }
@@ -11,6 +11,7 @@
 #include "EngineClasses/SpatialPackageMapClient.h"
 #include "Interop/Connection/SpatialWorkerConnection.h"
 #include "Interop/SpatialReceiver.h"
+#include "Interop/SpatialRetryScheduler.h"
 #include "Interop/SpatialSender.h"
 #include "Runtime/Engine/Public/TimerManager.h"
 #include "Schema/UnrealMetadata.h"
@@ -415,11 +416,11 @@ void UGlobalStateManager::RetryQueryGSM(bool bRetryUntilAcceptingPlayers)
 #endif
 
 	UE_LOG(LogGlobalStateManager, Log, TEXT("Retrying query for GSM in %f seconds"), RetryTimerDelay);
-	FTimerHandle RetryTimer;
-	TimerManager->SetTimer(RetryTimer, [this, bRetryUntilAcceptingPlayers]()
+	// This is polling rather than a failing command, so no target to back off from.
+	NetDriver->RetryScheduler->ScheduleRetry(SpatialConstants::INVALID_ENTITY_ID, RetryTimerDelay, [this, bRetryUntilAcceptingPlayers]()
 	{
 		QueryGSM(bRetryUntilAcceptingPlayers);
-	}, RetryTimerDelay, false);
+	});
 }
 
 void UGlobalStateManager::SetDeploymentMapURL(const FString& MapURL)
@@ -0,0 +1,179 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "Interop/SpatialActorPool.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+#include "EngineClasses/SpatialNetDriver.h"
+#include "Interop/Connection/SpatialWorkerConnection.h"
+#include "SpatialConstants.h"
+
+DEFINE_LOG_CATEGORY(LogSpatialActorPool);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actor pool hits"), STAT_SpatialActorPoolHits, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actor pool misses"), STAT_SpatialActorPoolMisses, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actors returned to pool"), STAT_SpatialActorPoolReturned, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actors discarded by full pool"), STAT_SpatialActorPoolDiscarded, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled actors"), STAT_SpatialActorPoolSize, STATGROUP_SpatialNet);
+
+void USpatialActorPool::Init(USpatialNetDriver* InNetDriver)
+{
+	NetDriver = InNetDriver;
+	World = InNetDriver->GetWorld();
+
+	bEnabled = !NetDriver->IsServer() && FParse::Param(FCommandLine::Get(), TEXT("actorPooling"));
+
+	MaxActorsPerClass = SpatialConstants::ACTOR_POOL_DEFAULT_MAX_ACTORS_PER_CLASS;
+	FParse::Value(FCommandLine::Get(), TEXT("actorPoolMaxPerClass"), MaxActorsPerClass);
+
+	if (!bEnabled)
+	{
+		return;
+	}
+
+	FString PrewarmList;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("actorPoolPrewarm"), PrewarmList, false))
+	{
+		return;
+	}
+
+	TArray<FString> PrewarmEntries;
+	PrewarmList.ParseIntoArray(PrewarmEntries, TEXT(","));
+
+	for (const FString& PrewarmEntry : PrewarmEntries)
+	{
+		FString ClassPath;
+		FString CountString;
+		if (!PrewarmEntry.Split(TEXT(":"), &ClassPath, &CountString, ESearchCase::IgnoreCase, ESearchDir::FromEnd))
+		{
+			ClassPath = PrewarmEntry;
+			CountString = FString::FromInt(MaxActorsPerClass);
+		}
+
+		UClass* ActorClass = LoadObject<UClass>(nullptr, *ClassPath);
+		if (ActorClass == nullptr || !ActorClass->IsChildOf<AActor>())
+		{
+			UE_LOG(LogSpatialActorPool, Warning, TEXT("Can't prewarm actor pool for %s, not an actor class."), *ClassPath);
+			continue;
+		}
+
+		Prewarm(ActorClass, FCString::Atoi(*CountString));
+	}
+}
+
+void USpatialActorPool::SetActorActive(AActor* Actor, bool bActive)
+{
+	const AActor* DefaultActor = Actor->GetClass()->GetDefaultObject<AActor>();
+
+	Actor->SetActorHiddenInGame(bActive ? DefaultActor->bHidden : true);
+	Actor->SetActorEnableCollision(bActive ? DefaultActor->GetActorEnableCollision() : false);
+	Actor->SetActorTickEnabled(bActive && Actor->PrimaryActorTick.bStartWithTickEnabled);
+
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		if (Component != nullptr)
+		{
+			Component->SetComponentTickEnabled(bActive && Component->PrimaryComponentTick.bStartWithTickEnabled);
+		}
+	}
+}
+
+bool USpatialActorPool::IsPoolableClass(const UClass* ActorClass) const
+{
+	return bEnabled
+		&& ActorClass->ImplementsInterface(USpatialPoolableActor::StaticClass())
+		&& !ActorClass->IsChildOf<APlayerController>()
+		&& !ActorClass->HasAnySpatialClassFlags(SPATIALCLASS_Singleton);
+}
+
+bool USpatialActorPool::IsPoolable(const AActor* Actor) const
+{
+	return Actor != nullptr && IsPoolableClass(Actor->GetClass());
+}
+
+AActor* USpatialActorPool::AcquireActor(UClass* ActorClass, const FTransform& Transform)
+{
+	if (!IsPoolableClass(ActorClass))
+	{
+		return nullptr;
+	}
+
+	TArray<TWeakObjectPtr<AActor>>* ClassActors = InactiveActors.Find(ActorClass);
+	while (ClassActors != nullptr && ClassActors->Num() > 0)
+	{
+		AActor* Actor = ClassActors->Pop(false).Get();
+		DEC_DWORD_STAT(STAT_SpatialActorPoolSize);
+
+		if (Actor == nullptr || Actor->IsPendingKill())
+		{
+			continue;
+		}
+
+		Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+		SetActorActive(Actor, true);
+		ISpatialPoolableActor::Execute_OnTakenFromPool(Actor);
+
+		INC_DWORD_STAT(STAT_SpatialActorPoolHits);
+		return Actor;
+	}
+
+	INC_DWORD_STAT(STAT_SpatialActorPoolMisses);
+	return nullptr;
+}
+
+bool USpatialActorPool::ReleaseActor(AActor* Actor)
+{
+	if (!IsPoolable(Actor) || Actor->IsPendingKill())
+	{
+		return false;
+	}
+
+	TArray<TWeakObjectPtr<AActor>>& ClassActors = InactiveActors.FindOrAdd(Actor->GetClass());
+	if (ClassActors.Num() >= MaxActorsPerClass)
+	{
+		INC_DWORD_STAT(STAT_SpatialActorPoolDiscarded);
+		return false;
+	}
+
+	ISpatialPoolableActor::Execute_OnReturnedToPool(Actor);
+	Actor->SetOwner(nullptr);
+	SetActorActive(Actor, false);
+
+	ClassActors.Add(Actor);
+	INC_DWORD_STAT(STAT_SpatialActorPoolReturned);
+	INC_DWORD_STAT(STAT_SpatialActorPoolSize);
+	return true;
+}
+
+void USpatialActorPool::Prewarm(UClass* ActorClass, int32 Count)
+{
+	if (!IsPoolableClass(ActorClass))
+	{
+		UE_LOG(LogSpatialActorPool, Warning, TEXT("Not prewarming %s, it doesn't implement ISpatialPoolableActor or can't be pooled."), *ActorClass->GetName());
+		return;
+	}
+
+	TArray<TWeakObjectPtr<AActor>>& ClassActors = InactiveActors.FindOrAdd(ActorClass);
+	const int32 NumToSpawn = FMath::Min(Count, MaxActorsPerClass) - ClassActors.Num();
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnInfo.bRemoteOwned = true;
+	SpawnInfo.bNoFail = true;
+
+	for (int32 i = 0; i < NumToSpawn; i++)
+	{
+		AActor* Actor = World->SpawnActorAbsolute(ActorClass, FTransform::Identity, SpawnInfo);
+		check(Actor);
+
+		SetActorActive(Actor, false);
+		ClassActors.Add(Actor);
+		INC_DWORD_STAT(STAT_SpatialActorPoolSize);
+	}
+
+	UE_LOG(LogSpatialActorPool, Log, TEXT("Prewarmed actor pool for %s with %d actors."), *ActorClass->GetName(), FMath::Max(NumToSpawn, 0));
+}
@@ -2,113 +2,402 @@
 
 #include "Interop/SpatialDispatcher.h"
 
-#include "EngineClasses/SpatialNetConnection.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
 #include "EngineClasses/SpatialNetDriver.h"
+#include "Interop/Connection/SpatialWorkerConnection.h"
 #include "Interop/SpatialReceiver.h"
 #include "Interop/SpatialStaticComponentView.h"
+#include "Utils/SchemaUtils.h"
 
 DEFINE_LOG_CATEGORY(LogSpatialView);
 
+DECLARE_CYCLE_STAT(TEXT("Op CriticalSection"), STAT_SpatialOpCriticalSection, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("Op AddEntity"), STAT_SpatialOpAddEntity, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("Op RemoveEntity"), STAT_SpatialOpRemoveEntity, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("Op AddComponent"), STAT_SpatialOpAddComponent, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("Op ComponentUpdate"), STAT_SpatialOpComponentUpdate, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("Op CommandRequest"), STAT_SpatialOpCommandRequest, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("Op CommandResponse"), STAT_SpatialOpCommandResponse, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("Op AuthorityChange"), STAT_SpatialOpAuthorityChange, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("SpatialViewTick"), STAT_SpatialViewTick, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Coalesced component updates"), STAT_SpatialCoalescedComponentUpdates, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending ops"), STAT_SpatialPendingOps, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending op lists"), STAT_SpatialPendingOpLists, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending actor spawns"), STAT_SpatialPendingActorSpawns, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Op processing ticks over budget"), STAT_SpatialOpTicksOverBudget, STATGROUP_SpatialNet);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Oldest op backlog age (ms)"), STAT_SpatialOldestOpBacklogAge, STATGROUP_SpatialNet);
+
 void USpatialDispatcher::Init(USpatialNetDriver* InNetDriver)
 {
 	NetDriver = InNetDriver;
 	Receiver = InNetDriver->Receiver;
 	StaticComponentView = InNetDriver->StaticComponentView;
+
+	NextOpIndex = 0;
+	bInCriticalSection = false;
+	NumTicksOverBudget = 0;
+
+	OpProcessingBudgetMs = 0.0f;
+	FParse::Value(FCommandLine::Get(), TEXT("opProcessingBudgetMs"), OpProcessingBudgetMs);
+	OpStats.SetProcessingBudgetMs(OpProcessingBudgetMs);
+
+	FString RecordingPath;
+	if (FParse::Value(FCommandLine::Get(), TEXT("recordOpListFile"), RecordingPath))
+	{
+		StartRecording(RecordingPath);
+	}
 }
 
-void USpatialDispatcher::ProcessOps(Worker_OpList* OpList)
+void USpatialDispatcher::Shutdown()
 {
-	TArray<Worker_Op*> QueuedComponentUpdateOps;
+	StopRecording();
 
-	for (size_t i = 0; i < OpList->op_count; ++i)
+	// The queued component updates that weren't merged point into the op lists.
+	for (FQueuedComponentUpdate& QueuedUpdate : QueuedComponentUpdates)
 	{
-		Worker_Op* Op = &OpList->ops[i];
-		switch (Op->op_type)
+		if (QueuedUpdate.bOwnsUpdate)
 		{
-		// Critical Section
-		case WORKER_OP_TYPE_CRITICAL_SECTION:
-			Receiver->OnCriticalSection(Op->critical_section.in_critical_section != 0);
-			break;
+			Schema_DestroyComponentUpdate(QueuedUpdate.Op.update.schema_type);
+		}
+	}
+	QueuedComponentUpdates.Reset();
+	OpenComponentUpdates.Reset();
 
-		// Entity Lifetime
-		case WORKER_OP_TYPE_ADD_ENTITY:
-			Receiver->OnAddEntity(Op->add_entity);
-			break;
-		case WORKER_OP_TYPE_REMOVE_ENTITY:
-			Receiver->OnRemoveEntity(Op->remove_entity);
-			StaticComponentView->OnRemoveEntity(Op->remove_entity);
+	for (Worker_OpList* OpList : PendingOpLists)
+	{
+		NetDriver->Connection->DestroyOpList(OpList);
+	}
+	PendingOpLists.Reset();
+	PendingOpListQueueTimes.Reset();
+	NextOpIndex = 0;
+
+	SET_DWORD_STAT(STAT_SpatialPendingOps, 0);
+	SET_DWORD_STAT(STAT_SpatialPendingOpLists, 0);
+	SET_DWORD_STAT(STAT_SpatialPendingActorSpawns, 0);
+}
+
+bool USpatialDispatcher::StartRecording(const FString& FilePath)
+{
+	return OpListRecorder.Open(FilePath, NetDriver->Connection->GetWorkerId());
+}
+
+void USpatialDispatcher::StopRecording()
+{
+	OpListRecorder.Close();
+}
+
+void USpatialDispatcher::QueueOpList(Worker_OpList* OpList)
+{
+	OpListRecorder.RecordOpList(OpList);
+
+	if (OpList->op_count == 0)
+	{
+		NetDriver->Connection->DestroyOpList(OpList);
+		return;
+	}
+
+	PendingOpLists.Add(OpList);
+	PendingOpListQueueTimes.Add(FPlatformTime::Seconds());
+}
+
+bool USpatialDispatcher::HasPendingOps() const
+{
+	return PendingOpLists.Num() > 0 || Receiver->IsApplyingCriticalSection();
+}
+
+void USpatialDispatcher::ProcessOps()
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const uint64 DeadlineCycles = OpProcessingBudgetMs > 0.0f ? StartCycles + uint64(OpProcessingBudgetMs / 1000.0 / FPlatformTime::GetSecondsPerCycle64()) : MAX_uint64;
+
+	bool bOutOfTime = false;
+
+	// Finish checking out actors from a critical section that didn't fit into the previous tick.
+	if (Receiver->IsApplyingCriticalSection())
+	{
+		bOutOfTime = !ApplyCriticalSection(DeadlineCycles);
+	}
+
+	while (!bOutOfTime && PendingOpLists.Num() > 0)
+	{
+		Worker_OpList* OpList = PendingOpLists[0];
+
+		while (NextOpIndex < OpList->op_count)
+		{
+			// Critical sections have to be received in full, so the budget is only checked outside of them.
+			if (!bInCriticalSection && FPlatformTime::Cycles64() >= DeadlineCycles)
+			{
+				ApplyQueuedComponentUpdates();
+				bOutOfTime = true;
+				break;
+			}
+
+			ProcessOp(&OpList->ops[NextOpIndex++]);
+
+			if (Receiver->IsApplyingCriticalSection() && !ApplyCriticalSection(DeadlineCycles))
+			{
+				bOutOfTime = true;
+				break;
+			}
+		}
+
+		// Keep the op list alive until the critical section it checked out has been applied,
+		// the ops the Receiver and the queued component updates hold back point into it.
+		if (NextOpIndex < OpList->op_count || Receiver->IsApplyingCriticalSection())
+		{
 			break;
+		}
+
+		ApplyQueuedComponentUpdates();
+
+		PendingOpLists.RemoveAt(0);
+		PendingOpListQueueTimes.RemoveAt(0);
+		NextOpIndex = 0;
+		NetDriver->Connection->DestroyOpList(OpList);
+	}
+
+	if (bOutOfTime)
+	{
+		NumTicksOverBudget++;
+	}
+
+	UpdateBacklogStats();
+	StaticComponentView->UpdateMemoryStats();
+	Receiver->UpdateUnresolvedRefStats();
+
+	SCOPE_CYCLE_COUNTER(STAT_SpatialViewTick);
+
+	// Update ACLs and component interest for channels whose net ownership may have changed
+	NetDriver->ProcessOwnershipChanges();
+}
+
+void USpatialDispatcher::ProcessOp(Worker_Op* Op)
+{
+	// Any other op is applied after the component updates that came before it. Inside a critical section the Receiver
+	// holds back the entity ops until the section has been applied, so the updates are held back as well.
+	if (Op->op_type != WORKER_OP_TYPE_COMPONENT_UPDATE)
+	{
+		if (bInCriticalSection)
+		{
+			OpenComponentUpdates.Reset();
+		}
+		else
+		{
+			ApplyQueuedComponentUpdates();
+		}
+	}
+
+	const uint64 OpStartCycles = FPlatformTime::Cycles64();
+
+	switch (Op->op_type)
+	{
+	// Critical Section
+	case WORKER_OP_TYPE_CRITICAL_SECTION:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialOpCriticalSection);
+		bInCriticalSection = Op->critical_section.in_critical_section != 0;
+		Receiver->OnCriticalSection(bInCriticalSection);
+		break;
+	}
 
-		// Components
-		case WORKER_OP_TYPE_ADD_COMPONENT:
+	// Entity Lifetime
+	case WORKER_OP_TYPE_ADD_ENTITY:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialOpAddEntity);
+		Receiver->OnAddEntity(Op->add_entity);
+		break;
+	}
+	case WORKER_OP_TYPE_REMOVE_ENTITY:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialOpRemoveEntity);
+		Receiver->OnRemoveEntity(Op->remove_entity);
+		StaticComponentView->OnRemoveEntity(Op->remove_entity);
+		break;
+	}
+
+	// Components
+	case WORKER_OP_TYPE_ADD_COMPONENT:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialOpAddComponent);
+		// Inside a critical section the Receiver hands it to the view when the entity is checked out.
+		if (!bInCriticalSection)
+		{
 			StaticComponentView->OnAddComponent(Op->add_component);
-			Receiver->OnAddComponent(Op->add_component);
-			break;
-		case WORKER_OP_TYPE_REMOVE_COMPONENT:
-			break;
-		case WORKER_OP_TYPE_COMPONENT_UPDATE:
-			QueuedComponentUpdateOps.Add(Op);
-			StaticComponentView->OnComponentUpdate(Op->component_update);
-			break;
+		}
+		Receiver->OnAddComponent(Op->add_component);
+		break;
+	}
+	case WORKER_OP_TYPE_REMOVE_COMPONENT:
+		break;
+	case WORKER_OP_TYPE_COMPONENT_UPDATE:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialOpComponentUpdate);
+		QueueComponentUpdate(Op, OpStartCycles);
+		return;
+	}
 
-		// Commands
-		case WORKER_OP_TYPE_COMMAND_REQUEST:
-			Receiver->OnCommandRequest(Op->command_request);
-			break;
-		case WORKER_OP_TYPE_COMMAND_RESPONSE:
-			Receiver->OnCommandResponse(Op->command_response);
-			break;
+	// Commands
+	case WORKER_OP_TYPE_COMMAND_REQUEST:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialOpCommandRequest);
+		Receiver->OnCommandRequest(Op->command_request);
+		break;
+	}
+	case WORKER_OP_TYPE_COMMAND_RESPONSE:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialOpCommandResponse);
+		Receiver->OnCommandResponse(Op->command_response);
+		break;
+	}
 
-		// Authority Change
-		case WORKER_OP_TYPE_AUTHORITY_CHANGE:
+	// Authority Change
+	case WORKER_OP_TYPE_AUTHORITY_CHANGE:
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialOpAuthorityChange);
+		if (!bInCriticalSection)
+		{
 			StaticComponentView->OnAuthorityChange(Op->authority_change);
-			Receiver->OnAuthorityChange(Op->authority_change);
-			break;
+		}
+		Receiver->OnAuthorityChange(Op->authority_change);
+		break;
+	}
 
-		// World Command Responses
-		case WORKER_OP_TYPE_RESERVE_ENTITY_ID_RESPONSE:
-			Receiver->OnReserveEntityIdResponse(Op->reserve_entity_id_response);
-			break;
-		case WORKER_OP_TYPE_RESERVE_ENTITY_IDS_RESPONSE:
-			Receiver->OnReserveEntityIdsResponse(Op->reserve_entity_ids_response);
-			break;
-		case WORKER_OP_TYPE_CREATE_ENTITY_RESPONSE:
-			Receiver->OnCreateEntityResponse(Op->create_entity_response);
-			break;
-		case WORKER_OP_TYPE_DELETE_ENTITY_RESPONSE:
-			break;
-		case WORKER_OP_TYPE_ENTITY_QUERY_RESPONSE:
-			Receiver->OnEntityQueryResponse(Op->entity_query_response);
-			break;
+	// World Command Responses
+	case WORKER_OP_TYPE_RESERVE_ENTITY_ID_RESPONSE:
+		Receiver->OnReserveEntityIdResponse(Op->reserve_entity_id_response);
+		break;
+	case WORKER_OP_TYPE_RESERVE_ENTITY_IDS_RESPONSE:
+		Receiver->OnReserveEntityIdsResponse(Op->reserve_entity_ids_response);
+		break;
+	case WORKER_OP_TYPE_CREATE_ENTITY_RESPONSE:
+		Receiver->OnCreateEntityResponse(Op->create_entity_response);
+		break;
+	case WORKER_OP_TYPE_DELETE_ENTITY_RESPONSE:
+		break;
+	case WORKER_OP_TYPE_ENTITY_QUERY_RESPONSE:
+		Receiver->OnEntityQueryResponse(Op->entity_query_response);
+		break;
 
-		case WORKER_OP_TYPE_FLAG_UPDATE:
-			break;
-		case WORKER_OP_TYPE_LOG_MESSAGE:
-			UE_LOG(LogSpatialView, Log, TEXT("SpatialOS Worker Log: %s"), UTF8_TO_TCHAR(Op->log_message.message));
-			break;
-		case WORKER_OP_TYPE_METRICS:
-			break;
-		case WORKER_OP_TYPE_DISCONNECT:
-			UE_LOG(LogSpatialView, Warning, TEXT("Disconnecting from SpatialOS: %s"), UTF8_TO_TCHAR(Op->disconnect.reason));
-			break;
+	case WORKER_OP_TYPE_FLAG_UPDATE:
+		break;
+	case WORKER_OP_TYPE_LOG_MESSAGE:
+		UE_LOG(LogSpatialView, Log, TEXT("SpatialOS Worker Log: %s"), UTF8_TO_TCHAR(Op->log_message.message));
+		break;
+	case WORKER_OP_TYPE_METRICS:
+		OpStats.RecordWorkerMetrics(Op->metrics.metrics);
+		break;
+	case WORKER_OP_TYPE_DISCONNECT:
+		UE_LOG(LogSpatialView, Warning, TEXT("Disconnecting from SpatialOS: %s"), UTF8_TO_TCHAR(Op->disconnect.reason));
+		break;
 
-		default:
-			break;
+	default:
+		break;
+	}
+
+	OpStats.RecordOp(Op->op_type, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - OpStartCycles));
+}
+
+bool USpatialDispatcher::ApplyCriticalSection(uint64 DeadlineCycles)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpatialOpCriticalSection);
+
+	if (!Receiver->ApplyCriticalSection(DeadlineCycles))
+	{
+		return false;
+	}
+
+	// The component updates received inside the critical section go after its entity ops.
+	ApplyQueuedComponentUpdates();
+	return true;
+}
+
+void USpatialDispatcher::QueueComponentUpdate(Worker_Op* Op, uint64 OpStartCycles)
+{
+	const Worker_ComponentUpdateOp& UpdateOp = Op->component_update;
+
+	// A run of updates to the same generated component is merged into one, so the Receiver only pays for
+	// PreReceiveSpatialUpdate, shadow data and RepNotifies once. Updates of other entities in between don't end the run,
+	// an update of another component of the same entity does, which keeps the order within the entity.
+	// The other components are handled separately by the Receiver.
+	if (const int32* OpenIndex = OpenComponentUpdates.Find(UpdateOp.entity_id))
+	{
+		FQueuedComponentUpdate& OpenUpdate = QueuedComponentUpdates[*OpenIndex];
+		if (OpenUpdate.Op.update.component_id == UpdateOp.update.component_id)
+		{
+			// The op's update is owned by the op list, so merge into a copy of it.
+			if (!OpenUpdate.bOwnsUpdate)
+			{
+				Schema_ComponentUpdate* MergedUpdate = Schema_CreateComponentUpdate(UpdateOp.update.component_id);
+				improbable::MergeComponentUpdate(MergedUpdate, OpenUpdate.Op.update.schema_type);
+				OpenUpdate.Op.update.schema_type = MergedUpdate;
+				OpenUpdate.bOwnsUpdate = true;
+			}
+
+			improbable::MergeComponentUpdate(OpenUpdate.Op.update.schema_type, UpdateOp.update.schema_type);
+			OpenUpdate.Cycles += FPlatformTime::Cycles64() - OpStartCycles;
+			INC_DWORD_STAT(STAT_SpatialCoalescedComponentUpdates);
+			return;
 		}
 	}
 
-	for (Worker_Op* Op : QueuedComponentUpdateOps)
+	// Recorded together with the deferred Receiver part in ApplyQueuedComponentUpdates.
+	const int32 Index = QueuedComponentUpdates.Add(FQueuedComponentUpdate{ UpdateOp, false, FPlatformTime::Cycles64() - OpStartCycles });
+
+	if (UpdateOp.update.component_id >= SpatialConstants::STARTING_GENERATED_COMPONENT_ID)
 	{
-		Receiver->OnComponentUpdate(Op->component_update);
+		OpenComponentUpdates.Add(UpdateOp.entity_id, Index);
 	}
+	else
+	{
+		OpenComponentUpdates.Remove(UpdateOp.entity_id);
+	}
+}
 
-	// Check every channel for net ownership changes (determines ACL and component interest)
-	const FActorChannelMap& ChannelMap = NetDriver->GetSpatialOSNetConnection()->ActorChannelMap();
-	for (auto& Pair : ChannelMap)
+void USpatialDispatcher::ApplyQueuedComponentUpdates()
+{
+	for (FQueuedComponentUpdate& QueuedUpdate : QueuedComponentUpdates)
 	{
-		if (USpatialActorChannel* Channel = Cast<USpatialActorChannel>(Pair.Value))
+		const uint64 OpStartCycles = FPlatformTime::Cycles64();
+
 		{
-			Channel->SpatialViewTick();
+			SCOPE_CYCLE_COUNTER(STAT_SpatialOpComponentUpdate);
+			// Applied to the view here rather than when queued, so the view doesn't run ahead of a critical section
+			// that is still being checked out.
+			StaticComponentView->OnComponentUpdate(QueuedUpdate.Op);
+			Receiver->OnComponentUpdate(QueuedUpdate.Op);
+		}
+
+		const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - OpStartCycles + QueuedUpdate.Cycles);
+		OpStats.RecordOp(WORKER_OP_TYPE_COMPONENT_UPDATE, Seconds);
+		OpStats.RecordComponentUpdate(QueuedUpdate.Op.update.component_id, Seconds);
+
+		if (QueuedUpdate.bOwnsUpdate)
+		{
+			Schema_DestroyComponentUpdate(QueuedUpdate.Op.update.schema_type);
 		}
 	}
+
+	QueuedComponentUpdates.Reset();
+	OpenComponentUpdates.Reset();
+}
+
+void USpatialDispatcher::UpdateBacklogStats()
+{
+	uint32 NumPendingOps = 0;
+	for (int32 i = 0; i < PendingOpLists.Num(); i++)
+	{
+		NumPendingOps += PendingOpLists[i]->op_count - (i == 0 ? NextOpIndex : 0);
+	}
+
+	const double OldestBacklogAge = PendingOpListQueueTimes.Num() > 0 ? FPlatformTime::Seconds() - PendingOpListQueueTimes[0] : 0.0;
+
+	SET_DWORD_STAT(STAT_SpatialPendingOps, NumPendingOps);
+	SET_DWORD_STAT(STAT_SpatialPendingOpLists, PendingOpLists.Num());
+	SET_DWORD_STAT(STAT_SpatialOpTicksOverBudget, NumTicksOverBudget);
+	SET_DWORD_STAT(STAT_SpatialPendingActorSpawns, Receiver->GetNumPendingSpawns());
+	SET_FLOAT_STAT(STAT_SpatialOldestOpBacklogAge, OldestBacklogAge * 1000.0);
+
+	OpStats.RecordBacklog(NumPendingOps, Receiver->GetNumPendingSpawns(), OldestBacklogAge, NumTicksOverBudget);
 }
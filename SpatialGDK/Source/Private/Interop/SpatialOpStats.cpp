@@ -0,0 +1,215 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "Interop/SpatialOpStats.h"
+
+#include "Misc/OutputDevice.h"
+
+void FSpatialLatencyHistogram::Add(double Microseconds)
+{
+	int32 Bucket = 0;
+	if (Microseconds > 1.0)
+	{
+		Bucket = FMath::Clamp(FMath::FloorToInt(FMath::Log2(Microseconds) * BUCKETS_PER_OCTAVE), 0, NUM_BUCKETS - 1);
+	}
+
+	Buckets[Bucket]++;
+	NumSamples++;
+}
+
+double FSpatialLatencyHistogram::GetPercentile(float Percentile) const
+{
+	if (NumSamples == 0)
+	{
+		return 0.0;
+	}
+
+	const uint64 Target = FMath::Max<uint64>(1, FMath::CeilToInt(NumSamples * Percentile));
+	uint64 Cumulative = 0;
+	for (int32 Bucket = 0; Bucket < NUM_BUCKETS; Bucket++)
+	{
+		Cumulative += Buckets[Bucket];
+		if (Cumulative >= Target)
+		{
+			// Report the upper bound of the bucket so percentiles never under-report.
+			return FMath::Pow(2.0f, float(Bucket + 1) / BUCKETS_PER_OCTAVE);
+		}
+	}
+
+	return FMath::Pow(2.0f, float(NUM_BUCKETS) / BUCKETS_PER_OCTAVE);
+}
+
+void FSpatialLatencyHistogram::Reset()
+{
+	FMemory::Memzero(Buckets);
+	NumSamples = 0;
+}
+
+void FSpatialOpTimingStats::Add(double Seconds)
+{
+	Count++;
+	TotalSeconds += Seconds;
+	MaxSeconds = FMath::Max(MaxSeconds, Seconds);
+	Histogram.Add(Seconds * 1000000.0);
+}
+
+void FSpatialOpTimingStats::Reset()
+{
+	Count = 0;
+	TotalSeconds = 0.0;
+	MaxSeconds = 0.0;
+	Histogram.Reset();
+}
+
+void FSpatialOpStats::RecordOp(uint8 OpType, double Seconds)
+{
+	if (OpType < MAX_OP_TYPES)
+	{
+		OpTypeStats[OpType].Add(Seconds);
+	}
+}
+
+void FSpatialOpStats::RecordComponentUpdate(Worker_ComponentId ComponentId, double Seconds)
+{
+	ComponentUpdateStats.FindOrAdd(ComponentId).Add(Seconds);
+}
+
+void FSpatialOpStats::RecordWorkerMetrics(const Worker_Metrics& Metrics)
+{
+	if (Metrics.load != nullptr)
+	{
+		WorkerLoad = *Metrics.load;
+	}
+
+	for (uint32 i = 0; i < Metrics.gauge_metric_count; i++)
+	{
+		WorkerGaugeMetrics.Add(UTF8_TO_TCHAR(Metrics.gauge_metrics[i].key), Metrics.gauge_metrics[i].value);
+	}
+}
+
+void FSpatialOpStats::RecordBacklog(uint32 NumPendingOps, int32 NumPendingSpawns, double OldestBacklogAge, uint32 NumTicksOverBudget)
+{
+	MaxPendingOps = FMath::Max(MaxPendingOps, NumPendingOps);
+	MaxPendingSpawns = FMath::Max(MaxPendingSpawns, NumPendingSpawns);
+	MaxBacklogAge = FMath::Max(MaxBacklogAge, OldestBacklogAge);
+	TicksOverBudget = NumTicksOverBudget;
+}
+
+void FSpatialOpStats::Dump(FOutputDevice& Ar) const
+{
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+	Ar.Logf(TEXT("Spatial op processing stats over the last %.1fs:"), Elapsed);
+	Ar.Logf(TEXT("%-28s %10s %12s %10s %10s %10s %10s"), TEXT("Op type"), TEXT("Count"), TEXT("Total ms"), TEXT("Avg us"), TEXT("p50 us"), TEXT("p99 us"), TEXT("Max us"));
+
+	for (int32 OpType = 0; OpType < MAX_OP_TYPES; OpType++)
+	{
+		const FSpatialOpTimingStats& Stats = OpTypeStats[OpType];
+		if (Stats.Count == 0)
+		{
+			continue;
+		}
+
+		Ar.Logf(TEXT("%-28s %10llu %12.3f %10.2f %10.2f %10.2f %10.2f"), GetOpTypeName(OpType), Stats.Count, Stats.TotalSeconds * 1000.0,
+			Stats.TotalSeconds * 1000000.0 / Stats.Count, Stats.Histogram.GetPercentile(0.5f), Stats.Histogram.GetPercentile(0.99f), Stats.MaxSeconds * 1000000.0);
+	}
+
+	if (ComponentUpdateStats.Num() > 0)
+	{
+		// Most expensive components first.
+		TArray<Worker_ComponentId> ComponentIds;
+		ComponentUpdateStats.GetKeys(ComponentIds);
+		ComponentIds.Sort([this](Worker_ComponentId A, Worker_ComponentId B)
+		{
+			return ComponentUpdateStats[A].TotalSeconds > ComponentUpdateStats[B].TotalSeconds;
+		});
+
+		Ar.Logf(TEXT("Component updates by component id:"));
+		Ar.Logf(TEXT("%-28s %10s %12s %10s %10s %10s %10s"), TEXT("Component id"), TEXT("Count"), TEXT("Total ms"), TEXT("Avg us"), TEXT("p50 us"), TEXT("p99 us"), TEXT("Max us"));
+
+		for (Worker_ComponentId ComponentId : ComponentIds)
+		{
+			const FSpatialOpTimingStats& Stats = ComponentUpdateStats[ComponentId];
+			Ar.Logf(TEXT("%-28u %10llu %12.3f %10.2f %10.2f %10.2f %10.2f"), ComponentId, Stats.Count, Stats.TotalSeconds * 1000.0,
+				Stats.TotalSeconds * 1000000.0 / Stats.Count, Stats.Histogram.GetPercentile(0.5f), Stats.Histogram.GetPercentile(0.99f), Stats.MaxSeconds * 1000000.0);
+		}
+	}
+
+	if (ProcessingBudgetMs > 0.0f)
+	{
+		Ar.Logf(TEXT("Op processing budget %.2fms: %u ticks over budget, max backlog %u ops / %d actor spawns, max backlog age %.1fms"),
+			ProcessingBudgetMs, TicksOverBudget - TicksOverBudgetAtReset, MaxPendingOps, MaxPendingSpawns, MaxBacklogAge * 1000.0);
+	}
+
+	if (WorkerLoad >= 0.0 || WorkerGaugeMetrics.Num() > 0)
+	{
+		Ar.Logf(TEXT("Latest Worker SDK metrics:"));
+		if (WorkerLoad >= 0.0)
+		{
+			Ar.Logf(TEXT("  load: %.3f"), WorkerLoad);
+		}
+		for (const auto& Pair : WorkerGaugeMetrics)
+		{
+			Ar.Logf(TEXT("  %s: %.3f"), *Pair.Key, Pair.Value);
+		}
+	}
+}
+
+void FSpatialOpStats::Reset()
+{
+	for (FSpatialOpTimingStats& Stats : OpTypeStats)
+	{
+		Stats.Reset();
+	}
+	ComponentUpdateStats.Empty();
+	WorkerGaugeMetrics.Empty();
+	WorkerLoad = -1.0;
+	MaxPendingOps = 0;
+	MaxPendingSpawns = 0;
+	MaxBacklogAge = 0.0;
+	TicksOverBudgetAtReset = TicksOverBudget;
+	StartTime = FPlatformTime::Seconds();
+}
+
+const TCHAR* FSpatialOpStats::GetOpTypeName(uint8 OpType)
+{
+	switch (OpType)
+	{
+	case WORKER_OP_TYPE_DISCONNECT:
+		return TEXT("Disconnect");
+	case WORKER_OP_TYPE_FLAG_UPDATE:
+		return TEXT("FlagUpdate");
+	case WORKER_OP_TYPE_LOG_MESSAGE:
+		return TEXT("LogMessage");
+	case WORKER_OP_TYPE_METRICS:
+		return TEXT("Metrics");
+	case WORKER_OP_TYPE_CRITICAL_SECTION:
+		return TEXT("CriticalSection");
+	case WORKER_OP_TYPE_ADD_ENTITY:
+		return TEXT("AddEntity");
+	case WORKER_OP_TYPE_REMOVE_ENTITY:
+		return TEXT("RemoveEntity");
+	case WORKER_OP_TYPE_RESERVE_ENTITY_ID_RESPONSE:
+		return TEXT("ReserveEntityIdResponse");
+	case WORKER_OP_TYPE_RESERVE_ENTITY_IDS_RESPONSE:
+		return TEXT("ReserveEntityIdsResponse");
+	case WORKER_OP_TYPE_CREATE_ENTITY_RESPONSE:
+		return TEXT("CreateEntityResponse");
+	case WORKER_OP_TYPE_DELETE_ENTITY_RESPONSE:
+		return TEXT("DeleteEntityResponse");
+	case WORKER_OP_TYPE_ENTITY_QUERY_RESPONSE:
+		return TEXT("EntityQueryResponse");
+	case WORKER_OP_TYPE_ADD_COMPONENT:
+		return TEXT("AddComponent");
+	case WORKER_OP_TYPE_REMOVE_COMPONENT:
+		return TEXT("RemoveComponent");
+	case WORKER_OP_TYPE_AUTHORITY_CHANGE:
+		return TEXT("AuthorityChange");
+	case WORKER_OP_TYPE_COMPONENT_UPDATE:
+		return TEXT("ComponentUpdate");
+	case WORKER_OP_TYPE_COMMAND_REQUEST:
+		return TEXT("CommandRequest");
+	case WORKER_OP_TYPE_COMMAND_RESPONSE:
+		return TEXT("CommandResponse");
+	default:
+		return TEXT("Unknown");
+	}
+}
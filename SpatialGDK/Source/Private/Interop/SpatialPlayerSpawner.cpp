@@ -3,12 +3,12 @@
 #include "Interop/SpatialPlayerSpawner.h"
 
 #include "SocketSubsystem.h"
-#include "TimerManager.h"
 
 #include "EngineClasses/SpatialNetConnection.h"
 #include "EngineClasses/SpatialNetDriver.h"
 #include "Interop/Connection/SpatialWorkerConnection.h"
 #include "Interop/SpatialReceiver.h"
+#include "Interop/SpatialRetryScheduler.h"
 #include "SpatialConstants.h"
 #include "Utils/SchemaUtils.h"
 
@@ -94,17 +94,18 @@ void USpatialPlayerSpawner::ReceivePlayerSpawnResponse(Worker_CommandResponseOp&
 	if (Op.status_code == WORKER_STATUS_CODE_SUCCESS)
 	{
 		UE_LOG(LogSpatialPlayerSpawner, Display, TEXT("Player spawned sucessfully"));
+		NetDriver->RetryScheduler->ReportSuccess(Op.entity_id);
 	}
 	else if (NumberOfAttempts < SpatialConstants::MAX_NUMBER_COMMAND_ATTEMPTS)
 	{
 		UE_LOG(LogSpatialPlayerSpawner, Warning, TEXT("Player spawn request failed: \"%s\""),
 			UTF8_TO_TCHAR(Op.message));
+		NetDriver->RetryScheduler->ReportFailure(Op.entity_id);
 
-		FTimerHandle RetryTimer;
-		TimerManager->SetTimer(RetryTimer, [this]()
+		NetDriver->RetryScheduler->ScheduleRetry(Op.entity_id, SpatialConstants::GetCommandRetryWaitTimeSeconds(NumberOfAttempts), [this]()
 		{
 			SendPlayerSpawnRequest();
-		}, SpatialConstants::GetCommandRetryWaitTimeSeconds(NumberOfAttempts), false);
+		});
 	}
 	else
 	{
@@ -4,6 +4,9 @@
 
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+#include "Misc/OutputDevice.h"
+#include "Misc/Parse.h"
 #include "TimerManager.h"
 
 #include "EngineClasses/SpatialActorChannel.h"
@@ -11,7 +14,9 @@
 #include "EngineClasses/SpatialPackageMapClient.h"
 #include "Interop/Connection/SpatialWorkerConnection.h"
 #include "Interop/GlobalStateManager.h"
+#include "Interop/SpatialActorPool.h"
 #include "Interop/SpatialPlayerSpawner.h"
+#include "Interop/SpatialRetryScheduler.h"
 #include "Interop/SpatialSender.h"
 #include "Schema/DynamicComponent.h"
 #include "Schema/Rotation.h"
@@ -23,22 +28,172 @@
 
 DEFINE_LOG_CATEGORY(LogSpatialReceiver);
 
+DECLARE_CYCLE_STAT(TEXT("Resolve incoming operations"), STAT_SpatialResolveIncomingOperations, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Resolved dependent properties"), STAT_SpatialResolvedDependentProperties, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Unresolved object refs"), STAT_SpatialUnresolvedObjectRefs, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Objects with unresolved properties"), STAT_SpatialPendingIncomingObjects, STATGROUP_SpatialNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Incoming RPCs with unresolved refs"), STAT_SpatialPendingIncomingRPCs, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Purged incoming operations"), STAT_SpatialPurgedIncomingOperations, STATGROUP_SpatialNet);
+DECLARE_MEMORY_STAT(TEXT("Unresolved ref graph"), STAT_SpatialUnresolvedRefGraphMemory, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Dormant actors"), STAT_SpatialDormantActors, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Removal cache hits"), STAT_SpatialRemovalCacheHits, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Removal cache misses"), STAT_SpatialRemovalCacheMisses, STATGROUP_SpatialNet);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Removal cache hit rate"), STAT_SpatialRemovalCacheHitRate, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ring buffer RPCs applied"), STAT_SpatialRingBufferRPCsApplied, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Incoming RPCs queued"), STAT_SpatialIncomingRPCsQueued, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Queued incoming RPCs delivered"), STAT_SpatialIncomingRPCsDelivered, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Queued incoming RPCs delivered out of order"), STAT_SpatialIncomingRPCsOutOfOrder, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Queued incoming RPCs expired"), STAT_SpatialIncomingRPCsExpired, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Queued incoming reliable RPCs expired"), STAT_SpatialIncomingReliableRPCsExpired, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Incoming RPCs dropped by full queue"), STAT_SpatialIncomingRPCsDropped, STATGROUP_SpatialNet);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Average incoming RPC queue latency (ms)"), STAT_SpatialIncomingRPCAverageLatency, STATGROUP_SpatialNet);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Max incoming RPC queue latency (ms)"), STAT_SpatialIncomingRPCMaxLatency, STATGROUP_SpatialNet);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Oldest queued incoming RPC (s)"), STAT_SpatialOldestQueuedIncomingRPC, STATGROUP_SpatialNet);
+DECLARE_MEMORY_STAT(TEXT("Queued incoming RPC payloads"), STAT_SpatialQueuedIncomingRPCMemory, STATGROUP_SpatialNet);
+
 using namespace improbable;
 
 template <typename T>
 T* GetComponentData(USpatialReceiver& Receiver, Worker_EntityId EntityId)
 {
-	for (PendingAddComponentWrapper& PendingAddComponent : Receiver.PendingAddComponents)
+	if (const TArray<PendingAddComponentWrapper>* EntityComponents = Receiver.PendingAddComponents.Find(EntityId))
 	{
-		if (PendingAddComponent.EntityId == EntityId && PendingAddComponent.ComponentId == T::ComponentId)
+		for (const PendingAddComponentWrapper& PendingAddComponent : *EntityComponents)
 		{
-			return static_cast<T*>(PendingAddComponent.Data.Get());
+			if (PendingAddComponent.ComponentId == T::ComponentId)
+			{
+				return static_cast<T*>(PendingAddComponent.Data.Get());
+			}
 		}
 	}
 
 	return nullptr;
 }
 
+void FPendingAddComponentBuffer::Add(Worker_EntityId EntityId, Worker_ComponentId ComponentId, const TSharedPtr<improbable::Component>& Data)
+{
+	int32& ListIndex = EntityIndices.FindOrAdd(EntityId, INDEX_NONE);
+	if (ListIndex == INDEX_NONE)
+	{
+		ListIndex = NumUsedLists++;
+		if (ListIndex == ComponentLists.Num())
+		{
+			ComponentLists.AddDefaulted();
+		}
+	}
+
+	ComponentLists[ListIndex].Emplace(EntityId, ComponentId, Data);
+	NumComponents++;
+}
+
+const TArray<PendingAddComponentWrapper>* FPendingAddComponentBuffer::Find(Worker_EntityId EntityId) const
+{
+	const int32* ListIndex = EntityIndices.Find(EntityId);
+	return ListIndex != nullptr ? &ComponentLists[*ListIndex] : nullptr;
+}
+
+TArray<PendingAddComponentWrapper>* FPendingAddComponentBuffer::Find(Worker_EntityId EntityId)
+{
+	const int32* ListIndex = EntityIndices.Find(EntityId);
+	return ListIndex != nullptr ? &ComponentLists[*ListIndex] : nullptr;
+}
+
+void FPendingAddComponentBuffer::Reset()
+{
+	for (int32 i = 0; i < NumUsedLists; i++)
+	{
+		ComponentLists[i].Reset();
+	}
+
+	// Keep enough lists around for a critical section twice the size of this one, don't hold on to a huge initial checkout forever.
+	const int32 MaxPooledLists = NumUsedLists * 2 + 64;
+	if (ComponentLists.Num() > MaxPooledLists)
+	{
+		ComponentLists.SetNum(MaxPooledLists);
+	}
+
+	EntityIndices.Reset();
+	NumUsedLists = 0;
+	NumComponents = 0;
+}
+
+#if !UE_BUILD_SHIPPING
+void FPendingAddComponentBuffer::RunBenchmark(int32 NumEntities, int32 NumComponentsPerEntity, FOutputDevice& Ar)
+{
+	// Beyond this the flat array scan takes minutes.
+	const int32 MaxFlatScanEntities = 10000;
+
+	Ar.Logf(TEXT("Pending add component benchmark, %d components per entity (add all, then look up each entity's components):"), NumComponentsPerEntity);
+
+	FPendingAddComponentBuffer Buffer;
+	const TSharedPtr<improbable::Component> NoData;
+
+	for (int32 CheckoutSize = FMath::Max(NumEntities / 8, 1); ; CheckoutSize = FMath::Min(CheckoutSize * 2, NumEntities))
+	{
+		int64 Checksum = 0;
+
+		const double BufferStartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < CheckoutSize; i++)
+		{
+			for (int32 j = 0; j < NumComponentsPerEntity; j++)
+			{
+				Buffer.Add(i + 1, SpatialConstants::STARTING_GENERATED_COMPONENT_ID + j, NoData);
+			}
+		}
+		for (int32 i = 0; i < CheckoutSize; i++)
+		{
+			if (const TArray<PendingAddComponentWrapper>* EntityComponents = Buffer.Find(i + 1))
+			{
+				Checksum += EntityComponents->Num();
+			}
+		}
+		Buffer.Reset();
+		const double BufferSeconds = FPlatformTime::Seconds() - BufferStartTime;
+
+		FString FlatResult = TEXT("skipped");
+		if (CheckoutSize <= MaxFlatScanEntities)
+		{
+			TArray<PendingAddComponentWrapper> FlatComponents;
+
+			const double FlatStartTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < CheckoutSize; i++)
+			{
+				for (int32 j = 0; j < NumComponentsPerEntity; j++)
+				{
+					FlatComponents.Emplace(i + 1, SpatialConstants::STARTING_GENERATED_COMPONENT_ID + j, NoData);
+				}
+			}
+			for (int32 i = 0; i < CheckoutSize; i++)
+			{
+				for (const PendingAddComponentWrapper& PendingAddComponent : FlatComponents)
+				{
+					if (PendingAddComponent.EntityId == i + 1)
+					{
+						Checksum--;
+					}
+				}
+			}
+			const double FlatSeconds = FPlatformTime::Seconds() - FlatStartTime;
+
+			FlatResult = FString::Printf(TEXT("%.3fms (%.1fns per entity)"), FlatSeconds * 1000.0, FlatSeconds * 1000000000.0 / CheckoutSize);
+		}
+
+		Ar.Logf(TEXT("  %6d entities: per-entity buffer %.3fms (%.1fns per entity), flat array %s"),
+			CheckoutSize, BufferSeconds * 1000.0, BufferSeconds * 1000000000.0 / CheckoutSize, *FlatResult);
+
+		if (CheckoutSize <= MaxFlatScanEntities && Checksum != 0)
+		{
+			Ar.Logf(TEXT("  Checksum mismatch: %lld"), Checksum);
+		}
+
+		if (CheckoutSize == NumEntities)
+		{
+			break;
+		}
+	}
+}
+#endif // !UE_BUILD_SHIPPING
+
 void USpatialReceiver::Init(USpatialNetDriver* InNetDriver, FTimerManager* InTimerManager)
 {
 	NetDriver = InNetDriver;
@@ -48,7 +203,52 @@ void USpatialReceiver::Init(USpatialNetDriver* InNetDriver, FTimerManager* InTim
 	World = InNetDriver->GetWorld();
 	TypebindingManager = InNetDriver->TypebindingManager;
 	GlobalStateManager = InNetDriver->GlobalStateManager;
+	ActorPool = InNetDriver->ActorPool;
 	TimerManager = InTimerManager;
+
+	ComponentDecoder.Init(InNetDriver);
+
+	FParse::Value(FCommandLine::Get(), TEXT("removalCacheWindow"), RemovalCacheWindowSeconds);
+	RemovalCacheMaxEntities = SpatialConstants::REMOVAL_CACHE_DEFAULT_MAX_ENTITIES;
+	FParse::Value(FCommandLine::Get(), TEXT("removalCacheMaxEntities"), RemovalCacheMaxEntities);
+
+	// Like actor pooling, this is client-only: a server would keep replicating the dormant actors it has authority over.
+	bRemovalCacheEnabled = !NetDriver->IsServer() && RemovalCacheWindowSeconds > 0.0f && RemovalCacheMaxEntities > 0;
+	if (bRemovalCacheEnabled)
+	{
+		TimerManager->SetTimer(RemovalCacheTimerHandle, [this]()
+		{
+			ReleaseExpiredDormantActors();
+		}, RemovalCacheWindowSeconds * 0.25f, true);
+	}
+
+	IncomingRPCTimeToLive = SpatialConstants::INCOMING_RPC_DEFAULT_TIME_TO_LIVE_SECONDS;
+	MaxQueuedRPCsPerObject = SpatialConstants::INCOMING_RPC_DEFAULT_MAX_QUEUED_PER_OBJECT;
+	MaxQueuedRPCBytesPerObject = SpatialConstants::INCOMING_RPC_DEFAULT_MAX_QUEUED_BYTES_PER_OBJECT;
+	FParse::Value(FCommandLine::Get(), TEXT("incomingRPCTimeToLive"), IncomingRPCTimeToLive);
+	FParse::Value(FCommandLine::Get(), TEXT("maxQueuedRPCsPerObject"), MaxQueuedRPCsPerObject);
+	FParse::Value(FCommandLine::Get(), TEXT("maxQueuedRPCBytesPerObject"), MaxQueuedRPCBytesPerObject);
+
+	// Also refreshes the age of the oldest queued RPC, so it runs without a time to live as well.
+	TimerManager->SetTimer(IncomingRPCExpiryTimerHandle, [this]()
+	{
+		ExpireIncomingRPCs();
+	}, SpatialConstants::INCOMING_RPC_EXPIRY_CHECK_INTERVAL_SECONDS, true);
+}
+
+void USpatialReceiver::Shutdown()
+{
+	if (TimerManager != nullptr)
+	{
+		TimerManager->ClearTimer(RemovalCacheTimerHandle);
+		TimerManager->ClearTimer(IncomingRPCExpiryTimerHandle);
+	}
+
+	// A critical section cut short by the shutdown may still be decoding into the pending components.
+	ComponentDecoder.WaitForAll();
+	PendingAddComponents.Reset();
+	// These point into the op lists the dispatcher destroys.
+	PendingEntityOps.Reset();
 }
 
 void USpatialReceiver::OnCriticalSection(bool InCriticalSection)
@@ -67,6 +267,7 @@ void USpatialReceiver::EnterCriticalSection()
 {
 	UE_LOG(LogSpatialReceiver, Verbose, TEXT("Entering critical section."));
 	check(!bInCriticalSection);
+	check(!bApplyingCriticalSection);
 	bInCriticalSection = true;
 }
 
@@ -75,14 +276,73 @@ void USpatialReceiver::LeaveCriticalSection()
 	UE_LOG(LogSpatialReceiver, Verbose, TEXT("Leaving critical section."));
 	check(bInCriticalSection);
 
-	for (Worker_EntityId& PendingAddEntity : PendingAddEntities)
+	// Mark that we've left the critical section, the pending operations are applied by ApplyCriticalSection.
+	// Objects resolved while they are applied are queued until the end.
+	bInCriticalSection = false;
+	bApplyingCriticalSection = true;
+	NextPendingAddEntityIndex = 0;
+
+	DispatchComponentDecode();
+}
+
+void USpatialReceiver::DispatchComponentDecode()
+{
+	if (!ComponentDecoder.IsEnabled() || PendingAddEntities.Num() < SpatialConstants::COMPONENT_DECODE_MIN_BATCH_ENTITIES)
+	{
+		return;
+	}
+
+	// Queued in the order ApplyCriticalSection spawns the actors, so the first chunks are done by the time they're needed.
+	for (Worker_EntityId EntityId : PendingAddEntities)
+	{
+		TArray<PendingAddComponentWrapper>* EntityComponents = PendingAddComponents.Find(EntityId);
+		if (EntityComponents == nullptr)
+		{
+			continue;
+		}
+
+		for (PendingAddComponentWrapper& PendingAddComponent : *EntityComponents)
+		{
+			if (PendingAddComponent.Data.IsValid() && PendingAddComponent.Data->bIsDynamic)
+			{
+				TSharedPtr<FDecodedComponentData> DecodedData = MakeShared<FDecodedComponentData>();
+				if (ComponentDecoder.Add(EntityId, *static_cast<improbable::DynamicComponent*>(PendingAddComponent.Data.Get())->Data, *DecodedData))
+				{
+					PendingAddComponent.DecodedData = DecodedData;
+				}
+			}
+		}
+	}
+
+	ComponentDecoder.Dispatch();
+}
+
+bool USpatialReceiver::ApplyCriticalSection(uint64 DeadlineCycles)
+{
+	if (!bApplyingCriticalSection)
+	{
+		return true;
+	}
+
+	while (NextPendingAddEntityIndex < PendingAddEntities.Num())
 	{
-		ReceiveActor(PendingAddEntity);
+		const Worker_EntityId EntityId = PendingAddEntities[NextPendingAddEntityIndex++];
+
+		FPendingEntityOps EntityOps;
+		PendingEntityOps.RemoveAndCopyValue(EntityId, EntityOps);
+		ApplyPendingEntityOps(EntityId, EntityOps, true);
+
+		if (NextPendingAddEntityIndex < PendingAddEntities.Num() && FPlatformTime::Cycles64() >= DeadlineCycles)
+		{
+			UE_LOG(LogSpatialReceiver, Verbose, TEXT("Out of time for this tick, %d actors left to spawn."), PendingAddEntities.Num() - NextPendingAddEntityIndex);
+			return false;
+		}
 	}
 
-	for (Worker_AuthorityChangeOp& PendingAuthorityChange : PendingAuthorityChanges)
+	// What's left belongs to entities that were checked out before the critical section.
+	for (TPair<Worker_EntityId_Key, FPendingEntityOps>& Pair : PendingEntityOps)
 	{
-		HandleActorAuthority(PendingAuthorityChange);
+		ApplyPendingEntityOps(Pair.Key, Pair.Value, false);
 	}
 
 	for (Worker_EntityId& PendingRemoveEntity : PendingRemoveEntities)
@@ -90,14 +350,41 @@ void USpatialReceiver::LeaveCriticalSection()
 		RemoveActor(PendingRemoveEntity);
 	}
 
-	// Mark that we've left the critical section.
-	bInCriticalSection = false;
+	bApplyingCriticalSection = false;
+	NextPendingAddEntityIndex = 0;
 	PendingAddEntities.Empty();
-	PendingAddComponents.Empty();
-	PendingAuthorityChanges.Empty();
+	// Entities that were skipped may still be decoding into the pending components.
+	ComponentDecoder.WaitForAll();
+	PendingAddComponents.Reset();
+	PendingEntityOps.Empty();
 	PendingRemoveEntities.Empty();
 
 	ProcessQueuedResolvedObjects();
+
+	return true;
+}
+
+void USpatialReceiver::ApplyPendingEntityOps(Worker_EntityId EntityId, FPendingEntityOps& EntityOps, bool bCheckOutActor)
+{
+	for (const Worker_AddComponentOp& AddComponent : EntityOps.AddComponents)
+	{
+		StaticComponentView->OnAddComponent(AddComponent);
+	}
+
+	for (const Worker_AuthorityChangeOp& AuthorityChange : EntityOps.AuthorityChanges)
+	{
+		StaticComponentView->OnAuthorityChange(AuthorityChange);
+	}
+
+	if (bCheckOutActor)
+	{
+		ReceiveActor(EntityId);
+	}
+
+	for (Worker_AuthorityChangeOp& AuthorityChange : EntityOps.AuthorityChanges)
+	{
+		HandleActorAuthority(AuthorityChange);
+	}
 }
 
 void USpatialReceiver::OnAddEntity(Worker_AddEntityOp& Op)
@@ -121,6 +408,8 @@ void USpatialReceiver::OnAddComponent(Worker_AddComponentOp& Op)
 		return;
 	}
 
+	PendingEntityOps.FindOrAdd(Op.entity_id).AddComponents.Add(Op);
+
 	TSharedPtr<improbable::Component> Data;
 
 	switch (Op.data.component_id)
@@ -147,11 +436,13 @@ void USpatialReceiver::OnAddComponent(Worker_AddComponentOp& Op)
 		break;
 	}
 
-	PendingAddComponents.Emplace(Op.entity_id, Op.data.component_id, Data);
+	PendingAddComponents.Add(Op.entity_id, Op.data.component_id, Data);
 }
 
 void USpatialReceiver::OnRemoveEntity(Worker_RemoveEntityOp& Op)
 {
+	// Don't hand the view the components of an entity that is gone again before its critical section was applied.
+	PendingEntityOps.Remove(Op.entity_id);
 	RemoveActor(Op.entity_id);
 }
 
@@ -159,7 +450,7 @@ void USpatialReceiver::OnAuthorityChange(Worker_AuthorityChangeOp& Op)
 {
 	if (bInCriticalSection)
 	{
-		PendingAuthorityChanges.Add(Op);
+		PendingEntityOps.FindOrAdd(Op.entity_id).AuthorityChanges.Add(Op);
 		return;
 	}
 
@@ -169,6 +460,13 @@ void USpatialReceiver::OnAuthorityChange(Worker_AuthorityChangeOp& Op)
 // TODO UNR-640 - This function needs a pass once we introduce soft handover (AUTHORITY_LOSS_IMMINENT)
 void USpatialReceiver::HandleActorAuthority(Worker_AuthorityChangeOp& Op)
 {
+	if (Op.authority == WORKER_AUTHORITY_AUTHORITATIVE && IsRingBufferRPCComponent(Op.component_id))
+	{
+		const FClassInfo* Info = TypebindingManager->FindClassInfoByComponentId(Op.component_id);
+		const ESchemaComponentType Category = TypebindingManager->FindCategoryByComponentId(Op.component_id);
+		Sender->OnRingBufferAuthorityGained(Op.entity_id, Op.component_id, Info->SchemaComponents[GetRingBufferComponentType(Category)]);
+	}
+
 	if (NetDriver->IsServer())
 	{
 		if (Op.component_id == SpatialConstants::DEPLOYMENT_MAP_COMPONENT_ID)
@@ -207,6 +505,12 @@ void USpatialReceiver::HandleActorAuthority(Worker_AuthorityChangeOp& Op)
 					}
 
 					Actor->OnAuthorityGained();
+
+					if (USpatialActorChannel* Channel = NetDriver->GetActorChannelByEntityId(Op.entity_id))
+					{
+						// Now ready for replication, so the ACLs need to be brought up to date.
+						NetDriver->MarkOwnershipDirty(Channel);
+					}
 				}
 				else if (Op.authority == WORKER_AUTHORITY_AUTHORITY_LOSS_IMMINENT)
 				{
@@ -247,9 +551,13 @@ void USpatialReceiver::ReceiveActor(Worker_EntityId EntityId)
 	UEntityRegistry* EntityRegistry = NetDriver->GetEntityRegistry();
 	check(EntityRegistry);
 
-	improbable::Position* Position = StaticComponentView->GetComponentData<improbable::Position>(EntityId);
-	improbable::Rotation* Rotation = StaticComponentView->GetComponentData<improbable::Rotation>(EntityId);
-	improbable::UnrealMetadata* UnrealMetadata = StaticComponentView->GetComponentData<improbable::UnrealMetadata>(EntityId);
+	// Copied out of the view: spawning runs game code that can add or remove components, which moves the view's data.
+	improbable::Position PositionData;
+	improbable::Rotation RotationData;
+	improbable::UnrealMetadata UnrealMetadataData;
+	improbable::Position* Position = StaticComponentView->CopyComponentData(EntityId, PositionData) ? &PositionData : nullptr;
+	improbable::Rotation* Rotation = StaticComponentView->CopyComponentData(EntityId, RotationData) ? &RotationData : nullptr;
+	improbable::UnrealMetadata* UnrealMetadata = StaticComponentView->CopyComponentData(EntityId, UnrealMetadataData) ? &UnrealMetadataData : nullptr;
 
 	if (UnrealMetadata == nullptr)
 	{
@@ -257,6 +565,23 @@ void USpatialReceiver::ReceiveActor(Worker_EntityId EntityId)
 		return;
 	}
 
+	if (DormantActors.Contains(EntityId))
+	{
+		if (ReviveDormantActor(EntityId, Position, Rotation))
+		{
+			return;
+		}
+
+		ReleaseDormantActor(EntityId);
+	}
+
+	if (bRemovalCacheEnabled)
+	{
+		NumRemovalCacheMisses++;
+		INC_DWORD_STAT(STAT_SpatialRemovalCacheMisses);
+		UpdateRemovalCacheStats();
+	}
+
 	if (AActor* EntityActor = EntityRegistry->GetActorFromEntityId(EntityId))
 	{
 		UE_LOG(LogSpatialReceiver, Log, TEXT("Entity for actor %s has been checked out on the worker which spawned it."), *EntityActor->GetName());
@@ -291,17 +616,15 @@ void USpatialReceiver::ReceiveActor(Worker_EntityId EntityId)
 		}
 
 		UNetConnection* Connection = nullptr;
-		improbable::UnrealMetadata* UnrealMetadataComponent = StaticComponentView->GetComponentData<improbable::UnrealMetadata>(EntityId);
-		check(UnrealMetadataComponent);
 		bool bDoingDeferredSpawn = false;
 
 		// If we're checking out a player controller, spawn it via "USpatialNetDriver::AcceptNewPlayer"
 		if (NetDriver->IsServer() && ActorClass->IsChildOf(APlayerController::StaticClass()))
 		{
-			checkf(!UnrealMetadataComponent->OwnerWorkerAttribute.IsEmpty(), TEXT("A player controller entity must have an owner worker attribute."));
+			checkf(!UnrealMetadata->OwnerWorkerAttribute.IsEmpty(), TEXT("A player controller entity must have an owner worker attribute."));
 
 			FString URLString = FURL().ToString();
-			URLString += TEXT("?workerAttribute=") + UnrealMetadataComponent->OwnerWorkerAttribute;
+			URLString += TEXT("?workerAttribute=") + UnrealMetadata->OwnerWorkerAttribute;
 
 			Connection = NetDriver->AcceptNewPlayer(FURL(nullptr, *URLString, TRAVEL_Absolute), true);
 			check(Connection);
@@ -310,16 +633,27 @@ void USpatialReceiver::ReceiveActor(Worker_EntityId EntityId)
 		}
 		else
 		{
-			UE_LOG(LogSpatialReceiver, Verbose, TEXT("Spawning a %s whilst checking out an entity."), *ActorClass->GetFullName());
+			FVector InitialLocation = improbable::Coordinates::ToFVector(Position->Coords);
+			FVector SpawnLocation = FRepMovement::RebaseOntoLocalOrigin(InitialLocation, World->OriginLocation);
+
+			// Pooled actors have already finished spawning, so only fresh spawns go through the deferred path.
+			EntityActor = ActorPool->AcquireActor(ActorClass, FTransform(Rotation->ToFRotator(), SpawnLocation));
+			if (EntityActor != nullptr)
+			{
+				UE_LOG(LogSpatialReceiver, Verbose, TEXT("Reusing pooled %s whilst checking out an entity."), *EntityActor->GetName());
+			}
+			else
+			{
+				UE_LOG(LogSpatialReceiver, Verbose, TEXT("Spawning a %s whilst checking out an entity."), *ActorClass->GetFullName());
 
-			EntityActor = CreateActor(Position, Rotation, ActorClass, true);
+				EntityActor = CreateActor(Position, Rotation, ActorClass, true);
+				bDoingDeferredSpawn = true;
+			}
 
 			// Don't have authority over Actor until SpatialOS delegates authority
 			EntityActor->Role = ROLE_SimulatedProxy;
 			EntityActor->RemoteRole = ROLE_Authority;
 
-			bDoingDeferredSpawn = true;
-
 			// Get the net connection for this actor.
 			if (NetDriver->IsServer())
 			{
@@ -363,12 +697,19 @@ void USpatialReceiver::ReceiveActor(Worker_EntityId EntityId)
 		// Apply initial replicated properties.
 		// This was moved to after FinishingSpawning because components existing only in blueprints aren't added until spawning is complete
 		// Potentially we could split out the initial actor state and the initial component state
-		for (PendingAddComponentWrapper& PendingAddComponent : PendingAddComponents)
+		if (const TArray<PendingAddComponentWrapper>* EntityComponents = PendingAddComponents.Find(EntityId))
 		{
-			if (PendingAddComponent.EntityId == EntityId && PendingAddComponent.Data.IsValid() && PendingAddComponent.Data->bIsDynamic)
+			ComponentDecoder.WaitForEntity(EntityId);
+
+			for (const PendingAddComponentWrapper& PendingAddComponent : *EntityComponents)
 			{
-				ApplyComponentData(EntityId, *static_cast<improbable::DynamicComponent*>(PendingAddComponent.Data.Get())->Data, Channel);
+				if (PendingAddComponent.Data.IsValid() && PendingAddComponent.Data->bIsDynamic)
+				{
+					ApplyComponentData(EntityId, *static_cast<improbable::DynamicComponent*>(PendingAddComponent.Data.Get())->Data, Channel, PendingAddComponent.DecodedData.Get());
+				}
 			}
+
+			ApplyCheckedOutRingBufferRPCs(EntityId, *EntityComponents);
 		}
 
 		if (!NetDriver->IsServer())
@@ -445,6 +786,17 @@ void USpatialReceiver::RemoveActor(Worker_EntityId EntityId)
 		return;
 	}
 
+	if (bRemovalCacheEnabled && !Actor->IsA<APlayerController>())
+	{
+		MakeActorDormant(Actor, EntityId);
+		return;
+	}
+
+	DestroyActor(Actor, EntityId);
+}
+
+void USpatialReceiver::DestroyActor(AActor* Actor, Worker_EntityId EntityId)
+{
 	// Destruction of actors can cause the destruction of associated actors (eg. Character > Controller). Actor destroy
 	// calls will eventually find their way into USpatialActorChannel::DeleteEntityIfAuthoritative() which checks if the entity
 	// is currently owned by this worker before issuing an entity delete request. If the associated entity is still authoritative 
@@ -458,30 +810,174 @@ void USpatialReceiver::RemoveActor(Worker_EntityId EntityId)
 	// TODO: fix this with working sets (UNR-411)
 	NetDriver->StartIgnoringAuthoritativeDestruction();
 
-	// Clean up the actor channel. For clients, this will also call destroy on the actor.
+	const bool bReturnToPool = ActorPool->IsPoolable(Actor);
+
+	// Clean up the actor channel. For clients, this will also call destroy on the actor,
+	// unless it's marked as net temporary, which is how actors that go back to the pool are kept alive.
 	if (USpatialActorChannel* ActorChannel = NetDriver->GetActorChannelByEntityId(EntityId))
 	{
+		const bool bWasNetTemporary = Actor->bNetTemporary;
+		Actor->bNetTemporary |= bReturnToPool;
 		ActorChannel->ConditionalCleanUp();
+		Actor->bNetTemporary = bWasNetTemporary;
 	}
 	else
 	{
 		UE_LOG(LogSpatialReceiver, Warning, TEXT("Removing actor as a result of a remove entity op but cannot find the actor channel! Actor: %s %lld"), *Actor->GetName(), EntityId);
 	}
 
-	// It is safe to call AActor::Destroy even if the destruction has already started.
-	if (!Actor->Destroy(true))
+	if (!(bReturnToPool && ActorPool->ReleaseActor(Actor)))
 	{
-		UE_LOG(LogSpatialReceiver, Error, TEXT("Failed to destroy actor in RemoveActor %s %lld"), *Actor->GetName(), EntityId);
+		// It is safe to call AActor::Destroy even if the destruction has already started.
+		if (!Actor->Destroy(true))
+		{
+			UE_LOG(LogSpatialReceiver, Error, TEXT("Failed to destroy actor in RemoveActor %s %lld"), *Actor->GetName(), EntityId);
+		}
 	}
 	NetDriver->StopIgnoringAuthoritativeDestruction();
 
 	CleanupDeletedEntity(EntityId);
 }
 
-void USpatialReceiver::CleanupDeletedEntity(Worker_EntityId EntityId)
+void USpatialReceiver::MakeActorDormant(AActor* Actor, Worker_EntityId EntityId)
 {
+	if (DormantActors.Num() >= RemovalCacheMaxEntities)
+	{
+		Worker_EntityId OldestEntityId = SpatialConstants::INVALID_ENTITY_ID;
+		double OldestRemovalTime = MAX_dbl;
+		for (const auto& Pair : DormantActors)
+		{
+			if (Pair.Value.RemovalTime < OldestRemovalTime)
+			{
+				OldestEntityId = Pair.Key;
+				OldestRemovalTime = Pair.Value.RemovalTime;
+			}
+		}
+
+		ReleaseDormantActor(OldestEntityId);
+	}
+
+	UE_LOG(LogSpatialReceiver, Verbose, TEXT("Keeping actor %s dormant after its entity %lld left the view."), *Actor->GetName(), EntityId);
+
+	USpatialActorPool::SetActorActive(Actor, false);
+	DormantActors.Add(EntityId, FDormantActor{ Actor, FPlatformTime::Seconds() });
+	UpdateRemovalCacheStats();
+
+	// The entity is gone as far as the rest of the worker is concerned. The channel is kept, it's only found by entity id.
+	PurgePendingIncomingOperations(EntityId);
 	Cast<USpatialPackageMapClient>(NetDriver->GetSpatialOSNetConnection()->PackageMap)->RemoveEntityActor(EntityId);
 	NetDriver->GetEntityRegistry()->RemoveFromRegistry(EntityId);
+}
+
+bool USpatialReceiver::ReviveDormantActor(Worker_EntityId EntityId, improbable::Position* Position, improbable::Rotation* Rotation)
+{
+	AActor* EntityActor = DormantActors[EntityId].Actor.Get();
+	USpatialActorChannel* Channel = NetDriver->GetActorChannelByEntityId(EntityId);
+	if (EntityActor == nullptr || EntityActor->IsPendingKill() || Channel == nullptr)
+	{
+		return false;
+	}
+
+	DormantActors.Remove(EntityId);
+	NumRemovalCacheHits++;
+	INC_DWORD_STAT(STAT_SpatialRemovalCacheHits);
+	UpdateRemovalCacheStats();
+
+	UE_LOG(LogSpatialReceiver, Verbose, TEXT("Reviving dormant actor %s for entity %lld."), *EntityActor->GetName(), EntityId);
+
+	// Also resolves whatever was waiting on a reference to the entity.
+	NetDriver->GetEntityRegistry()->AddToRegistry(EntityId, EntityActor);
+	FClassInfo* Info = TypebindingManager->FindClassInfoByClass(EntityActor->GetClass());
+	Cast<USpatialPackageMapClient>(NetDriver->GetSpatialOSNetConnection()->PackageMap)->ResolveEntityActor(EntityActor, EntityId, improbable::CreateOffsetMapFromActor(EntityActor, Info));
+
+	FVector InitialLocation = improbable::Coordinates::ToFVector(Position->Coords);
+	FVector SpawnLocation = FRepMovement::RebaseOntoLocalOrigin(InitialLocation, World->OriginLocation);
+	EntityActor->SetActorTransform(FTransform(Rotation->ToFRotator(), SpawnLocation), false, nullptr, ETeleportType::TeleportPhysics);
+	USpatialActorPool::SetActorActive(EntityActor, true);
+
+	if (const TArray<PendingAddComponentWrapper>* EntityComponents = PendingAddComponents.Find(EntityId))
+	{
+		ComponentDecoder.WaitForEntity(EntityId);
+
+		for (const PendingAddComponentWrapper& PendingAddComponent : *EntityComponents)
+		{
+			if (PendingAddComponent.Data.IsValid() && PendingAddComponent.Data->bIsDynamic)
+			{
+				ApplyComponentData(EntityId, *static_cast<improbable::DynamicComponent*>(PendingAddComponent.Data.Get())->Data, Channel, PendingAddComponent.DecodedData.Get());
+			}
+		}
+
+		ApplyCheckedOutRingBufferRPCs(EntityId, *EntityComponents);
+	}
+
+	Sender->SendComponentInterest(EntityActor, EntityId);
+	EntityActor->UpdateOverlaps();
+
+	return true;
+}
+
+void USpatialReceiver::ReleaseDormantActor(Worker_EntityId EntityId)
+{
+	FDormantActor DormantActor;
+	if (!DormantActors.RemoveAndCopyValue(EntityId, DormantActor))
+	{
+		return;
+	}
+	UpdateRemovalCacheStats();
+
+	// RemoveActor already did the player controller and pawn handling before the actor went dormant.
+	AActor* Actor = DormantActor.Actor.Get();
+	if (Actor != nullptr && !Actor->IsPendingKill())
+	{
+		DestroyActor(Actor, EntityId);
+		return;
+	}
+
+	if (USpatialActorChannel* ActorChannel = NetDriver->GetActorChannelByEntityId(EntityId))
+	{
+		ActorChannel->ConditionalCleanUp();
+	}
+	CleanupDeletedEntity(EntityId);
+}
+
+void USpatialReceiver::ReleaseExpiredDormantActors()
+{
+	const double ExpiryTime = FPlatformTime::Seconds() - RemovalCacheWindowSeconds;
+
+	TArray<Worker_EntityId> ExpiredEntities;
+	for (const auto& Pair : DormantActors)
+	{
+		if (Pair.Value.RemovalTime <= ExpiryTime)
+		{
+			ExpiredEntities.Add(Pair.Key);
+		}
+	}
+
+	for (Worker_EntityId EntityId : ExpiredEntities)
+	{
+		ReleaseDormantActor(EntityId);
+	}
+}
+
+void USpatialReceiver::UpdateRemovalCacheStats() const
+{
+	const uint32 NumLookups = NumRemovalCacheHits + NumRemovalCacheMisses;
+
+	SET_DWORD_STAT(STAT_SpatialDormantActors, DormantActors.Num());
+	SET_FLOAT_STAT(STAT_SpatialRemovalCacheHitRate, NumLookups > 0 ? float(NumRemovalCacheHits) / NumLookups : 0.0f);
+}
+
+void USpatialReceiver::CleanupDeletedEntity(Worker_EntityId EntityId)
+{
+	PurgePendingIncomingOperations(EntityId);
+	DormantActors.Remove(EntityId);
+	Sender->RemoveRingBuffers(EntityId);
+	Cast<USpatialPackageMapClient>(NetDriver->GetSpatialOSNetConnection()->PackageMap)->RemoveEntityActor(EntityId);
+	// Dormant actors have already been taken out of the registry.
+	if (NetDriver->GetEntityRegistry()->GetActorFromEntityId(EntityId) != nullptr)
+	{
+		NetDriver->GetEntityRegistry()->RemoveFromRegistry(EntityId);
+	}
 	NetDriver->RemoveActorChannel(EntityId);
 }
 
@@ -510,7 +1006,7 @@ AActor* USpatialReceiver::CreateActor(improbable::Position* Position, improbable
 	return NewActor;
 }
 
-void USpatialReceiver::ApplyComponentData(Worker_EntityId EntityId, Worker_ComponentData& Data, USpatialActorChannel* Channel)
+void USpatialReceiver::ApplyComponentData(Worker_EntityId EntityId, Worker_ComponentData& Data, USpatialActorChannel* Channel, const FDecodedComponentData* DecodedData)
 {
 	uint32 Offset = 0;
 	bool bFoundOffset = TypebindingManager->FindOffsetByComponentId(Data.component_id, Offset);
@@ -536,23 +1032,44 @@ void USpatialReceiver::ApplyComponentData(Worker_EntityId EntityId, Worker_Compo
 
 	if (ComponentType == SCHEMA_Data || ComponentType == SCHEMA_OwnerOnly)
 	{
-		FObjectReferencesMap& ObjectReferencesMap = UnresolvedRefsMap.FindOrAdd(ChannelObjectPair);
+		FPendingIncomingProperties& PendingProperties = FindOrAddPendingIncomingProperties(ChannelObjectPair, EntityId);
 		TSet<FUnrealObjectRef> UnresolvedRefs;
 
-		ComponentReader Reader(NetDriver, ObjectReferencesMap, UnresolvedRefs);
-		Reader.ApplyComponentData(Data, TargetObject, Channel, /* bIsHandover */ false);
+		ComponentReader Reader(NetDriver, PendingProperties.ObjectReferencesMap, UnresolvedRefs);
+		if (DecodedData != nullptr)
+		{
+			Reader.ApplyDecodedComponentData(*DecodedData, TargetObject, Channel, /* bIsHandover */ false);
+		}
+		else
+		{
+			Reader.ApplyComponentData(Data, TargetObject, Channel, /* bIsHandover */ false);
+		}
 
-		QueueIncomingRepUpdates(ChannelObjectPair, ObjectReferencesMap, UnresolvedRefs);
+		QueueIncomingRepUpdates(ChannelObjectPair, PendingProperties, UnresolvedRefs);
 	}
 	else if (ComponentType == SCHEMA_Handover)
 	{
-		FObjectReferencesMap& ObjectReferencesMap = UnresolvedRefsMap.FindOrAdd(ChannelObjectPair);
+		FPendingIncomingProperties& PendingProperties = FindOrAddPendingIncomingProperties(ChannelObjectPair, EntityId);
 		TSet<FUnrealObjectRef> UnresolvedRefs;
 
-		ComponentReader Reader(NetDriver, ObjectReferencesMap, UnresolvedRefs);
-		Reader.ApplyComponentData(Data, TargetObject, Channel, /* bIsHandover */ true);
+		ComponentReader Reader(NetDriver, PendingProperties.ObjectReferencesMap, UnresolvedRefs);
+		if (DecodedData != nullptr)
+		{
+			Reader.ApplyDecodedComponentData(*DecodedData, TargetObject, Channel, /* bIsHandover */ true);
+		}
+		else
+		{
+			Reader.ApplyComponentData(Data, TargetObject, Channel, /* bIsHandover */ true);
+		}
 
-		QueueIncomingRepUpdates(ChannelObjectPair, ObjectReferencesMap, UnresolvedRefs);
+		QueueIncomingRepUpdates(ChannelObjectPair, PendingProperties, UnresolvedRefs);
+	}
+	else if (IsRingBufferRPCComponent(Data.component_id))
+	{
+		// Remember where the ring buffer is, both to carry on from there if we write it and to know which of its RPCs
+		// are already acked. The RPCs are applied once all components are in, see ApplyCheckedOutRingBufferRPCs.
+		Schema_Object* FieldsObject = Schema_GetComponentDataFields(Data.schema_type);
+		Sender->MirrorRingBuffer(EntityId, Data.component_id, FieldsObject);
 	}
 	else
 	{
@@ -651,6 +1168,10 @@ void USpatialReceiver::OnComponentUpdate(Worker_ComponentUpdateOp& Op)
 			ReceiveMulticastUpdate(Op.update, TargetObject, *RPCArray);
 		}
 	}
+	else if ((Category == ESchemaComponentType::SCHEMA_ClientRPC || Category == ESchemaComponentType::SCHEMA_ServerRPC) && Info->bHasRPCRingBuffers)
+	{
+		ReceiveRingBufferUpdate(Op.entity_id, Op.update, TargetObject, *Info, Category);
+	}
 	else
 	{
 		UE_LOG(LogSpatialReceiver, Verbose, TEXT("Entity: %d Component: %d - Skipping because it's an empty component update from an RPC component. (most likely as a result of gaining authority)"), Op.entity_id, Op.update.component_id);
@@ -707,7 +1228,7 @@ void USpatialReceiver::OnCommandRequest(Worker_CommandRequestOp& Op)
 
 	UFunction* Function = (*RPCArray)[CommandIndex - 1];
 
-	ReceiveRPCCommandRequest(Op.request, TargetObject, Function);
+	ReceiveRPCCommandRequest(Op.request, TargetObject, Function, *RPCArray);
 
 	Sender->SendCommandResponse(Op.request_id, Response);
 }
@@ -724,55 +1245,79 @@ void USpatialReceiver::OnCommandResponse(Worker_CommandResponseOp& Op)
 
 void USpatialReceiver::ReceiveCommandResponse(Worker_CommandResponseOp& Op)
 {
-	TSharedRef<FPendingRPCParams>* ReliableRPCPtr = PendingReliableRPCs.Find(Op.request_id);
-	if (ReliableRPCPtr == nullptr)
+	FReliableRPCBatch* ReliableRPCsPtr = PendingReliableRPCs.Find(Op.request_id);
+	if (ReliableRPCsPtr == nullptr)
 	{
-		// We received a response for an unreliable RPC, ignore.
+		// We received a response for an unreliable RPC, nothing to retry.
+		Sender->OnRPCCommandResponse(Op.request_id, 0);
 		return;
 	}
 
-	TSharedRef<FPendingRPCParams> ReliableRPC = *ReliableRPCPtr;
+	FReliableRPCBatch ReliableRPCs = MoveTemp(*ReliableRPCsPtr);
 	PendingReliableRPCs.Remove(Op.request_id);
-	if (Op.status_code != WORKER_STATUS_CODE_SUCCESS)
+	if (Op.status_code == WORKER_STATUS_CODE_SUCCESS)
 	{
-		if (ReliableRPC->Attempts < SpatialConstants::MAX_NUMBER_COMMAND_ATTEMPTS)
-		{
-			float WaitTime = SpatialConstants::GetCommandRetryWaitTimeSeconds(ReliableRPC->Attempts);
-			UE_LOG(LogSpatialReceiver, Log, TEXT("%s: retrying in %f seconds. Error code: %d Message: %s"),
-				*ReliableRPC->Function->GetName(), WaitTime, (int)Op.status_code, UTF8_TO_TCHAR(Op.message));
-
-			if (!ReliableRPC->TargetObject.IsValid())
-			{
-				UE_LOG(LogSpatialReceiver, Warning, TEXT("%s: target object was destroyed before we could deliver the RPC."),
-					*ReliableRPC->Function->GetName());
-				return;
-			}
+		Sender->OnRPCCommandResponse(Op.request_id, 0);
+		NetDriver->RetryScheduler->ReportSuccess(Op.entity_id);
+		return;
+	}
 
-			// Queue retry
-			FTimerHandle RetryTimer;
-			TimerManager->SetTimer(RetryTimer, [this, ReliableRPC]()
-			{
-				Sender->SendRPC(ReliableRPC);
-			}, WaitTime, false);
-		}
-		else
+	NetDriver->RetryScheduler->ReportFailure(Op.entity_id);
+
+	// The reliable RPCs of a batched request are retried together, and sent again in the same order.
+	FReliableRPCBatch RetriedRPCs;
+	uint32 MaxAttempts = 0;
+	for (const TSharedRef<FPendingRPCParams>& ReliableRPC : ReliableRPCs)
+	{
+		if ((uint32)ReliableRPC->Attempts >= SpatialConstants::MAX_NUMBER_COMMAND_ATTEMPTS)
 		{
 			UE_LOG(LogSpatialReceiver, Error, TEXT("%s: failed too many times, giving up (%u attempts). Error code: %d Message: %s"),
 				*ReliableRPC->Function->GetName(), SpatialConstants::MAX_NUMBER_COMMAND_ATTEMPTS, (int)Op.status_code, UTF8_TO_TCHAR(Op.message));
+			continue;
+		}
+
+		if (!ReliableRPC->TargetObject.IsValid())
+		{
+			UE_LOG(LogSpatialReceiver, Warning, TEXT("%s: target object was destroyed before we could deliver the RPC."),
+				*ReliableRPC->Function->GetName());
+			continue;
 		}
+
+		MaxAttempts = FMath::Max(MaxAttempts, (uint32)ReliableRPC->Attempts);
+		RetriedRPCs.Add(ReliableRPC);
 	}
+
+	Sender->OnRPCCommandResponse(Op.request_id, RetriedRPCs.Num());
+	if (RetriedRPCs.Num() == 0)
+	{
+		return;
+	}
+
+	float WaitTime = SpatialConstants::GetCommandRetryWaitTimeSeconds(MaxAttempts);
+	UE_LOG(LogSpatialReceiver, Log, TEXT("%s: retrying %d RPCs in %f seconds. Error code: %d Message: %s"),
+		*RetriedRPCs[0]->Function->GetName(), RetriedRPCs.Num(), WaitTime, (int)Op.status_code, UTF8_TO_TCHAR(Op.message));
+
+	const Worker_RequestId RequestId = Op.request_id;
+	NetDriver->RetryScheduler->ScheduleRetry(Op.entity_id, WaitTime, [this, RequestId, RetriedRPCs]()
+	{
+		Sender->OnRPCRetryDue(RequestId);
+		for (const TSharedRef<FPendingRPCParams>& ReliableRPC : RetriedRPCs)
+		{
+			Sender->SendRPC(ReliableRPC);
+		}
+	});
 }
 
 void USpatialReceiver::ApplyComponentUpdate(const Worker_ComponentUpdate& ComponentUpdate, UObject* TargetObject, USpatialActorChannel* Channel, bool bIsHandover)
 {
 	FChannelObjectPair ChannelObjectPair(Channel, TargetObject);
 
-	FObjectReferencesMap& ObjectReferencesMap = UnresolvedRefsMap.FindOrAdd(ChannelObjectPair);
+	FPendingIncomingProperties& PendingProperties = FindOrAddPendingIncomingProperties(ChannelObjectPair, Channel->GetEntityId());
 	TSet<FUnrealObjectRef> UnresolvedRefs;
-	ComponentReader Reader(NetDriver, ObjectReferencesMap, UnresolvedRefs);
+	ComponentReader Reader(NetDriver, PendingProperties.ObjectReferencesMap, UnresolvedRefs);
 	Reader.ApplyComponentUpdate(ComponentUpdate, TargetObject, Channel, bIsHandover);
 
-	QueueIncomingRepUpdates(ChannelObjectPair, ObjectReferencesMap, UnresolvedRefs);
+	QueueIncomingRepUpdates(ChannelObjectPair, PendingProperties, UnresolvedRefs);
 }
 
 void USpatialReceiver::ReceiveMulticastUpdate(const Worker_ComponentUpdate& ComponentUpdate, UObject* TargetObject, const TArray<UFunction*>& RPCArray)
@@ -786,7 +1331,7 @@ void USpatialReceiver::ReceiveMulticastUpdate(const Worker_ComponentUpdate& Comp
 		{
 			Schema_Object* EventData = Schema_IndexObject(EventsObject, EventIndex, i);
 
-			TArray<uint8> PayloadData = GetPayloadFromSchema(EventData, 1);
+			FSchemaPayloadView PayloadData = GetPayloadViewFromSchema(EventData, 1);
 			// A bit hacky, we should probably include the number of bits with the data instead.
 			int64 CountBits = PayloadData.Num() * 8;
 
@@ -795,14 +1340,131 @@ void USpatialReceiver::ReceiveMulticastUpdate(const Worker_ComponentUpdate& Comp
 	}
 }
 
-void USpatialReceiver::ApplyRPC(UObject* TargetObject, UFunction* Function, TArray<uint8>& PayloadData, int64 CountBits)
+void USpatialReceiver::ReceiveRingBufferUpdate(Worker_EntityId EntityId, const Worker_ComponentUpdate& ComponentUpdate, UObject* TargetObject, const FClassInfo& Info, ESchemaComponentType Category)
+{
+	Schema_Object* FieldsObject = Schema_GetComponentUpdateFields(ComponentUpdate.schema_type);
+
+	// The acks and RPC ids for this component's ring buffer are kept with the component for the other direction, which we write.
+	const Worker_ComponentId OwnComponentId = Info.SchemaComponents[GetRingBufferComponentType(Category)];
+
+	if (Schema_GetUint64Count(FieldsObject, SpatialConstants::UNREAL_RPC_RING_BUFFER_LAST_ACKED_ID) > 0)
+	{
+		Sender->OnRingBufferRPCsAcked(EntityId, OwnComponentId, Schema_GetUint64(FieldsObject, SpatialConstants::UNREAL_RPC_RING_BUFFER_LAST_ACKED_ID));
+	}
+
+	Sender->MirrorRingBuffer(EntityId, ComponentUpdate.component_id, FieldsObject);
+
+	// Only the worker writing the acks applies the RPCs, everyone else just keeps track of the ids for a handover.
+	if (StaticComponentView->HasAuthority(EntityId, OwnComponentId))
+	{
+		ApplyRingBufferRPCs(EntityId, FieldsObject, TargetObject, Info, Category);
+	}
+}
+
+void USpatialReceiver::ApplyCheckedOutRingBufferRPCs(Worker_EntityId EntityId, const TArray<PendingAddComponentWrapper>& EntityComponents)
+{
+	// Whatever the ring buffers held when we checked the entity out hasn't been acked yet past last_acked_rpc_id. If we
+	// already write the acks, nobody else is going to apply those RPCs.
+	for (const PendingAddComponentWrapper& PendingAddComponent : EntityComponents)
+	{
+		if (!PendingAddComponent.Data.IsValid() || !PendingAddComponent.Data->bIsDynamic)
+		{
+			continue;
+		}
+
+		const Worker_ComponentData& Data = *static_cast<improbable::DynamicComponent*>(PendingAddComponent.Data.Get())->Data;
+		if (!IsRingBufferRPCComponent(Data.component_id))
+		{
+			continue;
+		}
+
+		const FClassInfo* Info = TypebindingManager->FindClassInfoByComponentId(Data.component_id);
+		const ESchemaComponentType Category = TypebindingManager->FindCategoryByComponentId(Data.component_id);
+		if (!StaticComponentView->HasAuthority(EntityId, Info->SchemaComponents[GetRingBufferComponentType(Category)]))
+		{
+			continue;
+		}
+
+		uint32 Offset = 0;
+		if (!TypebindingManager->FindOffsetByComponentId(Data.component_id, Offset))
+		{
+			continue;
+		}
+
+		if (UObject* TargetObject = PackageMap->GetObjectFromUnrealObjectRef(FUnrealObjectRef(EntityId, Offset)))
+		{
+			ApplyRingBufferRPCs(EntityId, Schema_GetComponentDataFields(Data.schema_type), TargetObject, *Info, Category);
+		}
+	}
+}
+
+void USpatialReceiver::ApplyRingBufferRPCs(Worker_EntityId EntityId, Schema_Object* FieldsObject, UObject* TargetObject, const FClassInfo& Info, ESchemaComponentType Category)
+{
+	const ESchemaComponentType RPCType = GetRingBufferComponentType(Category);
+	const Worker_ComponentId OwnComponentId = Info.SchemaComponents[RPCType];
+
+	const TArray<UFunction*>* RPCArray = Info.RPCs.Find(RPCType);
+	const uint32 RPCCount = Schema_GetObjectCount(FieldsObject, SpatialConstants::UNREAL_RPC_RING_BUFFER_RPCS_ID);
+	if (RPCArray == nullptr || RPCCount == 0)
+	{
+		return;
+	}
+
+	// Unacknowledged RPCs are resent with every update, skip the ones already applied.
+	const uint64 LastAppliedRPCId = Sender->GetLastAppliedRingBufferRPCId(EntityId, OwnComponentId);
+	uint64 NewLastAppliedRPCId = LastAppliedRPCId;
+	TWeakObjectPtr<UObject> WeakTargetObject = TargetObject;
+
+	for (uint32 i = 0; i < RPCCount && WeakTargetObject.IsValid(); i++)
+	{
+		Schema_Object* RPCObject = Schema_IndexObject(FieldsObject, SpatialConstants::UNREAL_RPC_RING_BUFFER_RPCS_ID, i);
+
+		const uint64 RPCId = Schema_GetUint64(RPCObject, SpatialConstants::UNREAL_RING_BUFFERED_RPC_ID_ID);
+		if (RPCId <= LastAppliedRPCId)
+		{
+			continue;
+		}
+		NewLastAppliedRPCId = FMath::Max(NewLastAppliedRPCId, RPCId);
+
+		const uint32 CommandIndex = Schema_GetUint32(RPCObject, SpatialConstants::UNREAL_RING_BUFFERED_RPC_COMMAND_INDEX_ID);
+		if (CommandIndex == 0 || (int32)CommandIndex > RPCArray->Num())
+		{
+			UE_LOG(LogSpatialReceiver, Warning, TEXT("Ring buffer RPC %llu on %s has invalid command index %u, skipping it."), RPCId, *TargetObject->GetName(), CommandIndex);
+			continue;
+		}
+
+		FSchemaPayloadView PayloadData = GetPayloadViewFromSchema(RPCObject, SpatialConstants::UNREAL_RING_BUFFERED_RPC_PAYLOAD_ID);
+		ApplyRPC(TargetObject, (*RPCArray)[CommandIndex - 1], PayloadData, PayloadData.Num() * 8);
+		INC_DWORD_STAT(STAT_SpatialRingBufferRPCsApplied);
+	}
+
+	if (NewLastAppliedRPCId != LastAppliedRPCId)
+	{
+		Sender->AckRingBufferRPCs(EntityId, OwnComponentId, NewLastAppliedRPCId);
+	}
+}
+
+bool USpatialReceiver::IsRingBufferRPCComponent(Worker_ComponentId ComponentId)
+{
+	const ESchemaComponentType Category = TypebindingManager->FindCategoryByComponentId(ComponentId);
+	if (Category != SCHEMA_ClientRPC && Category != SCHEMA_ServerRPC)
+	{
+		return false;
+	}
+
+	// Whichever transport we send with, the other side may be putting RPCs or acks into both components.
+	const FClassInfo* Info = TypebindingManager->FindClassInfoByComponentId(ComponentId);
+	return Info != nullptr && Info->bHasRPCRingBuffers;
+}
+
+void USpatialReceiver::ApplyRPC(UObject* TargetObject, UFunction* Function, FSchemaPayloadView PayloadData, int64 CountBits)
 {
 	uint8* Parms = (uint8*)FMemory_Alloca(Function->ParmsSize);
 	FMemory::Memzero(Parms, Function->ParmsSize);
 
 	TSet<FUnrealObjectRef> UnresolvedRefs;
 
-	FSpatialNetBitReader PayloadReader(PackageMap, PayloadData.GetData(), CountBits, UnresolvedRefs);
+	FSpatialNetBitReader PayloadReader(PackageMap, PayloadData, CountBits, UnresolvedRefs);
 
 	TSharedPtr<FRepLayout> RepLayout = NetDriver->GetFunctionRepLayout(Function);
 	RepLayout_ReceivePropertiesForRPC(*RepLayout, PayloadReader, Parms);
@@ -899,7 +1561,17 @@ void USpatialReceiver::AddPendingActorRequest(Worker_RequestId RequestId, USpati
 
 void USpatialReceiver::AddPendingReliableRPC(Worker_RequestId RequestId, TSharedRef<FPendingRPCParams> Params)
 {
-	PendingReliableRPCs.Add(RequestId, Params);
+	PendingReliableRPCs.Add(RequestId, FReliableRPCBatch{ Params });
+}
+
+void USpatialReceiver::AddPendingReliableRPCs(Worker_RequestId RequestId, FReliableRPCBatch&& ReliableRPCs)
+{
+	PendingReliableRPCs.Add(RequestId, MoveTemp(ReliableRPCs));
+}
+
+void USpatialReceiver::ApplyLocalRPC(UObject* TargetObject, UFunction* Function, FSchemaPayloadView PayloadData)
+{
+	ApplyRPC(TargetObject, Function, PayloadData, PayloadData.Num() * 8);
 }
 
 void USpatialReceiver::AddEntityQueryDelegate(Worker_RequestId RequestId, EntityQueryDelegate Delegate)
@@ -935,7 +1607,7 @@ void USpatialReceiver::ProcessQueuedResolvedObjects()
 
 void USpatialReceiver::ResolvePendingOperations(UObject* Object, const FUnrealObjectRef& ObjectRef)
 {
-	if (bInCriticalSection)
+	if (bInCriticalSection || bApplyingCriticalSection)
 	{
 		ResolvedObjectQueue.Add(TPair<UObject*, FUnrealObjectRef>{ Object, ObjectRef });
 	}
@@ -945,28 +1617,298 @@ void USpatialReceiver::ResolvePendingOperations(UObject* Object, const FUnrealOb
 	}
 }
 
-void USpatialReceiver::QueueIncomingRepUpdates(FChannelObjectPair ChannelObjectPair, const FObjectReferencesMap& ObjectReferencesMap, const TSet<FUnrealObjectRef>& UnresolvedRefs)
+FPendingIncomingProperties& USpatialReceiver::FindOrAddPendingIncomingProperties(const FChannelObjectPair& ChannelObjectPair, Worker_EntityId EntityId)
+{
+	FPendingIncomingProperties& PendingProperties = UnresolvedRefsMap.FindOrAdd(ChannelObjectPair);
+	PendingProperties.EntityId = EntityId;
+	return PendingProperties;
+}
+
+void USpatialReceiver::QueueIncomingRepUpdates(const FChannelObjectPair& ChannelObjectPair, FPendingIncomingProperties& PendingProperties, const TSet<FUnrealObjectRef>& UnresolvedRefs)
 {
 	for (const FUnrealObjectRef& UnresolvedRef : UnresolvedRefs)
 	{
 		UE_LOG(LogSpatialReceiver, Log, TEXT("Added pending incoming property for object ref: %s, target object: %s"), *UnresolvedRef.ToString(), *ChannelObjectPair.Value->GetName());
-		IncomingRefsMap.FindOrAdd(UnresolvedRef).Add(ChannelObjectPair);
 	}
 
-	if (ObjectReferencesMap.Num() == 0)
+	if (PendingProperties.ObjectReferencesMap.Num() == 0)
 	{
-		UnresolvedRefsMap.Remove(ChannelObjectPair);
+		RemovePendingIncomingProperties(ChannelObjectPair);
+		return;
+	}
+
+	// The update may have both added and cleared references, so index this object's entries again. Only its own refs are touched.
+	UnregisterIncomingProperties(ChannelObjectPair, PendingProperties);
+	RegisterIncomingProperties(ChannelObjectPair, PendingProperties);
+
+	if (!PendingProperties.bTrackedByEntity)
+	{
+		PendingOperationsByEntity.FindOrAdd(PendingProperties.EntityId).Objects.Add(ChannelObjectPair);
+		PendingProperties.bTrackedByEntity = true;
 	}
 }
 
-void USpatialReceiver::QueueIncomingRPC(const TSet<FUnrealObjectRef>& UnresolvedRefs, UObject* TargetObject, UFunction* Function, const TArray<uint8>& PayloadData, int64 CountBits)
+void USpatialReceiver::QueueIncomingRPC(const TSet<FUnrealObjectRef>& UnresolvedRefs, UObject* TargetObject, UFunction* Function, FSchemaPayloadView PayloadData, int64 CountBits)
 {
-	TSharedPtr<FPendingIncomingRPC> IncomingRPC = MakeShared<FPendingIncomingRPC>(UnresolvedRefs, TargetObject, Function, PayloadData, CountBits);
+	const bool bReliable = Function->HasAnyFunctionFlags(FUNC_NetReliable);
+	if (!MakeRoomForIncomingRPC(TargetObject, bReliable, PayloadData.Num()))
+	{
+		if (bReliable)
+		{
+			UE_LOG(LogSpatialReceiver, Warning, TEXT("Dropping reliable RPC %s on %s, its %d bytes don't fit in the queue of RPCs waiting on unresolved refs."), *Function->GetName(), *TargetObject->GetName(), PayloadData.Num());
+		}
+		else
+		{
+			UE_LOG(LogSpatialReceiver, Verbose, TEXT("Dropping unreliable RPC %s on %s, the queue of RPCs waiting on unresolved refs is full."), *Function->GetName(), *TargetObject->GetName());
+		}
+		INC_DWORD_STAT(STAT_SpatialIncomingRPCsDropped);
+		return;
+	}
+
+	Worker_EntityId EntityId = PackageMap->GetUnrealObjectRefFromObject(TargetObject).Entity;
+	TSharedPtr<FPendingIncomingRPC> IncomingRPC = MakeShared<FPendingIncomingRPC>(UnresolvedRefs, TargetObject, Function, PayloadData, CountBits, EntityId);
 
 	for (const FUnrealObjectRef& UnresolvedRef : UnresolvedRefs)
 	{
-		FIncomingRPCArray& IncomingRPCArray = IncomingRPCMap.FindOrAdd(UnresolvedRef);
-		IncomingRPCArray.Add(IncomingRPC);
+		IncomingRefDependents.FindOrAdd(UnresolvedRef).RPCs.Add(IncomingRPC);
+	}
+
+	PendingOperationsByEntity.FindOrAdd(EntityId).RPCs.Add(IncomingRPC);
+
+	FIncomingRPCQueue& Queue = IncomingRPCQueues.FindOrAdd(TargetObject);
+	Queue.RPCs.Add(IncomingRPC);
+	Queue.NumBytes += IncomingRPC->PayloadData.Num();
+	NumPendingIncomingRPCs++;
+	QueuedIncomingRPCBytes += IncomingRPC->PayloadData.Num();
+
+	INC_DWORD_STAT(STAT_SpatialIncomingRPCsQueued);
+}
+
+bool USpatialReceiver::MakeRoomForIncomingRPC(UObject* TargetObject, bool bReliable, int32 NumBytes)
+{
+	// No amount of dropping would make room, don't throw the queue away for it.
+	if (NumBytes > MaxQueuedRPCBytesPerObject)
+	{
+		return false;
+	}
+
+	// Dropping an RPC can empty and remove the queue, so look it up again each time around.
+	while (const FIncomingRPCQueue* Queue = IncomingRPCQueues.Find(TargetObject))
+	{
+		if (Queue->RPCs.Num() < MaxQueuedRPCsPerObject && Queue->NumBytes + NumBytes <= MaxQueuedRPCBytesPerObject)
+		{
+			return true;
+		}
+
+		const TSharedPtr<FPendingIncomingRPC>* OldestUnreliable = Queue->RPCs.FindByPredicate([](const TSharedPtr<FPendingIncomingRPC>& QueuedRPC)
+		{
+			return !QueuedRPC->bReliable;
+		});
+
+		TSharedPtr<FPendingIncomingRPC> DroppedRPC;
+		if (OldestUnreliable != nullptr)
+		{
+			DroppedRPC = *OldestUnreliable;
+		}
+		else if (!bReliable)
+		{
+			return false;
+		}
+		else
+		{
+			DroppedRPC = Queue->RPCs[0];
+			UE_LOG(LogSpatialReceiver, Warning, TEXT("Dropping reliable RPC %s on %s, the queue of RPCs waiting on unresolved refs is full."), *DroppedRPC->Function->GetName(), *TargetObject->GetName());
+		}
+
+		RemovePendingIncomingRPC(DroppedRPC);
+		INC_DWORD_STAT(STAT_SpatialIncomingRPCsDropped);
+	}
+
+	return true;
+}
+
+void USpatialReceiver::ExpireIncomingRPCs()
+{
+	const double Now = FPlatformTime::Seconds();
+	const double ExpiryTime = IncomingRPCTimeToLive > 0.0f ? Now - IncomingRPCTimeToLive : TNumericLimits<double>::Lowest();
+
+	FIncomingRPCArray ExpiredRPCs;
+	double OldestQueuedTime = Now;
+	for (const auto& Pair : IncomingRPCQueues)
+	{
+		// Queues are in arrival order, so the expired RPCs are all at the front, followed by the oldest one that stays.
+		for (const TSharedPtr<FPendingIncomingRPC>& IncomingRPC : Pair.Value.RPCs)
+		{
+			if (IncomingRPC->QueuedTime > ExpiryTime)
+			{
+				OldestQueuedTime = FMath::Min(OldestQueuedTime, IncomingRPC->QueuedTime);
+				break;
+			}
+			ExpiredRPCs.Add(IncomingRPC);
+		}
+	}
+
+	for (const TSharedPtr<FPendingIncomingRPC>& IncomingRPC : ExpiredRPCs)
+	{
+		if (IncomingRPC->bReliable)
+		{
+			UE_LOG(LogSpatialReceiver, Warning, TEXT("Expiring reliable RPC %s on entity %lld, it waited more than %.1fs for its refs to resolve."), *IncomingRPC->Function->GetName(), IncomingRPC->EntityId, IncomingRPCTimeToLive);
+			INC_DWORD_STAT(STAT_SpatialIncomingReliableRPCsExpired);
+		}
+		else
+		{
+			UE_LOG(LogSpatialReceiver, Verbose, TEXT("Expiring RPC %s on entity %lld, it waited more than %.1fs for its refs to resolve."), *IncomingRPC->Function->GetName(), IncomingRPC->EntityId, IncomingRPCTimeToLive);
+		}
+		RemovePendingIncomingRPC(IncomingRPC);
+	}
+
+	INC_DWORD_STAT_BY(STAT_SpatialIncomingRPCsExpired, ExpiredRPCs.Num());
+	SET_FLOAT_STAT(STAT_SpatialOldestQueuedIncomingRPC, Now - OldestQueuedTime);
+}
+
+namespace
+{
+	void GatherUnresolvedRefs(const FObjectReferences& ObjectReferences, TSet<FUnrealObjectRef>& OutRefs)
+	{
+		OutRefs.Append(ObjectReferences.UnresolvedRefs);
+
+		if (ObjectReferences.Array)
+		{
+			for (const auto& Pair : *ObjectReferences.Array)
+			{
+				GatherUnresolvedRefs(Pair.Value, OutRefs);
+			}
+		}
+	}
+}
+
+void USpatialReceiver::RegisterIncomingProperties(const FChannelObjectPair& ChannelObjectPair, FPendingIncomingProperties& PendingProperties)
+{
+	TSet<FUnrealObjectRef> PropertyRefs;
+
+	for (const auto& Pair : PendingProperties.ObjectReferencesMap)
+	{
+		PropertyRefs.Reset();
+		GatherUnresolvedRefs(Pair.Value, PropertyRefs);
+
+		for (const FUnrealObjectRef& PropertyRef : PropertyRefs)
+		{
+			TArray<int32, TInlineAllocator<2>>& Offsets = IncomingRefDependents.FindOrAdd(PropertyRef).Properties.FindOrAdd(ChannelObjectPair);
+			if (Offsets.Num() == 0)
+			{
+				PendingProperties.RegisteredRefs.Add(PropertyRef);
+			}
+			Offsets.Add(Pair.Key);
+		}
+	}
+}
+
+void USpatialReceiver::UnregisterIncomingProperties(const FChannelObjectPair& ChannelObjectPair, FPendingIncomingProperties& PendingProperties)
+{
+	for (const FUnrealObjectRef& RegisteredRef : PendingProperties.RegisteredRefs)
+	{
+		if (FIncomingRefDependents* Dependents = IncomingRefDependents.Find(RegisteredRef))
+		{
+			Dependents->Properties.Remove(ChannelObjectPair);
+			RemoveRefDependentsIfEmpty(RegisteredRef);
+		}
+	}
+
+	PendingProperties.RegisteredRefs.Reset();
+}
+
+void USpatialReceiver::RemovePendingIncomingProperties(const FChannelObjectPair& ChannelObjectPair)
+{
+	FPendingIncomingProperties* PendingProperties = UnresolvedRefsMap.Find(ChannelObjectPair);
+	if (PendingProperties == nullptr)
+	{
+		return;
+	}
+
+	UnregisterIncomingProperties(ChannelObjectPair, *PendingProperties);
+
+	if (PendingProperties->bTrackedByEntity)
+	{
+		if (FPendingEntityOperations* EntityOperations = PendingOperationsByEntity.Find(PendingProperties->EntityId))
+		{
+			EntityOperations->Objects.RemoveSingleSwap(ChannelObjectPair, false);
+			if (EntityOperations->IsEmpty())
+			{
+				PendingOperationsByEntity.Remove(PendingProperties->EntityId);
+			}
+		}
+	}
+
+	UnresolvedRefsMap.Remove(ChannelObjectPair);
+}
+
+void USpatialReceiver::RemovePendingIncomingRPC(const TSharedPtr<FPendingIncomingRPC>& IncomingRPC)
+{
+	for (const FUnrealObjectRef& UnresolvedRef : IncomingRPC->UnresolvedRefs)
+	{
+		if (FIncomingRefDependents* Dependents = IncomingRefDependents.Find(UnresolvedRef))
+		{
+			Dependents->RPCs.RemoveSingleSwap(IncomingRPC, false);
+			RemoveRefDependentsIfEmpty(UnresolvedRef);
+		}
+	}
+
+	if (FPendingEntityOperations* EntityOperations = PendingOperationsByEntity.Find(IncomingRPC->EntityId))
+	{
+		EntityOperations->RPCs.RemoveSingleSwap(IncomingRPC, false);
+		if (EntityOperations->IsEmpty())
+		{
+			PendingOperationsByEntity.Remove(IncomingRPC->EntityId);
+		}
+	}
+
+	if (FIncomingRPCQueue* Queue = IncomingRPCQueues.Find(IncomingRPC->TargetObject))
+	{
+		// Not swapping, the queue has to stay in arrival order.
+		if (Queue->RPCs.RemoveSingle(IncomingRPC) > 0)
+		{
+			Queue->NumBytes -= IncomingRPC->PayloadData.Num();
+			NumPendingIncomingRPCs--;
+			QueuedIncomingRPCBytes -= IncomingRPC->PayloadData.Num();
+		}
+		if (Queue->RPCs.Num() == 0)
+		{
+			IncomingRPCQueues.Remove(IncomingRPC->TargetObject);
+		}
+	}
+}
+
+void USpatialReceiver::RemoveRefDependentsIfEmpty(const FUnrealObjectRef& ObjectRef)
+{
+	const FIncomingRefDependents* Dependents = IncomingRefDependents.Find(ObjectRef);
+	if (Dependents != nullptr && Dependents->IsEmpty())
+	{
+		IncomingRefDependents.Remove(ObjectRef);
+	}
+}
+
+void USpatialReceiver::PurgePendingIncomingOperations(Worker_EntityId EntityId)
+{
+	FPendingEntityOperations* EntityOperationsPtr = PendingOperationsByEntity.Find(EntityId);
+	if (EntityOperationsPtr == nullptr)
+	{
+		return;
+	}
+
+	FPendingEntityOperations EntityOperations = MoveTemp(*EntityOperationsPtr);
+	PendingOperationsByEntity.Remove(EntityId);
+
+	UE_LOG(LogSpatialReceiver, Verbose, TEXT("Dropping %d objects with unresolved properties and %d unresolved RPCs of deleted entity %lld."), EntityOperations.Objects.Num(), EntityOperations.RPCs.Num(), EntityId);
+	INC_DWORD_STAT_BY(STAT_SpatialPurgedIncomingOperations, EntityOperations.Objects.Num() + EntityOperations.RPCs.Num());
+
+	for (const FChannelObjectPair& ChannelObjectPair : EntityOperations.Objects)
+	{
+		RemovePendingIncomingProperties(ChannelObjectPair);
+	}
+
+	for (const TSharedPtr<FPendingIncomingRPC>& IncomingRPC : EntityOperations.RPCs)
+	{
+		RemovePendingIncomingRPC(IncomingRPC);
 	}
 }
 
@@ -986,25 +1928,36 @@ void USpatialReceiver::ResolveIncomingOperations(UObject* Object, const FUnrealO
 	// TODO: queue up resolved objects since they were resolved during process ops
 	// and then resolve all of them at the end of process ops - UNR:582
 
-	TSet<FChannelObjectPair>* TargetObjectSet = IncomingRefsMap.Find(ObjectRef);
-	if (!TargetObjectSet)
+	FIncomingRefDependents* Dependents = IncomingRefDependents.Find(ObjectRef);
+	if (!Dependents || Dependents->Properties.Num() == 0)
 	{
 		return;
 	}
 
+	SCOPE_CYCLE_COUNTER(STAT_SpatialResolveIncomingOperations);
+
 	UE_LOG(LogSpatialReceiver, Log, TEXT("Resolving incoming operations depending on object ref %s, resolved object: %s"), *ObjectRef.ToString(), *Object->GetName());
 
-	for (FChannelObjectPair& ChannelObjectPair : *TargetObjectSet)
+	// Detach the dependents first, applying the resolved properties can queue more operations.
+	TMap<FChannelObjectPair, TArray<int32, TInlineAllocator<2>>> DependentProperties = MoveTemp(Dependents->Properties);
+	Dependents->Properties.Reset();
+	RemoveRefDependentsIfEmpty(ObjectRef);
+
+	for (const auto& DependentPair : DependentProperties)
 	{
-		FObjectReferencesMap* UnresolvedRefs = UnresolvedRefsMap.Find(ChannelObjectPair);
-		if (!UnresolvedRefs)
+		const FChannelObjectPair& ChannelObjectPair = DependentPair.Key;
+
+		FPendingIncomingProperties* PendingProperties = UnresolvedRefsMap.Find(ChannelObjectPair);
+		if (!PendingProperties)
 		{
 			continue;
 		}
 
+		PendingProperties->RegisteredRefs.RemoveSingleSwap(ObjectRef, false);
+
 		if (!ChannelObjectPair.Key.IsValid() || !ChannelObjectPair.Value.IsValid())
 		{
-			UnresolvedRefsMap.Remove(ChannelObjectPair);
+			RemovePendingIncomingProperties(ChannelObjectPair);
 			continue;
 		}
 
@@ -1018,7 +1971,32 @@ void USpatialReceiver::ResolveIncomingOperations(UObject* Object, const FUnrealO
 		FRepLayout& RepLayout = DependentChannel->GetObjectRepLayout(ReplicatingObject);
 		FRepStateStaticBuffer& ShadowData = DependentChannel->GetObjectStaticBuffer(ReplicatingObject);
 
-		ResolveObjectReferences(RepLayout, ReplicatingObject, *UnresolvedRefs, ShadowData.GetData(), (uint8*)ReplicatingObject, ShadowData.Num(), RepNotifies, bSomeObjectsWereMapped, bStillHasUnresolved);
+		// Only the entries that reference ObjectRef, not the whole object.
+		for (int32 AbsOffset : DependentPair.Value)
+		{
+			FObjectReferences* ObjectReferences = PendingProperties->ObjectReferencesMap.Find(AbsOffset);
+			if (!ObjectReferences)
+			{
+				// Already resolved along with another ref.
+				continue;
+			}
+
+			INC_DWORD_STAT(STAT_SpatialResolvedDependentProperties);
+
+			if (AbsOffset >= ShadowData.Num())
+			{
+				UE_LOG(LogSpatialReceiver, Log, TEXT("ResolveIncomingOperations: Removed unresolved reference: AbsOffset >= MaxAbsOffset: %d"), AbsOffset);
+				PendingProperties->ObjectReferencesMap.Remove(AbsOffset);
+				continue;
+			}
+
+			if (ResolveObjectReference(RepLayout, ReplicatingObject, AbsOffset, *ObjectReferences, ShadowData.GetData(), (uint8*)ReplicatingObject, RepNotifies, bSomeObjectsWereMapped, bStillHasUnresolved))
+			{
+				PendingProperties->ObjectReferencesMap.Remove(AbsOffset);
+			}
+		}
+
+		const bool bFullyResolved = PendingProperties->ObjectReferencesMap.Num() == 0;
 
 		if (bSomeObjectsWereMapped)
 		{
@@ -1026,41 +2004,64 @@ void USpatialReceiver::ResolveIncomingOperations(UObject* Object, const FUnrealO
 			DependentChannel->PostReceiveSpatialUpdate(ReplicatingObject, RepNotifies);
 		}
 
-		if (!bStillHasUnresolved)
+		if (bFullyResolved)
 		{
-			UnresolvedRefsMap.Remove(ChannelObjectPair);
+			RemovePendingIncomingProperties(ChannelObjectPair);
 		}
 	}
-
-	IncomingRefsMap.Remove(ObjectRef);
 }
 
 void USpatialReceiver::ResolveIncomingRPCs(UObject* Object, const FUnrealObjectRef& ObjectRef)
 {
-	FIncomingRPCArray* IncomingRPCArray = IncomingRPCMap.Find(ObjectRef);
-	if (!IncomingRPCArray)
+	FIncomingRefDependents* Dependents = IncomingRefDependents.Find(ObjectRef);
+	if (!Dependents || Dependents->RPCs.Num() == 0)
 	{
 		return;
 	}
 
 	UE_LOG(LogSpatialReceiver, Log, TEXT("Resolving incoming RPCs depending on object ref %s, resolved object: %s"), *ObjectRef.ToString(), *Object->GetName());
 
-	for (const TSharedPtr<FPendingIncomingRPC>& IncomingRPC : *IncomingRPCArray)
+	FIncomingRPCArray IncomingRPCArray = MoveTemp(Dependents->RPCs);
+	Dependents->RPCs.Reset();
+	RemoveRefDependentsIfEmpty(ObjectRef);
+
+	for (const TSharedPtr<FPendingIncomingRPC>& IncomingRPC : IncomingRPCArray)
 	{
+		IncomingRPC->UnresolvedRefs.Remove(ObjectRef);
+
 		if (!IncomingRPC->TargetObject.IsValid())
 		{
 			// The target object has been destroyed before this RPC was resolved
+			RemovePendingIncomingRPC(IncomingRPC);
 			continue;
 		}
 
-		IncomingRPC->UnresolvedRefs.Remove(ObjectRef);
 		if (IncomingRPC->UnresolvedRefs.Num() == 0)
 		{
+			TrackQueuedRPCDelivery(*IncomingRPC);
+			RemovePendingIncomingRPC(IncomingRPC);
 			ApplyRPC(IncomingRPC->TargetObject.Get(), IncomingRPC->Function, IncomingRPC->PayloadData, IncomingRPC->CountBits);
 		}
 	}
+}
 
-	IncomingRPCMap.Remove(ObjectRef);
+void USpatialReceiver::TrackQueuedRPCDelivery(const FPendingIncomingRPC& IncomingRPC)
+{
+	const FIncomingRPCQueue* Queue = IncomingRPCQueues.Find(IncomingRPC.TargetObject);
+	if (Queue != nullptr && Queue->RPCs.Num() > 0 && Queue->RPCs[0].Get() != &IncomingRPC)
+	{
+		// An RPC that arrived earlier on the same object is still waiting on other refs.
+		INC_DWORD_STAT(STAT_SpatialIncomingRPCsOutOfOrder);
+	}
+
+	const double Latency = FPlatformTime::Seconds() - IncomingRPC.QueuedTime;
+	TotalQueuedRPCLatency += Latency;
+	MaxQueuedRPCLatency = FMath::Max(MaxQueuedRPCLatency, Latency);
+	NumDeliveredQueuedRPCs++;
+
+	INC_DWORD_STAT(STAT_SpatialIncomingRPCsDelivered);
+	SET_FLOAT_STAT(STAT_SpatialIncomingRPCAverageLatency, TotalQueuedRPCLatency * 1000.0 / NumDeliveredQueuedRPCs);
+	SET_FLOAT_STAT(STAT_SpatialIncomingRPCMaxLatency, MaxQueuedRPCLatency * 1000.0);
 }
 
 void USpatialReceiver::ResolveObjectReferences(FRepLayout& RepLayout, UObject* ReplicatedObject, FObjectReferencesMap& ObjectReferencesMap, uint8* RESTRICT StoredData, uint8* RESTRICT Data, int32 MaxAbsOffset, TArray<UProperty*>& RepNotifies, bool& bOutSomeObjectsWereMapped, bool& bOutStillHasUnresolved)
@@ -1076,115 +2077,173 @@ void USpatialReceiver::ResolveObjectReferences(FRepLayout& RepLayout, UObject* R
 			continue;
 		}
 
-		FObjectReferences& ObjectReferences = It.Value();
-		UProperty* Property = ObjectReferences.Property;
-		// ParentIndex is -1 for handover properties
-		FRepParentCmd* Parent = ObjectReferences.ParentIndex >= 0 ? &RepLayout.Parents[ObjectReferences.ParentIndex] : nullptr;
-
-		if (ObjectReferences.Array)
+		if (ResolveObjectReference(RepLayout, ReplicatedObject, AbsOffset, It.Value(), StoredData, Data, RepNotifies, bOutSomeObjectsWereMapped, bOutStillHasUnresolved))
 		{
-			check(Property->IsA<UArrayProperty>());
+			It.RemoveCurrent();
+		}
+	}
+}
 
-			Property->CopySingleValue(StoredData + AbsOffset, Data + AbsOffset);
+bool USpatialReceiver::ResolveObjectReference(FRepLayout& RepLayout, UObject* ReplicatedObject, int32 AbsOffset, FObjectReferences& ObjectReferences, uint8* RESTRICT StoredData, uint8* RESTRICT Data, TArray<UProperty*>& RepNotifies, bool& bOutSomeObjectsWereMapped, bool& bOutStillHasUnresolved)
+{
+	UProperty* Property = ObjectReferences.Property;
+	// ParentIndex is -1 for handover properties
+	FRepParentCmd* Parent = ObjectReferences.ParentIndex >= 0 ? &RepLayout.Parents[ObjectReferences.ParentIndex] : nullptr;
 
-			FScriptArray* StoredArray = (FScriptArray*)(StoredData + AbsOffset);
-			FScriptArray* Array = (FScriptArray*)(Data + AbsOffset);
+	if (ObjectReferences.Array)
+	{
+		check(Property->IsA<UArrayProperty>());
 
-			int32 NewMaxOffset = Array->Num() * Property->ElementSize;
+		Property->CopySingleValue(StoredData + AbsOffset, Data + AbsOffset);
 
-			bool bArrayHasUnresolved = false;
-			ResolveObjectReferences(RepLayout, ReplicatedObject, *ObjectReferences.Array, (uint8*)StoredArray->GetData(), (uint8*)Array->GetData(), NewMaxOffset, RepNotifies, bOutSomeObjectsWereMapped, bArrayHasUnresolved);
-			if (!bArrayHasUnresolved)
-			{
-				It.RemoveCurrent();
-			}
-			else
-			{
-				bOutStillHasUnresolved = true;
-			}
-			continue;
+		FScriptArray* StoredArray = (FScriptArray*)(StoredData + AbsOffset);
+		FScriptArray* Array = (FScriptArray*)(Data + AbsOffset);
+
+		int32 NewMaxOffset = Array->Num() * Property->ElementSize;
+
+		bool bArrayHasUnresolved = false;
+		ResolveObjectReferences(RepLayout, ReplicatedObject, *ObjectReferences.Array, (uint8*)StoredArray->GetData(), (uint8*)Array->GetData(), NewMaxOffset, RepNotifies, bOutSomeObjectsWereMapped, bArrayHasUnresolved);
+		if (bArrayHasUnresolved)
+		{
+			bOutStillHasUnresolved = true;
+			return false;
 		}
+		return true;
+	}
 
-		bool bResolvedSomeRefs = false;
-		UObject* SinglePropObject = nullptr;
+	bool bResolvedSomeRefs = false;
+	UObject* SinglePropObject = nullptr;
 
-		for (auto UnresolvedIt = ObjectReferences.UnresolvedRefs.CreateIterator(); UnresolvedIt; ++UnresolvedIt)
+	for (auto UnresolvedIt = ObjectReferences.UnresolvedRefs.CreateIterator(); UnresolvedIt; ++UnresolvedIt)
+	{
+		FUnrealObjectRef& ObjectRef = *UnresolvedIt;
+
+		FNetworkGUID NetGUID = PackageMap->GetNetGUIDFromUnrealObjectRef(ObjectRef);
+		if (NetGUID.IsValid())
 		{
-			FUnrealObjectRef& ObjectRef = *UnresolvedIt;
+			UObject* Object = PackageMap->GetObjectFromNetGUID(NetGUID, true);
+			check(Object);
+
+			UE_LOG(LogSpatialReceiver, Log, TEXT("ResolveObjectReferences: Resolved object ref: Offset: %d, Object ref: %s, PropName: %s, ObjName: %s"), AbsOffset, *ObjectRef.ToString(), *Property->GetNameCPP(), *Object->GetName());
 
-			FNetworkGUID NetGUID = PackageMap->GetNetGUIDFromUnrealObjectRef(ObjectRef);
-			if (NetGUID.IsValid())
+			UnresolvedIt.RemoveCurrent();
+			bResolvedSomeRefs = true;
+
+			if (ObjectReferences.bSingleProp)
 			{
-				UObject* Object = PackageMap->GetObjectFromNetGUID(NetGUID, true);
-				check(Object);
+				SinglePropObject = Object;
+			}
+		}
+	}
 
-				UE_LOG(LogSpatialReceiver, Log, TEXT("ResolveObjectReferences: Resolved object ref: Offset: %d, Object ref: %s, PropName: %s, ObjName: %s"), AbsOffset, *ObjectRef.ToString(), *Property->GetNameCPP(), *Object->GetName());
+	if (bResolvedSomeRefs)
+	{
+		if (!bOutSomeObjectsWereMapped)
+		{
+			ReplicatedObject->PreNetReceive();
+			bOutSomeObjectsWereMapped = true;
+		}
 
-				UnresolvedIt.RemoveCurrent();
-				bResolvedSomeRefs = true;
+		if (Parent && Parent->Property->HasAnyPropertyFlags(CPF_RepNotify))
+		{
+			Property->CopySingleValue(StoredData + AbsOffset, Data + AbsOffset);
+		}
 
-				if (ObjectReferences.bSingleProp)
-				{
-					SinglePropObject = Object;
-				}
-			}
+		if (ObjectReferences.bSingleProp)
+		{
+			UObjectPropertyBase* ObjectProperty = Cast<UObjectPropertyBase>(Property);
+			check(ObjectProperty);
+
+			ObjectProperty->SetObjectPropertyValue(Data + AbsOffset, SinglePropObject);
+		}
+		else
+		{
+			TSet<FUnrealObjectRef> NewUnresolvedRefs;
+			FSpatialNetBitReader BitReader(PackageMap, ObjectReferences.Buffer.GetData(), ObjectReferences.NumBufferBits, NewUnresolvedRefs);
+			check(Property->IsA<UStructProperty>());
+			ReadStructProperty(BitReader, Cast<UStructProperty>(Property), NetDriver, Data + AbsOffset, bOutStillHasUnresolved);
 		}
 
-		if (bResolvedSomeRefs)
+		if (Parent && Parent->Property->HasAnyPropertyFlags(CPF_RepNotify))
 		{
-			if (!bOutSomeObjectsWereMapped)
+			if (Parent->RepNotifyCondition == REPNOTIFY_Always || !Property->Identical(StoredData + AbsOffset, Data + AbsOffset))
 			{
-				ReplicatedObject->PreNetReceive();
-				bOutSomeObjectsWereMapped = true;
+				RepNotifies.AddUnique(Parent->Property);
 			}
+		}
+	}
 
-			if (Parent && Parent->Property->HasAnyPropertyFlags(CPF_RepNotify))
-			{
-				Property->CopySingleValue(StoredData + AbsOffset, Data + AbsOffset);
-			}
+	if (ObjectReferences.UnresolvedRefs.Num() > 0)
+	{
+		bOutStillHasUnresolved = true;
+		return false;
+	}
 
-			if (ObjectReferences.bSingleProp)
-			{
-				UObjectPropertyBase* ObjectProperty = Cast<UObjectPropertyBase>(Property);
-				check(ObjectProperty);
+	return true;
+}
 
-				ObjectProperty->SetObjectPropertyValue(Data + AbsOffset, SinglePropObject);
-			}
-			else
-			{
-				TSet<FUnrealObjectRef> NewUnresolvedRefs;
-				FSpatialNetBitReader BitReader(PackageMap, ObjectReferences.Buffer.GetData(), ObjectReferences.NumBufferBits, NewUnresolvedRefs);
-				check(Property->IsA<UStructProperty>());
-				ReadStructProperty(BitReader, Cast<UStructProperty>(Property), NetDriver, Data + AbsOffset, bOutStillHasUnresolved);
-			}
+void USpatialReceiver::UpdateUnresolvedRefStats()
+{
+#if STATS
+	SET_DWORD_STAT(STAT_SpatialUnresolvedObjectRefs, IncomingRefDependents.Num());
+	SET_DWORD_STAT(STAT_SpatialPendingIncomingObjects, UnresolvedRefsMap.Num());
+	SET_DWORD_STAT(STAT_SpatialPendingIncomingRPCs, NumPendingIncomingRPCs);
+	SET_MEMORY_STAT(STAT_SpatialQueuedIncomingRPCMemory, QueuedIncomingRPCBytes);
 
-			if (Parent && Parent->Property->HasAnyPropertyFlags(CPF_RepNotify))
-			{
-				if (Parent->RepNotifyCondition == REPNOTIFY_Always || !Property->Identical(StoredData + AbsOffset, Data + AbsOffset))
-				{
-					RepNotifies.AddUnique(Parent->Property);
-				}
-			}
+	// Called every tick, while the memory stat has to walk the whole graph, so only size it while stats are being collected,
+	// and at most once per interval.
+	const double Now = FPlatformTime::Seconds();
+	if (FThreadStats::IsCollectingData() && Now - LastRefGraphMemoryStatTime >= SpatialConstants::UNRESOLVED_REF_GRAPH_MEMORY_STAT_INTERVAL_SECONDS)
+	{
+		LastRefGraphMemoryStatTime = Now;
+
+		SIZE_T GraphSize = IncomingRefDependents.GetAllocatedSize() + UnresolvedRefsMap.GetAllocatedSize() + PendingOperationsByEntity.GetAllocatedSize();
+
+		for (const auto& Pair : IncomingRefDependents)
+		{
+			GraphSize += Pair.Value.Properties.GetAllocatedSize() + Pair.Value.RPCs.GetAllocatedSize();
 		}
 
-		if (ObjectReferences.UnresolvedRefs.Num() > 0)
+		for (const auto& Pair : UnresolvedRefsMap)
 		{
-			bOutStillHasUnresolved = true;
+			GraphSize += Pair.Value.ObjectReferencesMap.GetAllocatedSize() + Pair.Value.RegisteredRefs.GetAllocatedSize();
 		}
-		else
+
+		for (const auto& Pair : PendingOperationsByEntity)
 		{
-			It.RemoveCurrent();
+			GraphSize += Pair.Value.Objects.GetAllocatedSize() + Pair.Value.RPCs.GetAllocatedSize();
 		}
+
+		SET_MEMORY_STAT(STAT_SpatialUnresolvedRefGraphMemory, GraphSize);
 	}
+#endif
 }
 
-void USpatialReceiver::ReceiveRPCCommandRequest(const Worker_CommandRequest& CommandRequest, UObject* TargetObject, UFunction* Function)
+void USpatialReceiver::ReceiveRPCCommandRequest(const Worker_CommandRequest& CommandRequest, UObject* TargetObject, UFunction* Function, const TArray<UFunction*>& RPCArray)
 {
 	Schema_Object* RequestObject = Schema_GetCommandRequestObject(CommandRequest.schema_type);
 
-	TArray<uint8> PayloadData = GetPayloadFromSchema(RequestObject, 1);
+	FSchemaPayloadView PayloadData = GetPayloadViewFromSchema(RequestObject, SpatialConstants::UNREAL_RPC_PAYLOAD_ID);
 	// A bit hacky, we should probably include the number of bits with the data instead.
 	int64 CountBits = PayloadData.Num() * 8;
 
 	ApplyRPC(TargetObject, Function, PayloadData, CountBits);
+
+	// RPCs the sender batched into the same request, in the order they were called.
+	TWeakObjectPtr<UObject> WeakTargetObject = TargetObject;
+	uint32 BatchedRPCCount = Schema_GetObjectCount(RequestObject, SpatialConstants::UNREAL_RPC_BATCHED_RPCS_ID);
+	for (uint32 i = 0; i < BatchedRPCCount && WeakTargetObject.IsValid(); i++)
+	{
+		Schema_Object* BatchedRPCObject = Schema_IndexObject(RequestObject, SpatialConstants::UNREAL_RPC_BATCHED_RPCS_ID, i);
+
+		uint32 CommandIndex = Schema_GetUint32(BatchedRPCObject, SpatialConstants::UNREAL_BATCHED_RPC_COMMAND_INDEX_ID);
+		if (CommandIndex == 0 || (int32)CommandIndex > RPCArray.Num())
+		{
+			UE_LOG(LogSpatialReceiver, Warning, TEXT("Batched RPC on %s has invalid command index %u, skipping it."), *TargetObject->GetName(), CommandIndex);
+			continue;
+		}
+
+		FSchemaPayloadView BatchedPayloadData = GetPayloadViewFromSchema(BatchedRPCObject, SpatialConstants::UNREAL_BATCHED_RPC_PAYLOAD_ID);
+		ApplyRPC(TargetObject, RPCArray[CommandIndex - 1], BatchedPayloadData, BatchedPayloadData.Num() * 8);
+	}
 }
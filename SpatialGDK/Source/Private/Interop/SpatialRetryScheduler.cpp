@@ -0,0 +1,194 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "Interop/SpatialRetryScheduler.h"
+
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "TimerManager.h"
+
+#include "EngineClasses/SpatialNetDriver.h"
+#include "Interop/Connection/SpatialWorkerConnection.h"
+
+DEFINE_LOG_CATEGORY(LogSpatialRetryScheduler);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Command retries in flight"), STAT_SpatialRetriesInFlight, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Command retries sent"), STAT_SpatialRetriesSent, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Command retries deferred by budget"), STAT_SpatialRetriesDeferred, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Retry targets backing off"), STAT_SpatialRetryTargetsBackingOff, STATGROUP_SpatialNet);
+
+void USpatialRetryScheduler::Init(USpatialNetDriver* InNetDriver, FTimerManager* InTimerManager)
+{
+	NetDriver = InNetDriver;
+	TimerManager = InTimerManager;
+
+	Slots.SetNum(SpatialConstants::RETRY_SCHEDULER_NUM_SLOTS);
+	CurrentSlot = 0;
+	NumInFlight = 0;
+
+	Jitter = SpatialConstants::RETRY_SCHEDULER_DEFAULT_JITTER;
+	BudgetPerSecond = SpatialConstants::RETRY_SCHEDULER_DEFAULT_BUDGET_PER_SECOND;
+	FParse::Value(FCommandLine::Get(), TEXT("retryJitter"), Jitter);
+	FParse::Value(FCommandLine::Get(), TEXT("retryBudgetPerSecond"), BudgetPerSecond);
+	Jitter = FMath::Clamp(Jitter, 0.0f, 1.0f);
+	BudgetTokens = BudgetPerSecond;
+}
+
+void USpatialRetryScheduler::Shutdown()
+{
+	if (TimerManager != nullptr)
+	{
+		TimerManager->ClearTimer(TickTimerHandle);
+	}
+
+	// The retries capture the objects that scheduled them, which are going away with the net driver.
+	for (TArray<FScheduledRetry>& Slot : Slots)
+	{
+		Slot.Empty();
+	}
+	NumInFlight = 0;
+	TargetBackoffs.Empty();
+
+	SET_DWORD_STAT(STAT_SpatialRetriesInFlight, 0);
+	SET_DWORD_STAT(STAT_SpatialRetryTargetsBackingOff, 0);
+}
+
+void USpatialRetryScheduler::ScheduleRetry(Worker_EntityId Target, float Delay, TFunction<void()>&& Retry)
+{
+	Delay = FMath::Max(Delay, GetTargetBackoff(Target));
+	Delay *= 1.0f + FMath::FRandRange(-Jitter, Jitter);
+
+	UE_LOG(LogSpatialRetryScheduler, Verbose, TEXT("Scheduling retry against entity %lld in %.2f seconds, %d retries in flight."), Target, Delay, NumInFlight);
+
+	const int32 NumSlots = Slots.Num();
+	const int32 Ticks = FMath::Max(FMath::CeilToInt(Delay / SpatialConstants::RETRY_SCHEDULER_TICK_SECONDS), 1);
+	Slots[(CurrentSlot + Ticks) % NumSlots].Add(FScheduledRetry{ MoveTemp(Retry), (Ticks - 1) / NumSlots });
+
+	if (NumInFlight++ == 0)
+	{
+		// The wheel only turns while there is something on it.
+		NextTickTime = FPlatformTime::Seconds() + SpatialConstants::RETRY_SCHEDULER_TICK_SECONDS;
+		TimerManager->SetTimer(TickTimerHandle, [this]()
+		{
+			Tick();
+		}, SpatialConstants::RETRY_SCHEDULER_TICK_SECONDS, true);
+	}
+
+	SET_DWORD_STAT(STAT_SpatialRetriesInFlight, NumInFlight);
+}
+
+void USpatialRetryScheduler::ReportSuccess(Worker_EntityId Target)
+{
+	if (TargetBackoffs.Remove(Target) > 0)
+	{
+		SET_DWORD_STAT(STAT_SpatialRetryTargetsBackingOff, TargetBackoffs.Num());
+	}
+}
+
+void USpatialRetryScheduler::ReportFailure(Worker_EntityId Target)
+{
+	if (Target == SpatialConstants::INVALID_ENTITY_ID)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	FTargetBackoff& Backoff = TargetBackoffs.FindOrAdd(Target);
+	if (Now - Backoff.LastFailureTime > SpatialConstants::RETRY_SCHEDULER_TARGET_BACKOFF_RESET_SECONDS)
+	{
+		Backoff.NumFailures = 0;
+	}
+	Backoff.NumFailures = FMath::Min(Backoff.NumFailures + 1, SpatialConstants::MAX_NUMBER_COMMAND_ATTEMPTS);
+	Backoff.LastFailureTime = Now;
+
+	SET_DWORD_STAT(STAT_SpatialRetryTargetsBackingOff, TargetBackoffs.Num());
+}
+
+float USpatialRetryScheduler::GetTargetBackoff(Worker_EntityId Target) const
+{
+	const FTargetBackoff* Backoff = TargetBackoffs.Find(Target);
+	if (Backoff == nullptr || FPlatformTime::Seconds() - Backoff->LastFailureTime > SpatialConstants::RETRY_SCHEDULER_TARGET_BACKOFF_RESET_SECONDS)
+	{
+		return 0.0f;
+	}
+
+	return SpatialConstants::GetCommandRetryWaitTimeSeconds(Backoff->NumFailures);
+}
+
+void USpatialRetryScheduler::Tick()
+{
+	// The timer manager fires at most once a frame, so catch up on every tick that has passed since.
+	const double Now = FPlatformTime::Seconds();
+	while (NextTickTime <= Now && NumInFlight > 0)
+	{
+		AdvanceSlot();
+		NextTickTime += SpatialConstants::RETRY_SCHEDULER_TICK_SECONDS;
+	}
+
+	if (NumInFlight == 0)
+	{
+		TimerManager->ClearTimer(TickTimerHandle);
+	}
+
+	SET_DWORD_STAT(STAT_SpatialRetriesInFlight, NumInFlight);
+}
+
+void USpatialRetryScheduler::AdvanceSlot()
+{
+	const int32 NumSlots = Slots.Num();
+	CurrentSlot = (CurrentSlot + 1) % NumSlots;
+
+	if (CurrentSlot == 0)
+	{
+		PruneTargetBackoffs();
+	}
+
+	if (BudgetPerSecond > 0.0f)
+	{
+		BudgetTokens = FMath::Min(BudgetTokens + BudgetPerSecond * SpatialConstants::RETRY_SCHEDULER_TICK_SECONDS, BudgetPerSecond);
+	}
+
+	// Retries can schedule further retries, so run them off a copy of the slot.
+	TArray<FScheduledRetry> DueRetries = MoveTemp(Slots[CurrentSlot]);
+	Slots[CurrentSlot].Reset();
+
+	TArray<FScheduledRetry>& NextSlot = Slots[(CurrentSlot + 1) % NumSlots];
+	for (FScheduledRetry& ScheduledRetry : DueRetries)
+	{
+		if (ScheduledRetry.Rounds > 0)
+		{
+			ScheduledRetry.Rounds--;
+			Slots[CurrentSlot].Add(MoveTemp(ScheduledRetry));
+			continue;
+		}
+
+		if (BudgetPerSecond > 0.0f)
+		{
+			if (BudgetTokens < 1.0f)
+			{
+				NextSlot.Add(MoveTemp(ScheduledRetry));
+				INC_DWORD_STAT(STAT_SpatialRetriesDeferred);
+				continue;
+			}
+			BudgetTokens -= 1.0f;
+		}
+
+		NumInFlight--;
+		INC_DWORD_STAT(STAT_SpatialRetriesSent);
+		ScheduledRetry.Retry();
+	}
+}
+
+void USpatialRetryScheduler::PruneTargetBackoffs()
+{
+	const double ResetTime = FPlatformTime::Seconds() - SpatialConstants::RETRY_SCHEDULER_TARGET_BACKOFF_RESET_SECONDS;
+	for (auto It = TargetBackoffs.CreateIterator(); It; ++It)
+	{
+		if (It.Value().LastFailureTime < ResetTime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SpatialRetryTargetsBackingOff, TargetBackoffs.Num());
+}
@@ -2,8 +2,11 @@
 
 #include "Interop/SpatialSender.h"
 
+#include "Algo/BinarySearch.h"
 #include "GameFramework/PlayerController.h"
 #include "GameFramework/PlayerState.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
 
 #include "EngineClasses/SpatialActorChannel.h"
 #include "EngineClasses/SpatialNetBitWriter.h"
@@ -21,31 +24,35 @@
 #include "Utils/ComponentFactory.h"
 #include "Utils/EntityRegistry.h"
 #include "Utils/RepLayoutUtils.h"
+#include "Utils/SchemaUtils.h"
 
 DEFINE_LOG_CATEGORY(LogSpatialSender);
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Component updates queued"), STAT_SpatialQueuedComponentUpdates, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Component updates merged"), STAT_SpatialMergedComponentUpdates, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Component updates flushed"), STAT_SpatialFlushedComponentUpdates, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPC batches sent"), STAT_SpatialRPCBatchesSent, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPCs sent in batches"), STAT_SpatialBatchedRPCsSent, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPCs delivered locally"), STAT_SpatialLocalRPCs, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPCs sent through the runtime"), STAT_SpatialRemoteRPCs, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ring buffer RPCs sent"), STAT_SpatialRingBufferRPCsSent, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ring buffer RPCs waiting for room"), STAT_SpatialRingBufferRPCsOverflowed, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Unreliable ring buffer RPCs dropped"), STAT_SpatialRingBufferRPCsDropped, STATGROUP_SpatialNet);
+
 using namespace improbable;
 
-FPendingRPCParams::FPendingRPCParams(UObject* InTargetObject, UFunction* InFunction, void* InParameters)
+FPendingRPCParams::FPendingRPCParams(UObject* InTargetObject, UFunction* InFunction, void* InParameters, const TSharedRef<FRPCParamsPool>& InPool)
 	: TargetObject(InTargetObject)
 	, Function(InFunction)
+	, Parameters(InPool->Acquire(InFunction, InParameters))
 	, Attempts(0)
+	, Pool(InPool)
 {
-	Parameters.SetNumZeroed(Function->ParmsSize);
-
-	for (TFieldIterator<UProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
-	{
-		It->InitializeValue_InContainer(Parameters.GetData());
-		It->CopyCompleteValue_InContainer(Parameters.GetData(), InParameters);
-	}
 }
 
 FPendingRPCParams::~FPendingRPCParams()
 {
-	for (TFieldIterator<UProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
-	{
-		It->DestroyValue_InContainer(Parameters.GetData());
-	}
+	Pool->Release(Function, Parameters);
 }
 
 void USpatialSender::Init(USpatialNetDriver* InNetDriver)
@@ -56,9 +63,15 @@ void USpatialSender::Init(USpatialNetDriver* InNetDriver)
 	Receiver = InNetDriver->Receiver;
 	PackageMap = InNetDriver->PackageMap;
 	TypebindingManager = InNetDriver->TypebindingManager;
+
+	RPCParamsPool = MakeShared<FRPCParamsPool>();
+
+	bCoalesceComponentUpdates = true;
+	FParse::Bool(FCommandLine::Get(), TEXT("coalesceComponentUpdates"), bCoalesceComponentUpdates);
+	bBatchRPCs = FParse::Param(FCommandLine::Get(), TEXT("batchRPCs"));
 }
 
-Worker_RequestId USpatialSender::CreateEntity(USpatialActorChannel* Channel)
+Worker_RequestId USpatialSender::CreateEntity(USpatialActorChannel* Channel, uint32& OutBytesWritten)
 {
 	AActor* Actor = Channel->Actor;
 	UClass* Class = Actor->GetClass();
@@ -221,6 +234,13 @@ Worker_RequestId USpatialSender::CreateEntity(USpatialActorChannel* Channel)
 		}
 	}
 
+	// Measured before sending, the request takes ownership of the component data.
+	OutBytesWritten = 0;
+	for (const Worker_ComponentData& ComponentData : ComponentDatas)
+	{
+		OutBytesWritten += Schema_GetWriteBufferLength(Schema_GetComponentDataFields(ComponentData.schema_type));
+	}
+
 	Worker_EntityId EntityId = Channel->GetEntityId();
 	Worker_RequestId CreateEntityRequestId = Connection->SendCreateEntityRequest(ComponentDatas.Num(), ComponentDatas.GetData(), &EntityId);
 	PendingActorRequests.Add(CreateEntityRequestId, Channel);
@@ -228,7 +248,7 @@ Worker_RequestId USpatialSender::CreateEntity(USpatialActorChannel* Channel)
 	return CreateEntityRequestId;
 }
 
-void USpatialSender::SendComponentUpdates(UObject* Object, FClassInfo* Info, USpatialActorChannel* Channel, const FRepChangeState* RepChanges, const FHandoverChangeState* HandoverChanges)
+uint32 USpatialSender::SendComponentUpdates(UObject* Object, FClassInfo* Info, USpatialActorChannel* Channel, const FRepChangeState* RepChanges, const FHandoverChangeState* HandoverChanges)
 {
 	Worker_EntityId EntityId = Channel->GetEntityId();
 
@@ -277,10 +297,65 @@ void USpatialSender::SendComponentUpdates(UObject* Object, FClassInfo* Info, USp
 			continue;
 		}
 
+		QueueComponentUpdate(EntityId, Update);
+	}
+
+	return UpdateFactory.GetBytesWritten();
+}
+
+void USpatialSender::QueueComponentUpdate(Worker_EntityId EntityId, Worker_ComponentUpdate& Update)
+{
+	if (!bCoalesceComponentUpdates)
+	{
 		Connection->SendComponentUpdate(EntityId, &Update);
+		return;
 	}
+
+	INC_DWORD_STAT(STAT_SpatialQueuedComponentUpdates);
+
+	const TPair<Worker_EntityId_Key, Worker_ComponentId> Key(EntityId, Update.component_id);
+	if (int32* QueuedIndex = QueuedComponentUpdateIndices.Find(Key))
+	{
+		MergeComponentUpdate(QueuedComponentUpdates[*QueuedIndex].Value.schema_type, Update.schema_type);
+		Schema_DestroyComponentUpdate(Update.schema_type);
+		INC_DWORD_STAT(STAT_SpatialMergedComponentUpdates);
+		return;
+	}
+
+	QueuedComponentUpdateIndices.Add(Key, QueuedComponentUpdates.Num());
+	QueuedComponentUpdates.Emplace(EntityId, Update);
+}
+
+void USpatialSender::Shutdown()
+{
+	if (Connection != nullptr && Connection->IsConnected())
+	{
+		FlushComponentUpdates();
+		return;
+	}
+
+	// Sending an update takes ownership of its schema object, these never got that far.
+	for (TPair<Worker_EntityId, Worker_ComponentUpdate>& QueuedUpdate : QueuedComponentUpdates)
+	{
+		Schema_DestroyComponentUpdate(QueuedUpdate.Value.schema_type);
+	}
+
+	QueuedComponentUpdates.Reset();
+	QueuedComponentUpdateIndices.Reset();
 }
 
+void USpatialSender::FlushComponentUpdates()
+{
+	INC_DWORD_STAT_BY(STAT_SpatialFlushedComponentUpdates, QueuedComponentUpdates.Num());
+
+	for (TPair<Worker_EntityId, Worker_ComponentUpdate>& QueuedUpdate : QueuedComponentUpdates)
+	{
+		Connection->SendComponentUpdate(QueuedUpdate.Key, &QueuedUpdate.Value);
+	}
+
+	QueuedComponentUpdates.Reset();
+	QueuedComponentUpdateIndices.Reset();
+}
 
 void FillComponentInterests(FClassInfo* Info, bool bNetOwned, TArray<Worker_InterestOverride>& ComponentInterest)
 {
@@ -295,6 +370,13 @@ void FillComponentInterests(FClassInfo* Info, bool bNetOwned, TArray<Worker_Inte
 		Worker_InterestOverride HandoverInterest = { Info->SchemaComponents[SCHEMA_Handover], false };
 		ComponentInterest.Add(HandoverInterest);
 	}
+
+	// Ring buffers carry RPCs between the server and the owning client only, other clients shouldn't receive them.
+	if (Info->bHasRPCRingBuffers)
+	{
+		ComponentInterest.Add({ Info->SchemaComponents[SCHEMA_ClientRPC], bNetOwned });
+		ComponentInterest.Add({ Info->SchemaComponents[SCHEMA_ServerRPC], bNetOwned });
+	}
 }
 
 TArray<Worker_InterestOverride> USpatialSender::CreateComponentInterest(AActor* Actor)
@@ -323,32 +405,42 @@ void USpatialSender::SendComponentInterest(AActor* Actor, Worker_EntityId Entity
 	NetDriver->Connection->SendComponentInterest(EntityId, CreateComponentInterest(Actor));
 }
 
-void USpatialSender::SendPositionUpdate(Worker_EntityId EntityId, const FVector& Location)
+uint32 USpatialSender::SendPositionUpdate(Worker_EntityId EntityId, const FVector& Location)
 {
 #if !UE_BUILD_SHIPPING
 	if (!NetDriver->StaticComponentView->HasAuthority(EntityId, SpatialConstants::POSITION_COMPONENT_ID))
 	{
 		UE_LOG(LogSpatialSender, Warning, TEXT("Trying to send Position component update but don't have authority! Update will not be sent. Entity: %lld"), EntityId);
-		return;
+		return 0;
 	}
 #endif
 
 	Worker_ComponentUpdate Update = improbable::Position::CreatePositionUpdate(improbable::Coordinates::FromFVector(Location));
-	Connection->SendComponentUpdate(EntityId, &Update);
+	const uint32 BytesWritten = Schema_GetWriteBufferLength(Schema_GetComponentUpdateFields(Update.schema_type));
+	QueueComponentUpdate(EntityId, Update);
+	return BytesWritten;
 }
 
-void USpatialSender::SendRotationUpdate(Worker_EntityId EntityId, const FRotator& Rotation)
+uint32 USpatialSender::SendRotationUpdate(Worker_EntityId EntityId, const FRotator& Rotation, bool bQuantize)
 {
 #if !UE_BUILD_SHIPPING
 	if (!NetDriver->StaticComponentView->HasAuthority(EntityId, SpatialConstants::ROTATION_COMPONENT_ID))
 	{
 		UE_LOG(LogSpatialSender, Warning, TEXT("Trying to send Rotation component update but don't have authority! Update will not be sent. Entity: %lld"), EntityId);
-		return;
+		return 0;
 	}
 #endif
 
-	Worker_ComponentUpdate Update = improbable::Rotation(Rotation).CreateRotationUpdate();
-	Connection->SendComponentUpdate(EntityId, &Update);
+	improbable::Rotation RotationComponent(Rotation);
+	Worker_ComponentUpdate Update = bQuantize ? RotationComponent.CreateQuantizedRotationUpdate() : RotationComponent.CreateRotationUpdate();
+	const uint32 BytesWritten = Schema_GetWriteBufferLength(Schema_GetComponentUpdateFields(Update.schema_type));
+	QueueComponentUpdate(EntityId, Update);
+	return BytesWritten;
+}
+
+TSharedRef<FPendingRPCParams> USpatialSender::CreateRPCParams(UObject* TargetObject, UFunction* Function, void* Parameters)
+{
+	return MakeShared<FPendingRPCParams>(TargetObject, Function, Parameters, RPCParamsPool.ToSharedRef());
 }
 
 void USpatialSender::SendRPC(TSharedRef<FPendingRPCParams> Params)
@@ -387,12 +479,49 @@ void USpatialSender::SendRPC(TSharedRef<FPendingRPCParams> Params)
 	case SCHEMA_ServerRPC:
 	case SCHEMA_CrossServerRPC:
 	{
-		Worker_CommandRequest CommandRequest = CreateRPCCommandRequest(TargetObject, Params->Function, Params->Parameters.GetData(), Info->SchemaComponents[RPCInfo->Type], RPCInfo->Index + 1, EntityId, UnresolvedObject);
+		if (const UObject* const* Blocker = OutgoingRPCBlockers.Find(Params->TargetObject))
+		{
+			UnresolvedObject = *Blocker;
+			break;
+		}
+
+		// If we are authoritative over the RPC component, the command would only come straight back to us.
+		// Unless earlier RPCs to the target are still on their way, applying this one now would overtake them.
+		// Note the RPC then runs within this call, rather than from the op list like a received one.
+		const Worker_EntityId TargetEntityId = PackageMap->GetUnrealObjectRefFromObject(TargetObject).Entity;
+		if (StaticComponentView->HasAuthority(TargetEntityId, Info->SchemaComponents[RPCInfo->Type])
+			&& !HasQueuedRPCs(TargetEntityId, *Info, RPCInfo->Type))
+		{
+			TArray<uint8> Payload;
+			if (SerializeRPCPayload(TargetObject, Params->Function, Params->Parameters, Payload, EntityId, UnresolvedObject))
+			{
+				Receiver->ApplyLocalRPC(TargetObject, Params->Function, Payload);
+				INC_DWORD_STAT(STAT_SpatialLocalRPCs);
+				return;
+			}
+			break;
+		}
+
+		if (Info->RPCTransports[RPCInfo->Type] == ERPCTransport::RingBuffer
+			&& SendRingBufferRPC(TargetObject, Params, Info->SchemaComponents[GetRingBufferComponentType(RPCInfo->Type)], RPCInfo->Index + 1, UnresolvedObject))
+		{
+			break;
+		}
+
+		if (bBatchRPCs)
+		{
+			AddRPCToBatch(TargetObject, Params, Info->SchemaComponents[RPCInfo->Type], RPCInfo->Index + 1, UnresolvedObject);
+			break;
+		}
+
+		Worker_CommandRequest CommandRequest = CreateRPCCommandRequest(TargetObject, Params->Function, Params->Parameters, Info->SchemaComponents[RPCInfo->Type], RPCInfo->Index + 1, EntityId, UnresolvedObject);
 
 		if (!UnresolvedObject)
 		{
 			check(EntityId != SpatialConstants::INVALID_ENTITY_ID);
 			Worker_RequestId RequestId = Connection->SendCommandRequest(EntityId, &CommandRequest, RPCInfo->Index + 1);
+			InFlightRPCRequests.Add(RequestId, { EntityId, CommandRequest.component_id, 1 });
+			AddInFlightRPCs(EntityId, CommandRequest.component_id, 1);
 
 			if (Params->Function->HasAnyFunctionFlags(FUNC_NetReliable))
 			{
@@ -405,7 +534,7 @@ void USpatialSender::SendRPC(TSharedRef<FPendingRPCParams> Params)
 	}
 	case SCHEMA_NetMulticastRPC:
 	{
-		Worker_ComponentUpdate ComponentUpdate = CreateMulticastUpdate(TargetObject, Params->Function, Params->Parameters.GetData(), Info->SchemaComponents[RPCInfo->Type], RPCInfo->Index + 1, EntityId, UnresolvedObject);
+		Worker_ComponentUpdate ComponentUpdate = CreateMulticastUpdate(TargetObject, Params->Function, Params->Parameters, Info->SchemaComponents[RPCInfo->Type], RPCInfo->Index + 1, EntityId, UnresolvedObject);
 
 		if (!UnresolvedObject)
 		{
@@ -429,9 +558,387 @@ void USpatialSender::SendRPC(TSharedRef<FPendingRPCParams> Params)
 	if (UnresolvedObject)
 	{
 		QueueOutgoingRPC(UnresolvedObject, Params);
+		return;
+	}
+
+	if (RPCInfo->Type != SCHEMA_NetMulticastRPC)
+	{
+		INC_DWORD_STAT(STAT_SpatialRemoteRPCs);
+	}
+}
+
+bool USpatialSender::HasQueuedRPCs(Worker_EntityId EntityId, const FClassInfo& Info, ESchemaComponentType RPCType) const
+{
+	if (NumInFlightRPCs.Contains(TPair<Worker_EntityId_Key, Worker_ComponentId>(EntityId, Info.SchemaComponents[RPCType])))
+	{
+		return true;
+	}
+
+	// The ring buffer keeps RPCs around until their ack comes back, only the ones not applied yet are still on their way.
+	if (const TMap<Worker_ComponentId, FRPCRingBuffer>* EntityRingBuffers = RPCRingBuffers.Find(EntityId))
+	{
+		const FRPCRingBuffer* RingBuffer = EntityRingBuffers->Find(Info.SchemaComponents[GetRingBufferComponentType(RPCType)]);
+		if (RingBuffer != nullptr && RingBuffer->OverflowRPCs.Num() > 0)
+		{
+			return true;
+		}
+
+		if (RingBuffer != nullptr && RingBuffer->UnackedRPCs.Num() > 0
+			&& RingBuffer->UnackedRPCs.Last().RPCId > GetLastAppliedRingBufferRPCId(EntityId, Info.SchemaComponents[RPCType]))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void USpatialSender::AddInFlightRPCs(Worker_EntityId EntityId, Worker_ComponentId ComponentId, int32 NumRPCs)
+{
+	const TPair<Worker_EntityId_Key, Worker_ComponentId> Key(EntityId, ComponentId);
+	int32& NumInFlight = NumInFlightRPCs.FindOrAdd(Key);
+	NumInFlight += NumRPCs;
+	check(NumInFlight >= 0);
+	if (NumInFlight == 0)
+	{
+		NumInFlightRPCs.Remove(Key);
+	}
+}
+
+void USpatialSender::OnRPCCommandResponse(Worker_RequestId RequestId, int32 NumRetried)
+{
+	FInFlightRPCRequest* Request = InFlightRPCRequests.Find(RequestId);
+	if (Request == nullptr)
+	{
+		// Not an RPC request.
+		return;
+	}
+
+	// The retried RPCs are still ahead of anything sent after them.
+	AddInFlightRPCs(Request->EntityId, Request->ComponentId, NumRetried - Request->NumRPCs);
+	Request->NumRPCs = NumRetried;
+	if (NumRetried == 0)
+	{
+		InFlightRPCRequests.Remove(RequestId);
+	}
+}
+
+void USpatialSender::OnRPCRetryDue(Worker_RequestId RequestId)
+{
+	FInFlightRPCRequest Request;
+	if (InFlightRPCRequests.RemoveAndCopyValue(RequestId, Request))
+	{
+		// Counted again as they are resent.
+		AddInFlightRPCs(Request.EntityId, Request.ComponentId, -Request.NumRPCs);
+	}
+}
+
+void USpatialSender::AddRPCToBatch(UObject* TargetObject, TSharedRef<FPendingRPCParams> Params, Worker_ComponentId ComponentId, Schema_FieldId CommandIndex, const UObject*& OutUnresolvedObject)
+{
+	Worker_EntityId EntityId = SpatialConstants::INVALID_ENTITY_ID;
+	TArray<uint8> Payload;
+	if (!SerializeRPCPayload(TargetObject, Params->Function, Params->Parameters, Payload, EntityId, OutUnresolvedObject))
+	{
+		return;
+	}
+
+	FOutgoingRPCBatch& Batch = OutgoingRPCBatches.FindOrAdd(EntityId);
+	if (Batch.RPCs.Num() > 0 && Batch.ComponentId != ComponentId)
+	{
+		SendRPCBatch(Batch);
+		Batch.RPCs.Reset();
+	}
+
+	Batch.EntityId = EntityId;
+	Batch.ComponentId = ComponentId;
+	Batch.RPCs.Emplace(CommandIndex, MoveTemp(Payload), Params);
+	AddInFlightRPCs(EntityId, ComponentId, 1);
+
+	if (Batch.RPCs.Num() >= SpatialConstants::RPC_BATCH_MAX_RPCS)
+	{
+		SendRPCBatch(Batch);
+		OutgoingRPCBatches.Remove(EntityId);
+	}
+}
+
+void USpatialSender::FlushRPCBatches()
+{
+	for (const auto& Pair : OutgoingRPCBatches)
+	{
+		SendRPCBatch(Pair.Value);
+	}
+
+	OutgoingRPCBatches.Reset();
+}
+
+void USpatialSender::SendRPCBatch(const FOutgoingRPCBatch& Batch)
+{
+	check(Batch.RPCs.Num() > 0);
+
+	// The request is for the first RPC's command, the rest are carried along in the same request and applied after it in order.
+	const FOutgoingRPCBatch::FBatchedRPC& FirstRPC = Batch.RPCs[0];
+
+	Worker_CommandRequest CommandRequest = {};
+	CommandRequest.component_id = Batch.ComponentId;
+	CommandRequest.schema_type = Schema_CreateCommandRequest(Batch.ComponentId, FirstRPC.CommandIndex);
+	Schema_Object* RequestObject = Schema_GetCommandRequestObject(CommandRequest.schema_type);
+	AddPayloadToSchema(RequestObject, SpatialConstants::UNREAL_RPC_PAYLOAD_ID, FirstRPC.Payload);
+
+	for (int32 i = 1; i < Batch.RPCs.Num(); i++)
+	{
+		Schema_Object* BatchedRPCObject = Schema_AddObject(RequestObject, SpatialConstants::UNREAL_RPC_BATCHED_RPCS_ID);
+		Schema_AddUint32(BatchedRPCObject, SpatialConstants::UNREAL_BATCHED_RPC_COMMAND_INDEX_ID, Batch.RPCs[i].CommandIndex);
+		AddPayloadToSchema(BatchedRPCObject, SpatialConstants::UNREAL_BATCHED_RPC_PAYLOAD_ID, Batch.RPCs[i].Payload);
+	}
+
+	Worker_RequestId RequestId = Connection->SendCommandRequest(Batch.EntityId, &CommandRequest, FirstRPC.CommandIndex);
+	// Already counted as in flight when they were batched.
+	InFlightRPCRequests.Add(RequestId, { Batch.EntityId, Batch.ComponentId, Batch.RPCs.Num() });
+
+	// Reliability is tracked for the whole request: if it fails, the reliable RPCs in it are retried together.
+	FReliableRPCBatch ReliableRPCs;
+	for (const FOutgoingRPCBatch::FBatchedRPC& BatchedRPC : Batch.RPCs)
+	{
+		if (BatchedRPC.Params->Function->HasAnyFunctionFlags(FUNC_NetReliable))
+		{
+			BatchedRPC.Params->Attempts++;
+			ReliableRPCs.Add(BatchedRPC.Params);
+		}
+	}
+
+	if (ReliableRPCs.Num() > 0)
+	{
+		Receiver->AddPendingReliableRPCs(RequestId, MoveTemp(ReliableRPCs));
+	}
+
+	INC_DWORD_STAT(STAT_SpatialRPCBatchesSent);
+	INC_DWORD_STAT_BY(STAT_SpatialBatchedRPCsSent, Batch.RPCs.Num());
+}
+
+bool USpatialSender::SendRingBufferRPC(UObject* TargetObject, TSharedRef<FPendingRPCParams> Params, Worker_ComponentId RingBufferComponentId, Schema_FieldId CommandIndex, const UObject*& OutUnresolvedObject)
+{
+	Worker_EntityId EntityId = PackageMap->GetUnrealObjectRefFromObject(TargetObject).Entity;
+	if (!StaticComponentView->HasAuthority(EntityId, RingBufferComponentId))
+	{
+		UE_LOG(LogSpatialSender, Verbose, TEXT("Not authoritative over ring buffer component %d of entity %lld, sending RPC %s as a command."), RingBufferComponentId, EntityId, *Params->Function->GetName());
+		return false;
+	}
+
+	FRingBufferedRPC RingBufferedRPC;
+	RingBufferedRPC.CommandIndex = CommandIndex;
+	if (!SerializeRPCPayload(TargetObject, Params->Function, Params->Parameters, RingBufferedRPC.Payload, EntityId, OutUnresolvedObject))
+	{
+		// Queued on the unresolved object by SendRPC, and sent through the ring buffer once it resolves.
+		return true;
+	}
+
+	FRPCRingBuffer& RingBuffer = RPCRingBuffers.FindOrAdd(EntityId).FindOrAdd(RingBufferComponentId);
+	if (RingBuffer.UnackedRPCs.Num() < SpatialConstants::RPC_RING_BUFFER_CAPACITY && RingBuffer.OverflowRPCs.Num() == 0)
+	{
+		RingBufferedRPC.RPCId = ++RingBuffer.LastSentRPCId;
+		RingBuffer.UnackedRPCs.Add(MoveTemp(RingBufferedRPC));
+		RingBuffer.bDirty = true;
+		INC_DWORD_STAT(STAT_SpatialRingBufferRPCsSent);
+	}
+	else if (Params->Function->HasAnyFunctionFlags(FUNC_NetReliable))
+	{
+		RingBufferedRPC.RPCId = ++RingBuffer.LastSentRPCId;
+		RingBuffer.OverflowRPCs.Add(MoveTemp(RingBufferedRPC));
+		INC_DWORD_STAT(STAT_SpatialRingBufferRPCsOverflowed);
+	}
+	else
+	{
+		UE_LOG(LogSpatialSender, Verbose, TEXT("Dropping unreliable RPC %s, ring buffer %d of entity %lld is full."), *Params->Function->GetName(), RingBufferComponentId, EntityId);
+		INC_DWORD_STAT(STAT_SpatialRingBufferRPCsDropped);
+	}
+
+	return true;
+}
+
+void USpatialSender::FlushRingBufferRPCs()
+{
+	for (auto& EntityPair : RPCRingBuffers)
+	{
+		const Worker_EntityId EntityId = EntityPair.Key;
+
+		for (auto& ComponentPair : EntityPair.Value)
+		{
+			const Worker_ComponentId ComponentId = ComponentPair.Key;
+			FRPCRingBuffer& RingBuffer = ComponentPair.Value;
+			if (!RingBuffer.bDirty && !RingBuffer.bAckDirty)
+			{
+				continue;
+			}
+			const bool bWriteRPCs = RingBuffer.bDirty;
+			const bool bWriteAck = RingBuffer.bAckDirty;
+			RingBuffer.bDirty = false;
+			RingBuffer.bAckDirty = false;
+
+			if (!StaticComponentView->HasAuthority(EntityId, ComponentId))
+			{
+				// Unacked RPCs are in the component already and stay there until the next writer replaces the list, the overflow never made it there.
+				if (RingBuffer.OverflowRPCs.Num() > 0)
+				{
+					UE_LOG(LogSpatialSender, Warning, TEXT("Lost authority over ring buffer component %d of entity %lld, %d RPCs waiting for room won't be delivered."), ComponentId, EntityId, RingBuffer.OverflowRPCs.Num());
+					RingBuffer.OverflowRPCs.Reset();
+				}
+				continue;
+			}
+
+			Worker_ComponentUpdate Update = {};
+			Update.component_id = ComponentId;
+			Update.schema_type = Schema_CreateComponentUpdate(ComponentId);
+			Schema_Object* FieldsObject = Schema_GetComponentUpdateFields(Update.schema_type);
+
+			if (bWriteRPCs)
+			{
+				// Lists are replaced as a whole, so an empty ring has to be cleared explicitly.
+				if (RingBuffer.UnackedRPCs.Num() == 0)
+				{
+					Schema_AddComponentUpdateClearedField(Update.schema_type, SpatialConstants::UNREAL_RPC_RING_BUFFER_RPCS_ID);
+				}
+
+				for (const FRingBufferedRPC& RingBufferedRPC : RingBuffer.UnackedRPCs)
+				{
+					Schema_Object* RPCObject = Schema_AddObject(FieldsObject, SpatialConstants::UNREAL_RPC_RING_BUFFER_RPCS_ID);
+					Schema_AddUint64(RPCObject, SpatialConstants::UNREAL_RING_BUFFERED_RPC_ID_ID, RingBufferedRPC.RPCId);
+					Schema_AddUint32(RPCObject, SpatialConstants::UNREAL_RING_BUFFERED_RPC_COMMAND_INDEX_ID, RingBufferedRPC.CommandIndex);
+					AddPayloadToSchema(RPCObject, SpatialConstants::UNREAL_RING_BUFFERED_RPC_PAYLOAD_ID, RingBufferedRPC.Payload);
+				}
+			}
+
+			// Only written when it changes, so the peer can take an ack that frees nothing as a request to resend.
+			if (bWriteAck)
+			{
+				Schema_AddUint64(FieldsObject, SpatialConstants::UNREAL_RPC_RING_BUFFER_LAST_ACKED_ID, RingBuffer.LastAppliedIncomingRPCId);
+			}
+
+			Connection->SendComponentUpdate(EntityId, &Update);
+		}
+	}
+}
+
+uint64 USpatialSender::GetLastAppliedRingBufferRPCId(Worker_EntityId EntityId, Worker_ComponentId ComponentId) const
+{
+	if (const TMap<Worker_ComponentId, FRPCRingBuffer>* EntityRingBuffers = RPCRingBuffers.Find(EntityId))
+	{
+		if (const FRPCRingBuffer* RingBuffer = EntityRingBuffers->Find(ComponentId))
+		{
+			return RingBuffer->LastAppliedIncomingRPCId;
+		}
+	}
+
+	return 0;
+}
+
+void USpatialSender::AckRingBufferRPCs(Worker_EntityId EntityId, Worker_ComponentId ComponentId, uint64 LastAppliedRPCId)
+{
+	FRPCRingBuffer& RingBuffer = RPCRingBuffers.FindOrAdd(EntityId).FindOrAdd(ComponentId);
+	RingBuffer.LastAppliedIncomingRPCId = LastAppliedRPCId;
+	RingBuffer.bAckDirty = true;
+}
+
+void USpatialSender::OnRingBufferRPCsAcked(Worker_EntityId EntityId, Worker_ComponentId ComponentId, uint64 LastAckedRPCId)
+{
+	FRPCRingBuffer* RingBuffer = &RPCRingBuffers.FindOrAdd(EntityId).FindOrAdd(ComponentId);
+
+	// Keeps the ids of a mirrored ring going even after its list has been emptied.
+	RingBuffer->LastSentRPCId = FMath::Max(RingBuffer->LastSentRPCId, LastAckedRPCId);
+
+	const int32 NumAcked = Algo::LowerBoundBy(RingBuffer->UnackedRPCs, LastAckedRPCId + 1, [](const FRingBufferedRPC& RingBufferedRPC)
+	{
+		return RingBufferedRPC.RPCId;
+	});
+	if (!StaticComponentView->HasAuthority(EntityId, ComponentId))
+	{
+		// Only mirrored, the RPCs stay with the worker that writes the component.
+		return;
+	}
+
+	if (NumAcked == 0)
+	{
+		// A new writer of the ack that only knows the ids of what we sent, see OnRingBufferAuthorityGained.
+		if (RingBuffer->UnackedRPCs.Num() > 0)
+		{
+			RingBuffer->bDirty = true;
+		}
+		return;
+	}
+
+	RingBuffer->UnackedRPCs.RemoveAt(0, NumAcked, false);
+
+	const int32 NumRefilled = FMath::Min(RingBuffer->OverflowRPCs.Num(), SpatialConstants::RPC_RING_BUFFER_CAPACITY - RingBuffer->UnackedRPCs.Num());
+	for (int32 i = 0; i < NumRefilled; i++)
+	{
+		RingBuffer->UnackedRPCs.Add(MoveTemp(RingBuffer->OverflowRPCs[i]));
+	}
+	RingBuffer->OverflowRPCs.RemoveAt(0, NumRefilled, false);
+	INC_DWORD_STAT_BY(STAT_SpatialRingBufferRPCsSent, NumRefilled);
+
+	RingBuffer->bDirty = true;
+}
+
+void USpatialSender::MirrorRingBuffer(Worker_EntityId EntityId, Worker_ComponentId ComponentId, Schema_Object* Fields)
+{
+	const uint32 RPCCount = Schema_GetObjectCount(Fields, SpatialConstants::UNREAL_RPC_RING_BUFFER_RPCS_ID);
+	const bool bHasAck = Schema_GetUint64Count(Fields, SpatialConstants::UNREAL_RPC_RING_BUFFER_LAST_ACKED_ID) > 0;
+	if (RPCCount == 0 && !bHasAck)
+	{
+		return;
+	}
+
+	FRPCRingBuffer& RingBuffer = RPCRingBuffers.FindOrAdd(EntityId).FindOrAdd(ComponentId);
+
+	// Someone else writes the component now and holds on to the payloads, we only need to know where the ids are.
+	if (RingBuffer.OverflowRPCs.Num() > 0)
+	{
+		UE_LOG(LogSpatialSender, Warning, TEXT("Lost authority over ring buffer component %d of entity %lld, %d RPCs waiting for room won't be delivered."), ComponentId, EntityId, RingBuffer.OverflowRPCs.Num());
+	}
+	RingBuffer.UnackedRPCs.Empty();
+	RingBuffer.OverflowRPCs.Empty();
+	RingBuffer.bDirty = false;
+	RingBuffer.bAckDirty = false;
+
+	// Entries are kept in id order.
+	if (RPCCount > 0)
+	{
+		Schema_Object* LastRPCObject = Schema_IndexObject(Fields, SpatialConstants::UNREAL_RPC_RING_BUFFER_RPCS_ID, RPCCount - 1);
+		RingBuffer.LastSentRPCId = FMath::Max(RingBuffer.LastSentRPCId, Schema_GetUint64(LastRPCObject, SpatialConstants::UNREAL_RING_BUFFERED_RPC_ID_ID));
+	}
+
+	if (bHasAck)
+	{
+		RingBuffer.LastAppliedIncomingRPCId = Schema_GetUint64(Fields, SpatialConstants::UNREAL_RPC_RING_BUFFER_LAST_ACKED_ID);
 	}
 }
 
+void USpatialSender::OnRingBufferAuthorityGained(Worker_EntityId EntityId, Worker_ComponentId ComponentId, Worker_ComponentId IncomingComponentId)
+{
+	// Carry on from the mirror, so the peer neither drops our RPCs as already applied nor gets its own applied twice.
+	FRPCRingBuffer& RingBuffer = RPCRingBuffers.FindOrAdd(EntityId).FindOrAdd(ComponentId);
+
+	// RPCs past our ack reached us while we weren't applying them, and we only kept their ids. Rewriting the ack gets
+	// them resent by the peer, see OnRingBufferRPCsAcked.
+	const FRPCRingBuffer* IncomingRingBuffer = RPCRingBuffers.FindChecked(EntityId).Find(IncomingComponentId);
+	if (IncomingRingBuffer != nullptr && IncomingRingBuffer->LastSentRPCId > RingBuffer.LastAppliedIncomingRPCId)
+	{
+		RingBuffer.bAckDirty = true;
+	}
+
+	if (RingBuffer.LastSentRPCId == 0 && RingBuffer.LastAppliedIncomingRPCId == 0)
+	{
+		return;
+	}
+
+	UE_LOG(LogSpatialSender, Log, TEXT("Gained authority over ring buffer component %d of entity %lld, continuing after RPC %llu with %d unacknowledged RPCs, incoming RPCs applied up to %llu."),
+		ComponentId, EntityId, RingBuffer.LastSentRPCId, RingBuffer.UnackedRPCs.Num(), RingBuffer.LastAppliedIncomingRPCId);
+}
+
+void USpatialSender::RemoveRingBuffers(Worker_EntityId EntityId)
+{
+	RPCRingBuffers.Remove(EntityId);
+}
+
 void USpatialSender::SendReserveEntityIdRequest(USpatialActorChannel* Channel)
 {
 	UE_LOG(LogSpatialSender, Log, TEXT("Sending reserve entity Id request for %s"), *Channel->Actor->GetName());
@@ -439,18 +946,22 @@ void USpatialSender::SendReserveEntityIdRequest(USpatialActorChannel* Channel)
 	Receiver->AddPendingActorRequest(RequestId, Channel);
 }
 
-void USpatialSender::SendCreateEntityRequest(USpatialActorChannel* Channel)
+uint32 USpatialSender::SendCreateEntityRequest(USpatialActorChannel* Channel)
 {
 	UE_LOG(LogSpatialSender, Log, TEXT("Sending create entity request for %s"), *Channel->Actor->GetName());
 
 	FSoftClassPath ActorClassPath(Channel->Actor->GetClass());
 
-	Worker_RequestId RequestId = CreateEntity(Channel);
+	uint32 BytesWritten = 0;
+	Worker_RequestId RequestId = CreateEntity(Channel, BytesWritten);
 	Receiver->AddPendingActorRequest(RequestId, Channel);
+	return BytesWritten;
 }
 
 void USpatialSender::SendDeleteEntityRequest(Worker_EntityId EntityId)
 {
+	// Keep the entity's last updates ahead of its deletion.
+	FlushComponentUpdates();
 	Connection->SendDeleteEntityRequest(EntityId);
 }
 
@@ -545,6 +1056,7 @@ void USpatialSender::QueueOutgoingRPC(const UObject* UnresolvedObject, TSharedRe
 	check(UnresolvedObject);
 	UE_LOG(LogSpatialSender, Log, TEXT("Added pending outgoing RPC depending on object: %s, target: %s, function: %s"), *UnresolvedObject->GetName(), *Params->TargetObject->GetName(), *Params->Function->GetName());
 	OutgoingRPCs.FindOrAdd(UnresolvedObject).Add(Params);
+	OutgoingRPCBlockers.Add(Params->TargetObject, UnresolvedObject);
 }
 
 Worker_CommandRequest USpatialSender::CreateRPCCommandRequest(UObject* TargetObject, UFunction* Function, void* Parameters, Worker_ComponentId ComponentId, Schema_FieldId CommandIndex, Worker_EntityId& OutEntityId, const UObject*& OutUnresolvedObject)
@@ -583,6 +1095,34 @@ Worker_CommandRequest USpatialSender::CreateRPCCommandRequest(UObject* TargetObj
 	return CommandRequest;
 }
 
+bool USpatialSender::SerializeRPCPayload(UObject* TargetObject, UFunction* Function, void* Parameters, TArray<uint8>& OutPayload, Worker_EntityId& OutEntityId, const UObject*& OutUnresolvedObject)
+{
+	FUnrealObjectRef TargetObjectRef(PackageMap->GetUnrealObjectRefFromNetGUID(PackageMap->GetNetGUIDFromObject(TargetObject)));
+	if (TargetObjectRef == SpatialConstants::UNRESOLVED_OBJECT_REF)
+	{
+		OutUnresolvedObject = TargetObject;
+		return false;
+	}
+
+	OutEntityId = TargetObjectRef.Entity;
+
+	TSet<const UObject*> UnresolvedObjects;
+	FSpatialNetBitWriter PayloadWriter(PackageMap, UnresolvedObjects);
+
+	TSharedPtr<FRepLayout> RepLayout = NetDriver->GetFunctionRepLayout(Function);
+	RepLayout_SendPropertiesForRPC(*RepLayout, PayloadWriter, Parameters);
+
+	for (const UObject* Object : UnresolvedObjects)
+	{
+		// Take the first unresolved object
+		OutUnresolvedObject = Object;
+		return false;
+	}
+
+	OutPayload.Append(PayloadWriter.GetData(), PayloadWriter.GetNumBytes());
+	return true;
+}
+
 Worker_ComponentUpdate USpatialSender::CreateMulticastUpdate(UObject* TargetObject, UFunction* Function, void* Parameters, Worker_ComponentId ComponentId, Schema_FieldId EventIndex, Worker_EntityId& OutEntityId, const UObject*& OutUnresolvedObject)
 {
 	Worker_ComponentUpdate ComponentUpdate = {};
@@ -708,6 +1248,16 @@ void USpatialSender::ResolveOutgoingRPCs(UObject* Object)
 	TArray<TSharedRef<FPendingRPCParams>>* RPCList = OutgoingRPCs.Find(Object);
 	if (RPCList)
 	{
+		// Unblock the targets first, the RPCs below may be queued again on another unresolved object and block them again.
+		for (const TSharedRef<FPendingRPCParams>& RPCParams : *RPCList)
+		{
+			const UObject** Blocker = OutgoingRPCBlockers.Find(RPCParams->TargetObject);
+			if (Blocker != nullptr && *Blocker == Object)
+			{
+				OutgoingRPCBlockers.Remove(RPCParams->TargetObject);
+			}
+		}
+
 		for (TSharedRef<FPendingRPCParams>& RPCParams : *RPCList)
 		{
 			if (!RPCParams->TargetObject.IsValid())
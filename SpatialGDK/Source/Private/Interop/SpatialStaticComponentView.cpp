@@ -2,17 +2,38 @@
 
 #include "Interop/SpatialStaticComponentView.h"
 
+#include "Misc/OutputDevice.h"
+
+#include "Interop/Connection/SpatialWorkerConnection.h"
+#include "Interop/SpatialViewCache.h"
 #include "Schema/Component.h"
 #include "Schema/Rotation.h"
 #include "Schema/Singleton.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("View entities"), STAT_SpatialViewEntities, STATGROUP_SpatialNet);
+DECLARE_MEMORY_STAT(TEXT("View entity index map"), STAT_SpatialViewEntityIndexMapMemory, STATGROUP_SpatialNet);
+DECLARE_MEMORY_STAT(TEXT("View entity records (incl. authority)"), STAT_SpatialViewEntityRecordMemory, STATGROUP_SpatialNet);
+DECLARE_MEMORY_STAT(TEXT("View component stores"), STAT_SpatialViewComponentStoreMemory, STATGROUP_SpatialNet);
+DECLARE_MEMORY_STAT(TEXT("View position index"), STAT_SpatialViewPositionIndexMemory, STATGROUP_SpatialNet);
+
 Worker_Authority USpatialStaticComponentView::GetAuthority(Worker_EntityId EntityId, Worker_ComponentId ComponentId)
 {
-	if (TMap<Worker_ComponentId, Worker_Authority>* ComponentAuthorityMap = EntityComponentAuthorityMap.Find(EntityId))
+	if (const int32* EntityIndex = EntityIndexMap.Find(EntityId))
 	{
-		if (Worker_Authority* Authority = ComponentAuthorityMap->Find(ComponentId))
+		const FStaticEntityRecord& Record = EntityRecords[*EntityIndex];
+
+		const EStaticComponentSlot Slot = GetStaticComponentSlot(ComponentId);
+		if (Slot != STATIC_Invalid)
+		{
+			return Record.GetStaticAuthority(Slot);
+		}
+
+		for (const TPair<Worker_ComponentId, Worker_Authority>& Authority : Record.OtherAuthority)
 		{
-			return *Authority;
+			if (Authority.Key == ComponentId)
+			{
+				return Authority.Value;
+			}
 		}
 	}
 
@@ -25,42 +46,136 @@ bool USpatialStaticComponentView::HasAuthority(Worker_EntityId EntityId, Worker_
 	return GetAuthority(EntityId, ComponentId) == WORKER_AUTHORITY_AUTHORITATIVE;
 }
 
+template <typename T>
+void USpatialStaticComponentView::AddComponent(Worker_EntityId EntityId, const Worker_ComponentData& Data)
+{
+	const EStaticComponentSlot Slot = GetStaticComponentSlot(T::ComponentId);
+
+	TUniquePtr<FStaticComponentStoreBase>& Store = ComponentStores[Slot];
+	if (!Store.IsValid())
+	{
+		Store = MakeUnique<TStaticComponentStore<T>>();
+	}
+	TStaticComponentStore<T>* TypedStore = static_cast<TStaticComponentStore<T>*>(Store.Get());
+
+	const int32 EntityIndex = FindOrAddEntityRecord(EntityId);
+	int32& ComponentIndex = EntityRecords[EntityIndex].ComponentIndices[Slot];
+
+	if (ComponentIndex != INDEX_NONE)
+	{
+		TypedStore->Get(ComponentIndex) = T(Data);
+	}
+	else
+	{
+		ComponentIndex = TypedStore->Add(T(Data), EntityIndex);
+	}
+}
+
 void USpatialStaticComponentView::OnAddComponent(const Worker_AddComponentOp& Op)
 {
-	TUniquePtr<improbable::ComponentStorageBase> Data;
+	if (WarmStartCache != nullptr)
+	{
+		WarmStartCache->ValidateAddComponent(Op);
+	}
+
 	switch (Op.data.component_id)
 	{
 	case SpatialConstants::ENTITY_ACL_COMPONENT_ID:
-		Data = MakeUnique<improbable::ComponentStorage<improbable::EntityAcl>>(Op.data);
+		AddComponent<improbable::EntityAcl>(Op.entity_id, Op.data);
 		break;
 	case SpatialConstants::METADATA_COMPONENT_ID:
-		Data = MakeUnique<improbable::ComponentStorage<improbable::Metadata>>(Op.data);
+		AddComponent<improbable::Metadata>(Op.entity_id, Op.data);
 		break;
 	case SpatialConstants::POSITION_COMPONENT_ID:
-		Data = MakeUnique<improbable::ComponentStorage<improbable::Position>>(Op.data);
+		AddComponent<improbable::Position>(Op.entity_id, Op.data);
+		PositionIndex.AddOrUpdate(Op.entity_id, GetComponentData<improbable::Position>(Op.entity_id)->Coords);
 		break;
 	case SpatialConstants::PERSISTENCE_COMPONENT_ID:
-		Data = MakeUnique<improbable::ComponentStorage<improbable::Persistence>>(Op.data);
+		AddComponent<improbable::Persistence>(Op.entity_id, Op.data);
 		break;
 	case SpatialConstants::ROTATION_COMPONENT_ID:
-		Data = MakeUnique<improbable::ComponentStorage<improbable::Rotation>>(Op.data);
+		AddComponent<improbable::Rotation>(Op.entity_id, Op.data);
 		break;
 	case SpatialConstants::SINGLETON_COMPONENT_ID:
-		Data = MakeUnique<improbable::ComponentStorage<improbable::Singleton>>(Op.data);
+		AddComponent<improbable::Singleton>(Op.entity_id, Op.data);
 		break;
 	case SpatialConstants::UNREAL_METADATA_COMPONENT_ID:
-		Data = MakeUnique<improbable::ComponentStorage<improbable::UnrealMetadata>>(Op.data);
+		AddComponent<improbable::UnrealMetadata>(Op.entity_id, Op.data);
 		break;
 	default:
 		return;
 	}
+}
 
-	EntityComponentMap.FindOrAdd(Op.entity_id).FindOrAdd(Op.data.component_id) = std::move(Data);
+int32 USpatialStaticComponentView::FindOrAddEntityRecord(Worker_EntityId EntityId)
+{
+	if (const int32* EntityIndex = EntityIndexMap.Find(EntityId))
+	{
+		return *EntityIndex;
+	}
+
+	const int32 EntityIndex = EntityRecords.Emplace(EntityId);
+	EntityIndexMap.Add(EntityId, EntityIndex);
+	return EntityIndex;
+}
+
+void USpatialStaticComponentView::RemoveEntityRecord(int32 EntityIndex)
+{
+	EntityIndexMap.Remove(EntityRecords[EntityIndex].EntityId);
+
+	const int32 LastIndex = EntityRecords.Num() - 1;
+	EntityRecords.RemoveAtSwap(EntityIndex, 1, false);
+
+	if (EntityIndex == LastIndex)
+	{
+		return;
+	}
+
+	// The last record moved into EntityIndex, point its map entry and components at the new index.
+	FStaticEntityRecord& MovedRecord = EntityRecords[EntityIndex];
+	EntityIndexMap.Add(MovedRecord.EntityId, EntityIndex);
+
+	for (int32 Slot = 0; Slot < STATIC_Count; Slot++)
+	{
+		if (MovedRecord.ComponentIndices[Slot] != INDEX_NONE)
+		{
+			ComponentStores[Slot]->SetEntityIndex(MovedRecord.ComponentIndices[Slot], EntityIndex);
+		}
+	}
 }
 
 void USpatialStaticComponentView::OnRemoveEntity(const Worker_RemoveEntityOp& Op)
 {
-	EntityComponentMap.Remove(Op.entity_id);
+	const int32* EntityIndexPtr = EntityIndexMap.Find(Op.entity_id);
+	if (EntityIndexPtr == nullptr)
+	{
+		return;
+	}
+
+	const int32 EntityIndex = *EntityIndexPtr;
+	FStaticEntityRecord& Record = EntityRecords[EntityIndex];
+
+	PositionIndex.Remove(Op.entity_id);
+
+	for (int32 Slot = 0; Slot < STATIC_Count; Slot++)
+	{
+		const int32 ComponentIndex = Record.ComponentIndices[Slot];
+		if (ComponentIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		Record.ComponentIndices[Slot] = INDEX_NONE;
+
+		const int32 MovedEntityIndex = ComponentStores[Slot]->RemoveAtSwap(ComponentIndex);
+		if (MovedEntityIndex != INDEX_NONE)
+		{
+			EntityRecords[MovedEntityIndex].ComponentIndices[Slot] = ComponentIndex;
+		}
+	}
+
+	// Authority lives on the record, so it goes away with the entity.
+	RemoveEntityRecord(EntityIndex);
 }
 
 void USpatialStaticComponentView::OnComponentUpdate(const Worker_ComponentUpdateOp& Op)
@@ -84,10 +199,280 @@ void USpatialStaticComponentView::OnComponentUpdate(const Worker_ComponentUpdate
 
 	if (Component) {
 		Component->ApplyComponentUpdate(Op.update);
+
+		if (Op.update.component_id == SpatialConstants::POSITION_COMPONENT_ID)
+		{
+			PositionIndex.AddOrUpdate(Op.entity_id, static_cast<improbable::Position*>(Component)->Coords);
+		}
+	}
+}
+
+void USpatialStaticComponentView::GetEntitiesInRadius(const improbable::Coordinates& Center, double Radius, TArray<Worker_EntityId>& OutEntityIds) const
+{
+	PositionIndex.QueryRadius(Center, Radius, OutEntityIds);
+}
+
+void USpatialStaticComponentView::GetEntitiesInBox(const improbable::Coordinates& Min, const improbable::Coordinates& Max, TArray<Worker_EntityId>& OutEntityIds) const
+{
+	PositionIndex.QueryBox(Min, Max, OutEntityIds);
+}
+
+void USpatialStaticComponentView::GetEntitiesInRadius(const FVector& Center, float Radius, TArray<Worker_EntityId>& OutEntityIds) const
+{
+	PositionIndex.QueryRadius(improbable::Coordinates::FromFVector(Center), 0.01 * Radius, OutEntityIds);
+}
+
+void USpatialStaticComponentView::SetPositionIndexCellSize(double CellSize)
+{
+	if (CellSize <= 0.0 || CellSize == PositionIndex.GetCellSize())
+	{
+		return;
+	}
+
+	PositionIndex = FSpatialPositionIndex(CellSize);
+
+	if (!ComponentStores[STATIC_Position].IsValid())
+	{
+		return;
+	}
+
+	TStaticComponentStore<improbable::Position>* PositionStore = static_cast<TStaticComponentStore<improbable::Position>*>(ComponentStores[STATIC_Position].Get());
+	for (const FStaticEntityRecord& Record : EntityRecords)
+	{
+		if (Record.ComponentIndices[STATIC_Position] != INDEX_NONE)
+		{
+			PositionIndex.AddOrUpdate(Record.EntityId, PositionStore->Get(Record.ComponentIndices[STATIC_Position]).Coords);
+		}
 	}
 }
 
 void USpatialStaticComponentView::OnAuthorityChange(const Worker_AuthorityChangeOp& Op)
 {
-	EntityComponentAuthorityMap.FindOrAdd(Op.entity_id).FindOrAdd(Op.component_id) = (Worker_Authority)Op.authority;
+	// Not authoritative is the default, don't create a record that nothing would remove.
+	if (Op.authority == WORKER_AUTHORITY_NOT_AUTHORITATIVE && !EntityIndexMap.Contains(Op.entity_id))
+	{
+		return;
+	}
+
+	FStaticEntityRecord& Record = EntityRecords[FindOrAddEntityRecord(Op.entity_id)];
+
+	const EStaticComponentSlot Slot = GetStaticComponentSlot(Op.component_id);
+	if (Slot != STATIC_Invalid)
+	{
+		Record.SetStaticAuthority(Slot, (Worker_Authority)Op.authority);
+		return;
+	}
+
+	for (TPair<Worker_ComponentId, Worker_Authority>& Authority : Record.OtherAuthority)
+	{
+		if (Authority.Key == Op.component_id)
+		{
+			Authority.Value = (Worker_Authority)Op.authority;
+			return;
+		}
+	}
+
+	Record.OtherAuthority.Emplace(Op.component_id, (Worker_Authority)Op.authority);
+}
+
+void USpatialStaticComponentView::GetEntityIds(TArray<Worker_EntityId>& OutEntityIds) const
+{
+	OutEntityIds.Reserve(OutEntityIds.Num() + EntityRecords.Num());
+	for (const FStaticEntityRecord& Record : EntityRecords)
+	{
+		OutEntityIds.Add(Record.EntityId);
+	}
+}
+
+void USpatialStaticComponentView::UpdateMemoryStats() const
+{
+#if STATS
+	SIZE_T ComponentStoreSize = 0;
+	for (const TUniquePtr<FStaticComponentStoreBase>& Store : ComponentStores)
+	{
+		if (Store.IsValid())
+		{
+			ComponentStoreSize += Store->GetAllocatedSize();
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SpatialViewEntities, EntityRecords.Num());
+	SET_MEMORY_STAT(STAT_SpatialViewEntityIndexMapMemory, EntityIndexMap.GetAllocatedSize());
+	SET_MEMORY_STAT(STAT_SpatialViewEntityRecordMemory, EntityRecords.GetAllocatedSize());
+	SET_MEMORY_STAT(STAT_SpatialViewComponentStoreMemory, ComponentStoreSize);
+	SET_MEMORY_STAT(STAT_SpatialViewPositionIndexMemory, PositionIndex.GetAllocatedSize());
+#endif
+}
+
+SIZE_T USpatialStaticComponentView::GetAllocatedSize() const
+{
+	SIZE_T Size = EntityIndexMap.GetAllocatedSize() + EntityRecords.GetAllocatedSize() + PositionIndex.GetAllocatedSize();
+
+	for (const FStaticEntityRecord& Record : EntityRecords)
+	{
+		// Only counts a heap allocation, the inline elements are part of EntityRecords already.
+		Size += Record.OtherAuthority.GetAllocatedSize();
+	}
+
+	for (const TUniquePtr<FStaticComponentStoreBase>& Store : ComponentStores)
+	{
+		if (Store.IsValid())
+		{
+			Size += Store->GetAllocatedSize();
+		}
+	}
+
+	return Size;
+}
+
+#if !UE_BUILD_SHIPPING
+void USpatialStaticComponentView::RunLookupBenchmark(int32 NumEntities, int32 NumIterations, FOutputDevice& Ar)
+{
+	USpatialStaticComponentView* View = NewObject<USpatialStaticComponentView>();
+
+	// The layout this view had before it was made dense, kept here for comparison.
+	TMap<Worker_EntityId_Key, TMap<Worker_ComponentId, Worker_Authority>> NestedAuthorityMap;
+	TMap<Worker_EntityId_Key, TMap<Worker_ComponentId, TUniquePtr<improbable::ComponentStorageBase>>> NestedComponentMap;
+
+	for (int32 i = 0; i < NumEntities; i++)
+	{
+		const Worker_EntityId EntityId = i + 1;
+
+		improbable::Position Position(improbable::Coordinates{ double(i), 0.0, double(-i) });
+		Worker_AddComponentOp AddOp = {};
+		AddOp.entity_id = EntityId;
+		AddOp.data = Position.CreatePositionData();
+		View->OnAddComponent(AddOp);
+		Schema_DestroyComponentData(AddOp.data.schema_type);
+
+		Worker_AuthorityChangeOp AuthorityOp = {};
+		AuthorityOp.entity_id = EntityId;
+		AuthorityOp.component_id = SpatialConstants::POSITION_COMPONENT_ID;
+		AuthorityOp.authority = (i % 2 == 0) ? WORKER_AUTHORITY_AUTHORITATIVE : WORKER_AUTHORITY_NOT_AUTHORITATIVE;
+		View->OnAuthorityChange(AuthorityOp);
+
+		NestedComponentMap.FindOrAdd(EntityId).Add(SpatialConstants::POSITION_COMPONENT_ID, MakeUnique<improbable::ComponentStorage<improbable::Position>>(Position));
+		NestedAuthorityMap.FindOrAdd(EntityId).Add(SpatialConstants::POSITION_COMPONENT_ID, (Worker_Authority)AuthorityOp.authority);
+	}
+
+	// Random access, like the lookups coming from actor channels.
+	TArray<Worker_EntityId> LookupOrder;
+	LookupOrder.Reserve(NumEntities);
+	for (int32 i = 0; i < NumEntities; i++)
+	{
+		LookupOrder.Add(i + 1);
+	}
+	for (int32 i = LookupOrder.Num() - 1; i > 0; i--)
+	{
+		LookupOrder.Swap(i, FMath::RandRange(0, i));
+	}
+
+	double Checksum = 0.0;
+
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+	{
+		for (Worker_EntityId EntityId : LookupOrder)
+		{
+			if (TMap<Worker_ComponentId, Worker_Authority>* AuthorityMap = NestedAuthorityMap.Find(EntityId))
+			{
+				Worker_Authority* Authority = AuthorityMap->Find(SpatialConstants::POSITION_COMPONENT_ID);
+				if (Authority != nullptr && *Authority == WORKER_AUTHORITY_AUTHORITATIVE)
+				{
+					if (TMap<Worker_ComponentId, TUniquePtr<improbable::ComponentStorageBase>>* ComponentMap = NestedComponentMap.Find(EntityId))
+					{
+						if (TUniquePtr<improbable::ComponentStorageBase>* Component = ComponentMap->Find(SpatialConstants::POSITION_COMPONENT_ID))
+						{
+							Checksum += static_cast<improbable::ComponentStorage<improbable::Position>*>(Component->Get())->Get().Coords.X;
+						}
+					}
+				}
+			}
+		}
+	}
+	const double NestedSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+	{
+		for (Worker_EntityId EntityId : LookupOrder)
+		{
+			if (View->HasAuthority(EntityId, SpatialConstants::POSITION_COMPONENT_ID))
+			{
+				if (improbable::Position* Position = View->GetComponentData<improbable::Position>(EntityId))
+				{
+					Checksum -= Position->Coords.X;
+				}
+			}
+		}
+	}
+	const double DenseSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const double NumLookups = double(NumEntities) * NumIterations;
+	Ar.Logf(TEXT("Static component view lookup benchmark, %d entities x %d iterations (HasAuthority + GetComponentData<Position>):"), NumEntities, NumIterations);
+	Ar.Logf(TEXT("  Nested TMap layout: %.3fms (%.1fns per entity)"), NestedSeconds * 1000.0, NestedSeconds * 1000000000.0 / NumLookups);
+	Ar.Logf(TEXT("  Dense layout:       %.3fms (%.1fns per entity)"), DenseSeconds * 1000.0, DenseSeconds * 1000000000.0 / NumLookups);
+	Ar.Logf(TEXT("  Checksum: %.1f (should be 0)"), Checksum);
+
+	View->MarkPendingKill();
+}
+#endif // !UE_BUILD_SHIPPING
+
+#if !UE_BUILD_SHIPPING
+void USpatialStaticComponentView::RunChurnSoak(int32 NumCycles, int32 NumLiveEntities, FOutputDevice& Ar)
+{
+	USpatialStaticComponentView* View = NewObject<USpatialStaticComponentView>();
+
+	improbable::Position Position(improbable::Coordinates{ 0.0, 0.0, 0.0 });
+	Worker_AddComponentOp AddOp = {};
+	AddOp.data = Position.CreatePositionData();
+
+	Worker_AuthorityChangeOp AuthorityOp = {};
+	Worker_RemoveEntityOp RemoveOp = {};
+
+	// Entity ids are never reused, like in a real deployment. Every cycle checks out one entity and removes the oldest one,
+	// with authority gained and lost over a generated component as well as a static one.
+	const int32 NumSamples = 10;
+	const int32 SampleInterval = FMath::Max(NumCycles / NumSamples, 1);
+
+	Ar.Logf(TEXT("Static component view churn soak, %d add/remove cycles with %d live entities:"), NumCycles, NumLiveEntities);
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (int64 Cycle = 0; Cycle < int64(NumCycles) + NumLiveEntities; Cycle++)
+	{
+		if (Cycle < NumCycles)
+		{
+			AddOp.entity_id = Cycle + 1;
+			View->OnAddComponent(AddOp);
+
+			AuthorityOp.entity_id = Cycle + 1;
+			AuthorityOp.authority = WORKER_AUTHORITY_AUTHORITATIVE;
+			AuthorityOp.component_id = SpatialConstants::POSITION_COMPONENT_ID;
+			View->OnAuthorityChange(AuthorityOp);
+			AuthorityOp.component_id = SpatialConstants::STARTING_GENERATED_COMPONENT_ID;
+			View->OnAuthorityChange(AuthorityOp);
+		}
+
+		const int64 RemovedEntityId = Cycle + 1 - NumLiveEntities;
+		if (RemovedEntityId > 0)
+		{
+			AuthorityOp.entity_id = RemovedEntityId;
+			AuthorityOp.authority = WORKER_AUTHORITY_NOT_AUTHORITATIVE;
+			View->OnAuthorityChange(AuthorityOp);
+
+			RemoveOp.entity_id = RemovedEntityId;
+			View->OnRemoveEntity(RemoveOp);
+		}
+
+		if (Cycle > 0 && Cycle % SampleInterval == 0)
+		{
+			Ar.Logf(TEXT("  %10lld cycles: %d entities, %llu bytes"), Cycle, View->EntityRecords.Num(), (uint64)View->GetAllocatedSize());
+		}
+	}
+
+	Ar.Logf(TEXT("  Finished in %.3fs: %d entities, %llu bytes"), FPlatformTime::Seconds() - StartTime, View->EntityRecords.Num(), (uint64)View->GetAllocatedSize());
+
+	Schema_DestroyComponentData(AddOp.data.schema_type);
+	View->MarkPendingKill();
 }
+#endif // !UE_BUILD_SHIPPING
@@ -7,7 +7,9 @@
 #include "Engine/BlueprintGeneratedClass.h"
 #include "Engine/SCS_Node.h"
 #include "GameFramework/Actor.h"
+#include "Misc/CommandLine.h"
 #include "Misc/MessageDialog.h"
+#include "Misc/Parse.h"
 #include "UObject/Class.h"
 #include "UObject/UObjectIterator.h"
 
@@ -28,6 +30,16 @@ void USpatialTypebindingManager::Init(USpatialNetDriver* InNetDriver)
 		return;
 	}
 
+	FMemory::Memzero(bRingBufferRPCTypes);
+	FString RingBufferRPCTypes;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ringBufferRPCs"), RingBufferRPCTypes, false))
+	{
+		TArray<FString> RPCTypeNames;
+		RingBufferRPCTypes.ParseIntoArray(RPCTypeNames, TEXT(","));
+		bRingBufferRPCTypes[SCHEMA_ClientRPC] = RPCTypeNames.Contains(TEXT("Client"));
+		bRingBufferRPCTypes[SCHEMA_ServerRPC] = RPCTypeNames.Contains(TEXT("Server"));
+	}
+
 	FindSupportedClasses();
 	CreateTypebindings();
 }
@@ -132,6 +144,7 @@ void USpatialTypebindingManager::CreateTypebindings()
 		});
 
 		Info.Class = Class;
+		SelectRPCTransports(Info);
 
 		ClassInfoMap.Emplace(Class, Info);
 	}
@@ -175,11 +188,25 @@ void USpatialTypebindingManager::CreateTypebindings()
 				}
 			});
 
+			SelectRPCTransports(SubobjectInfo);
+
 			ActorInfo->SubobjectInfo.Add(Offset, MakeShared<FClassInfo>(SubobjectInfo));
 		}
 	}
 }
 
+void USpatialTypebindingManager::SelectRPCTransports(FClassInfo& Info) const
+{
+	Info.bHasRPCRingBuffers = Info.SchemaComponents[SCHEMA_ClientRPC] != SpatialConstants::INVALID_COMPONENT_ID
+		&& Info.SchemaComponents[SCHEMA_ServerRPC] != SpatialConstants::INVALID_COMPONENT_ID;
+
+	// Cross-server RPCs stay commands: the sending server isn't authoritative over anything on the target entity.
+	for (ESchemaComponentType RPCType : { SCHEMA_ClientRPC, SCHEMA_ServerRPC })
+	{
+		Info.RPCTransports[RPCType] = bRingBufferRPCTypes[RPCType] && Info.bHasRPCRingBuffers ? ERPCTransport::RingBuffer : ERPCTransport::Command;
+	}
+}
+
 FClassInfo* USpatialTypebindingManager::FindClassInfoByClass(UClass* Class)
 {
 	return ClassInfoMap.Find(Class);
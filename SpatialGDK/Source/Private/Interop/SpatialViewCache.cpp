@@ -0,0 +1,317 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "Interop/SpatialViewCache.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/Archive.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#include "Interop/SpatialTypebindingManager.h"
+#include "Schema/Rotation.h"
+#include "Schema/Singleton.h"
+#include "Utils/EntityRegistry.h"
+
+DEFINE_LOG_CATEGORY(LogSpatialViewCache);
+
+namespace
+{
+	// "SVWC" in little endian.
+	const uint32 VIEW_CACHE_FILE_MAGIC = 0x43575653;
+	const uint32 VIEW_CACHE_FILE_VERSION = 1;
+
+	Worker_ComponentData CreateData(improbable::EntityAcl& Component) { return Component.CreateEntityAclData(); }
+	Worker_ComponentData CreateData(improbable::Metadata& Component) { return Component.CreateMetadataData(); }
+	Worker_ComponentData CreateData(improbable::Position& Component) { return Component.CreatePositionData(); }
+	Worker_ComponentData CreateData(improbable::Persistence& Component) { return Component.CreatePersistenceData(); }
+	Worker_ComponentData CreateData(improbable::Rotation& Component) { return Component.CreateRotationData(); }
+	Worker_ComponentData CreateData(improbable::Singleton& Component) { return Component.CreateSingletonData(); }
+	Worker_ComponentData CreateData(improbable::UnrealMetadata& Component) { return Component.CreateUnrealMetadataData(); }
+
+	// Serializes through the component's own Create*Data, so cached and received data are written in the same field order.
+	template <typename T>
+	void SerializeComponent(T& Component, TArray<uint8>& OutBytes)
+	{
+		Worker_ComponentData Data = CreateData(Component);
+		Schema_Object* Fields = Schema_GetComponentDataFields(Data.schema_type);
+		uint32 Length = Schema_GetWriteBufferLength(Fields);
+		OutBytes.SetNumUninitialized(Length, false);
+		Schema_WriteToBuffer(Fields, OutBytes.GetData());
+		Schema_DestroyComponentData(Data.schema_type);
+	}
+
+	template <typename T>
+	void SerializeComponentData(const Worker_ComponentData& Data, TArray<uint8>& OutBytes)
+	{
+		T Component(Data);
+		SerializeComponent(Component, OutBytes);
+	}
+
+	template <typename T>
+	void WriteComponent(FArchive& Writer, USpatialStaticComponentView* View, Worker_EntityId EntityId, TArray<uint8>& ScratchBuffer)
+	{
+		if (T* Component = View->GetComponentData<T>(EntityId))
+		{
+			SerializeComponent(*Component, ScratchBuffer);
+
+			uint8 Slot = GetStaticComponentSlot(T::ComponentId);
+			uint32 Length = ScratchBuffer.Num();
+			Writer << Slot;
+			Writer << Length;
+			Writer.Serialize(ScratchBuffer.GetData(), Length);
+		}
+	}
+}
+
+bool FSpatialViewCache::Save(const FString& FilePath, const FString& MapName, USpatialStaticComponentView* View, UEntityRegistry* EntityRegistry)
+{
+	return WriteToFile(FilePath, Snapshot(MapName, View, EntityRegistry));
+}
+
+TArray<uint8> FSpatialViewCache::Snapshot(const FString& MapName, USpatialStaticComponentView* View, UEntityRegistry* EntityRegistry)
+{
+	check(IsInGameThread());
+
+	TArray<uint8> SnapshotBytes;
+	FMemoryWriter Writer(SnapshotBytes);
+
+	TArray<Worker_EntityId> EntityIds;
+	View->GetEntityIds(EntityIds);
+
+	uint32 Magic = VIEW_CACHE_FILE_MAGIC;
+	uint32 Version = VIEW_CACHE_FILE_VERSION;
+	FString CachedMapName = MapName;
+	int32 NumEntities = EntityIds.Num();
+	Writer << Magic;
+	Writer << Version;
+	Writer << CachedMapName;
+	Writer << NumEntities;
+
+	TArray<uint8> ScratchBuffer;
+
+	for (Worker_EntityId EntityId : EntityIds)
+	{
+		int64 CachedEntityId = EntityId;
+		bool bHadActor = EntityRegistry->GetActorFromEntityId(EntityId) != nullptr;
+		Writer << CachedEntityId;
+		Writer << bHadActor;
+
+		WriteComponent<improbable::EntityAcl>(Writer, View, EntityId, ScratchBuffer);
+		WriteComponent<improbable::Metadata>(Writer, View, EntityId, ScratchBuffer);
+		WriteComponent<improbable::Position>(Writer, View, EntityId, ScratchBuffer);
+		WriteComponent<improbable::Persistence>(Writer, View, EntityId, ScratchBuffer);
+		WriteComponent<improbable::Rotation>(Writer, View, EntityId, ScratchBuffer);
+		WriteComponent<improbable::Singleton>(Writer, View, EntityId, ScratchBuffer);
+		WriteComponent<improbable::UnrealMetadata>(Writer, View, EntityId, ScratchBuffer);
+
+		uint8 EndOfEntity = STATIC_Count;
+		Writer << EndOfEntity;
+	}
+
+	return SnapshotBytes;
+}
+
+bool FSpatialViewCache::WriteToFile(const FString& FilePath, const TArray<uint8>& SnapshotBytes)
+{
+	// Write next to the real file and swap it in at the end, so a crash mid-write can't leave a truncated cache behind.
+	const FString TempFilePath = FilePath + TEXT(".tmp");
+
+	if (!FFileHelper::SaveArrayToFile(SnapshotBytes, *TempFilePath) || !IFileManager::Get().Move(*FilePath, *TempFilePath))
+	{
+		UE_LOG(LogSpatialViewCache, Warning, TEXT("Failed to write the view cache to %s."), *FilePath);
+		IFileManager::Get().Delete(*TempFilePath);
+		return false;
+	}
+
+	UE_LOG(LogSpatialViewCache, Verbose, TEXT("Wrote %d bytes to the view cache %s."), SnapshotBytes.Num(), *FilePath);
+	return true;
+}
+
+bool FSpatialViewCache::Load(const FString& FilePath, const FString& MapName)
+{
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath, FILEREAD_Silent))
+	{
+		UE_LOG(LogSpatialViewCache, Log, TEXT("No view cache found at %s, starting cold."), *FilePath);
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	FString CachedMapName;
+	int32 NumEntities = 0;
+	Reader << Magic;
+	Reader << Version;
+
+	if (Magic != VIEW_CACHE_FILE_MAGIC || Version != VIEW_CACHE_FILE_VERSION)
+	{
+		UE_LOG(LogSpatialViewCache, Warning, TEXT("%s is not a view cache or was written by a different version, ignoring it."), *FilePath);
+		return false;
+	}
+
+	Reader << CachedMapName;
+	if (CachedMapName != MapName)
+	{
+		UE_LOG(LogSpatialViewCache, Log, TEXT("View cache %s was written for map %s, not %s, ignoring it."), *FilePath, *CachedMapName, *MapName);
+		return false;
+	}
+
+	Reader << NumEntities;
+	CachedEntities.Reserve(NumEntities);
+
+	for (int32 i = 0; i < NumEntities && !Reader.IsError(); i++)
+	{
+		int64 EntityId = 0;
+		FCachedEntity Entity;
+		Reader << EntityId;
+		Reader << Entity.bHadActor;
+
+		uint8 Slot = 0;
+		for (Reader << Slot; Slot < STATIC_Count && !Reader.IsError(); Reader << Slot)
+		{
+			uint32 Length = 0;
+			Reader << Length;
+			if (Length > uint32(Reader.TotalSize() - Reader.Tell()))
+			{
+				Reader.SetError();
+				break;
+			}
+
+			Entity.ComponentBytes[Slot].SetNumUninitialized(Length);
+			Reader.Serialize(Entity.ComponentBytes[Slot].GetData(), Length);
+			Entity.ComponentMask |= 1 << Slot;
+		}
+
+		CachedEntities.Add(EntityId, MoveTemp(Entity));
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogSpatialViewCache, Warning, TEXT("View cache %s is corrupt, ignoring it."), *FilePath);
+		CachedEntities.Empty();
+		return false;
+	}
+
+	CacheFilePath = FilePath;
+	UE_LOG(LogSpatialViewCache, Log, TEXT("Loaded %d entities from the view cache %s."), CachedEntities.Num(), *FilePath);
+	return true;
+}
+
+void FSpatialViewCache::PrewarmClasses(USpatialTypebindingManager* TypebindingManager)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	TSet<FString> ClassPaths;
+	for (const auto& Pair : CachedEntities)
+	{
+		const TArray<uint8>& Bytes = Pair.Value.ComponentBytes[STATIC_UnrealMetadata];
+		if (!Pair.Value.bHadActor || Bytes.Num() == 0)
+		{
+			continue;
+		}
+
+		Worker_ComponentData Data = {};
+		Data.component_id = SpatialConstants::UNREAL_METADATA_COMPONENT_ID;
+		Data.schema_type = Schema_CreateComponentData(Data.component_id);
+		Schema_Object* Fields = Schema_GetComponentDataFields(Data.schema_type);
+		uint8* Buffer = Schema_AllocateBuffer(Fields, Bytes.Num());
+		FMemory::Memcpy(Buffer, Bytes.GetData(), Bytes.Num());
+
+		if (Schema_MergeFromBuffer(Fields, Buffer, Bytes.Num()))
+		{
+			ClassPaths.Add(improbable::UnrealMetadata(Data).ClassPath);
+		}
+
+		Schema_DestroyComponentData(Data.schema_type);
+	}
+
+	int32 NumResolved = 0;
+	for (const FString& ClassPath : ClassPaths)
+	{
+		UClass* Class = FindObject<UClass>(ANY_PACKAGE, *ClassPath);
+		if (Class == nullptr)
+		{
+			Class = LoadObject<UClass>(nullptr, *ClassPath, nullptr, LOAD_Quiet | LOAD_NoWarn);
+		}
+
+		if (Class != nullptr && TypebindingManager->FindClassInfoByClass(Class) != nullptr)
+		{
+			NumResolved++;
+		}
+	}
+
+	UE_LOG(LogSpatialViewCache, Log, TEXT("Pre-resolved %d of %d cached actor classes in %.3fs."), NumResolved, ClassPaths.Num(), FPlatformTime::Seconds() - StartTime);
+}
+
+void FSpatialViewCache::ValidateAddComponent(const Worker_AddComponentOp& Op)
+{
+	const EStaticComponentSlot Slot = GetStaticComponentSlot(Op.data.component_id);
+	if (Slot == STATIC_Invalid)
+	{
+		return;
+	}
+
+	FCachedEntity* Entity = CachedEntities.Find(Op.entity_id);
+	if (Entity == nullptr || (Entity->ComponentMask & (1 << Slot)) == 0)
+	{
+		NumUncached++;
+		return;
+	}
+
+	switch (Slot)
+	{
+	case STATIC_EntityAcl:
+		SerializeComponentData<improbable::EntityAcl>(Op.data, ScratchBuffer);
+		break;
+	case STATIC_Metadata:
+		SerializeComponentData<improbable::Metadata>(Op.data, ScratchBuffer);
+		break;
+	case STATIC_Position:
+		SerializeComponentData<improbable::Position>(Op.data, ScratchBuffer);
+		break;
+	case STATIC_Persistence:
+		SerializeComponentData<improbable::Persistence>(Op.data, ScratchBuffer);
+		break;
+	case STATIC_Rotation:
+		SerializeComponentData<improbable::Rotation>(Op.data, ScratchBuffer);
+		break;
+	case STATIC_Singleton:
+		SerializeComponentData<improbable::Singleton>(Op.data, ScratchBuffer);
+		break;
+	case STATIC_UnrealMetadata:
+		SerializeComponentData<improbable::UnrealMetadata>(Op.data, ScratchBuffer);
+		break;
+	default:
+		checkNoEntry();
+		return;
+	}
+
+	if (ScratchBuffer == Entity->ComponentBytes[Slot])
+	{
+		NumMatched++;
+	}
+	else
+	{
+		NumChanged++;
+	}
+
+	Entity->ValidatedMask |= 1 << Slot;
+}
+
+void FSpatialViewCache::LogValidationSummary() const
+{
+	int32 NumNotReceived = 0;
+	for (const auto& Pair : CachedEntities)
+	{
+		if (Pair.Value.ValidatedMask == 0)
+		{
+			NumNotReceived++;
+		}
+	}
+
+	UE_LOG(LogSpatialViewCache, Log, TEXT("View cache %s: %u components matched, %u changed, %u not cached. %d of %d cached entities not received."),
+		*CacheFilePath, NumMatched, NumChanged, NumUncached, NumNotReceived, CachedEntities.Num());
+}
@@ -0,0 +1,308 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "Utils/ComponentDecoder.h"
+
+#include "Algo/BinarySearch.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Net/RepLayout.h"
+#include "UObject/TextProperty.h"
+#include "UObject/UnrealType.h"
+
+#include "EngineClasses/SpatialNetDriver.h"
+#include "Interop/Connection/SpatialWorkerConnection.h"
+#include "Interop/SpatialTypebindingManager.h"
+#include "Utils/SchemaUtils.h"
+
+DEFINE_LOG_CATEGORY(LogSpatialComponentDecoder);
+
+DECLARE_CYCLE_STAT(TEXT("Decode component data"), STAT_SpatialDecodeComponentData, STATGROUP_SpatialNet);
+DECLARE_CYCLE_STAT(TEXT("Wait for component decode"), STAT_SpatialWaitForComponentDecode, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Components decoded in parallel"), STAT_SpatialParallelDecodedComponents, STATGROUP_SpatialNet);
+
+namespace
+{
+	template <typename T>
+	uint64 ToScalarBits(T Value)
+	{
+		static_assert(sizeof(T) <= sizeof(uint64), "Scalars are stored in 64 bits.");
+		uint64 Bits = 0;
+		FMemory::Memcpy(&Bits, &Value, sizeof(T));
+		return Bits;
+	}
+
+	void DecodeField(Schema_Object* Object, Schema_FieldId FieldId, UProperty* Property, FDecodedSchemaField& OutField)
+	{
+		if (UArrayProperty* ArrayProperty = Cast<UArrayProperty>(Property))
+		{
+			DecodeField(Object, FieldId, ArrayProperty->Inner, OutField);
+		}
+		else if (UEnumProperty* EnumProperty = Cast<UEnumProperty>(Property))
+		{
+			if (EnumProperty->ElementSize < 4)
+			{
+				for (uint32 i = 0, Count = Schema_GetUint32Count(Object, FieldId); i < Count; i++)
+				{
+					OutField.Scalars.Add(ToScalarBits(Schema_IndexUint32(Object, FieldId, i)));
+				}
+			}
+			else
+			{
+				DecodeField(Object, FieldId, EnumProperty->GetUnderlyingProperty(), OutField);
+			}
+		}
+		else if (Property->IsA<UStructProperty>())
+		{
+			for (uint32 i = 0, Count = Schema_GetBytesCount(Object, FieldId); i < Count; i++)
+			{
+				OutField.Payloads.Add(improbable::IndexPayloadFromSchema(Object, FieldId, i));
+			}
+		}
+		else if (Property->IsA<UBoolProperty>())
+		{
+			for (uint32 i = 0, Count = Schema_GetBoolCount(Object, FieldId); i < Count; i++)
+			{
+				OutField.Scalars.Add(ToScalarBits(Schema_IndexBool(Object, FieldId, i)));
+			}
+		}
+		else if (Property->IsA<UFloatProperty>())
+		{
+			for (uint32 i = 0, Count = Schema_GetFloatCount(Object, FieldId); i < Count; i++)
+			{
+				OutField.Scalars.Add(ToScalarBits(Schema_IndexFloat(Object, FieldId, i)));
+			}
+		}
+		else if (Property->IsA<UDoubleProperty>())
+		{
+			for (uint32 i = 0, Count = Schema_GetDoubleCount(Object, FieldId); i < Count; i++)
+			{
+				OutField.Scalars.Add(ToScalarBits(Schema_IndexDouble(Object, FieldId, i)));
+			}
+		}
+		else if (Property->IsA<UInt8Property>() || Property->IsA<UInt16Property>() || Property->IsA<UIntProperty>())
+		{
+			for (uint32 i = 0, Count = Schema_GetInt32Count(Object, FieldId); i < Count; i++)
+			{
+				OutField.Scalars.Add(ToScalarBits(Schema_IndexInt32(Object, FieldId, i)));
+			}
+		}
+		else if (Property->IsA<UInt64Property>())
+		{
+			for (uint32 i = 0, Count = Schema_GetInt64Count(Object, FieldId); i < Count; i++)
+			{
+				OutField.Scalars.Add(ToScalarBits(Schema_IndexInt64(Object, FieldId, i)));
+			}
+		}
+		else if (Property->IsA<UByteProperty>() || Property->IsA<UUInt16Property>() || Property->IsA<UUInt32Property>())
+		{
+			for (uint32 i = 0, Count = Schema_GetUint32Count(Object, FieldId); i < Count; i++)
+			{
+				OutField.Scalars.Add(ToScalarBits(Schema_IndexUint32(Object, FieldId, i)));
+			}
+		}
+		else if (Property->IsA<UUInt64Property>())
+		{
+			for (uint32 i = 0, Count = Schema_GetUint64Count(Object, FieldId); i < Count; i++)
+			{
+				OutField.Scalars.Add(Schema_IndexUint64(Object, FieldId, i));
+			}
+		}
+		else if (Property->IsA<UObjectPropertyBase>())
+		{
+			for (uint32 i = 0, Count = Schema_GetObjectCount(Object, FieldId); i < Count; i++)
+			{
+				OutField.ObjectRefs.Add(improbable::IndexObjectRefFromSchema(Object, FieldId, i));
+			}
+		}
+		else if (Property->IsA<UNameProperty>() || Property->IsA<UStrProperty>() || Property->IsA<UTextProperty>())
+		{
+			for (uint32 i = 0, Count = Schema_GetBytesCount(Object, FieldId); i < Count; i++)
+			{
+				OutField.Strings.Add(improbable::IndexStringFromSchema(Object, FieldId, i));
+			}
+		}
+		else
+		{
+			checkf(false, TEXT("Tried to decode unknown property in field %d"), FieldId);
+		}
+	}
+}
+
+const FDecodedSchemaField* FDecodedComponentData::FindField(Schema_FieldId FieldId) const
+{
+	const int32 Index = Algo::LowerBoundBy(Fields, FieldId, [](const FDecodedSchemaField& Field) { return Field.FieldId; });
+	return Index < Fields.Num() && Fields[Index].FieldId == FieldId ? &Fields[Index] : nullptr;
+}
+
+namespace improbable
+{
+
+void DecodeSchemaObject(Schema_Object* Object, const TArray<UProperty*>& FieldProperties, FDecodedComponentData& OutDecodedData)
+{
+	TArray<uint32> FieldIds;
+	FieldIds.SetNum(Schema_GetUniqueFieldIdCount(Object));
+	Schema_GetUniqueFieldIds(Object, FieldIds.GetData());
+	FieldIds.Sort();
+
+	OutDecodedData.Fields.SetNum(FieldIds.Num());
+
+	for (int32 i = 0; i < FieldIds.Num(); i++)
+	{
+		const Schema_FieldId FieldId = FieldIds[i];
+		check(FieldId > 0 && (int32)FieldId - 1 < FieldProperties.Num());
+
+		FDecodedSchemaField& Field = OutDecodedData.Fields[i];
+		Field.FieldId = FieldId;
+		DecodeField(Object, FieldId, FieldProperties[FieldId - 1], Field);
+	}
+}
+
+}
+
+void FSpatialComponentDecoder::Init(USpatialNetDriver* InNetDriver)
+{
+	NetDriver = InNetDriver;
+	TypebindingManager = InNetDriver->TypebindingManager;
+
+	bEnabled = FTaskGraphInterface::Get().GetNumWorkerThreads() > 0;
+	FParse::Bool(FCommandLine::Get(), TEXT("parallelComponentDecode"), bEnabled);
+}
+
+const TArray<UProperty*>* FSpatialComponentDecoder::FindOrAddFieldProperties(Worker_ComponentId ComponentId)
+{
+	if (const TUniquePtr<TArray<UProperty*>>* CachedFieldProperties = FieldPropertiesCache.Find(ComponentId))
+	{
+		return (*CachedFieldProperties)->Num() > 0 ? CachedFieldProperties->Get() : nullptr;
+	}
+
+	TArray<UProperty*>& FieldProperties = *FieldPropertiesCache.Add(ComponentId, MakeUnique<TArray<UProperty*>>());
+
+	UClass* Class = TypebindingManager->FindClassByComponentId(ComponentId);
+	if (Class == nullptr)
+	{
+		return nullptr;
+	}
+
+	ESchemaComponentType ComponentType = TypebindingManager->FindCategoryByComponentId(ComponentId);
+	if (ComponentType == SCHEMA_Data || ComponentType == SCHEMA_OwnerOnly)
+	{
+		// Field ids are rep handles, the same lookup ComponentReader does.
+		TSharedPtr<FRepLayout> RepLayout = NetDriver->GetObjectClassRepLayout(Class);
+		for (const FHandleToCmdIndex& HandleToCmdIndex : RepLayout->BaseHandleToCmdIndex)
+		{
+			FieldProperties.Add(RepLayout->Cmds[HandleToCmdIndex.CmdIndex].Property);
+		}
+	}
+	else if (ComponentType == SCHEMA_Handover)
+	{
+		FClassInfo* Info = TypebindingManager->FindClassInfoByComponentId(ComponentId);
+		check(Info);
+		for (const FHandoverPropertyInfo& PropertyInfo : Info->HandoverProperties)
+		{
+			FieldProperties.Add(PropertyInfo.Property);
+		}
+	}
+
+	return FieldProperties.Num() > 0 ? &FieldProperties : nullptr;
+}
+
+bool FSpatialComponentDecoder::Add(Worker_EntityId EntityId, const Worker_ComponentData& Data, FDecodedComponentData& OutDecodedData)
+{
+	check(IsInGameThread());
+
+	const TArray<UProperty*>* FieldProperties = FindOrAddFieldProperties(Data.component_id);
+	if (FieldProperties == nullptr)
+	{
+		return false;
+	}
+
+	if (EntityId != LastAddedEntityId)
+	{
+		if (NumPendingEntities >= SpatialConstants::COMPONENT_DECODE_ENTITIES_PER_TASK)
+		{
+			DispatchPendingJobs();
+		}
+
+		NumPendingEntities++;
+		LastAddedEntityId = EntityId;
+	}
+
+	// The pending jobs become the next chunk.
+	EntityChunks.Add(EntityId, ChunkEvents.Num());
+	PendingJobs.Add(FDecodeJob{ Schema_GetComponentDataFields(Data.schema_type), FieldProperties, &OutDecodedData });
+	return true;
+}
+
+void FSpatialComponentDecoder::Dispatch()
+{
+	if (PendingJobs.Num() > 0)
+	{
+		DispatchPendingJobs();
+	}
+
+	LastAddedEntityId = SpatialConstants::INVALID_ENTITY_ID;
+}
+
+void FSpatialComponentDecoder::DispatchPendingJobs()
+{
+	INC_DWORD_STAT_BY(STAT_SpatialParallelDecodedComponents, PendingJobs.Num());
+
+	ChunkEvents.Add(FFunctionGraphTask::CreateAndDispatchWhenReady([Jobs = MoveTemp(PendingJobs)]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialDecodeComponentData);
+
+		for (const FDecodeJob& Job : Jobs)
+		{
+			improbable::DecodeSchemaObject(Job.Object, *Job.FieldProperties, *Job.DecodedData);
+		}
+	}, TStatId(), nullptr, ENamedThreads::AnyThread));
+
+	PendingJobs.Reset();
+	NumPendingEntities = 0;
+}
+
+void FSpatialComponentDecoder::WaitForEntity(Worker_EntityId EntityId)
+{
+	const int32* ChunkIndex = EntityChunks.Find(EntityId);
+	if (ChunkIndex == nullptr || *ChunkIndex < NumCompletedChunks)
+	{
+		return;
+	}
+
+	checkf(*ChunkIndex < ChunkEvents.Num(), TEXT("Waiting for the components of entity %lld before they were dispatched."), EntityId);
+
+	SCOPE_CYCLE_COUNTER(STAT_SpatialWaitForComponentDecode);
+
+	// Chunks are consumed in the order they were dispatched, so everything before this entity's chunk is needed first anyway.
+	for (; NumCompletedChunks <= *ChunkIndex; NumCompletedChunks++)
+	{
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(ChunkEvents[NumCompletedChunks], ENamedThreads::GameThread_Local);
+	}
+}
+
+FSpatialComponentDecoder::~FSpatialComponentDecoder()
+{
+	for (; NumCompletedChunks < ChunkEvents.Num(); NumCompletedChunks++)
+	{
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(ChunkEvents[NumCompletedChunks]);
+	}
+}
+
+void FSpatialComponentDecoder::WaitForAll()
+{
+	Dispatch();
+
+	if (NumCompletedChunks < ChunkEvents.Num())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SpatialWaitForComponentDecode);
+
+		for (; NumCompletedChunks < ChunkEvents.Num(); NumCompletedChunks++)
+		{
+			FTaskGraphInterface::Get().WaitUntilTaskCompletes(ChunkEvents[NumCompletedChunks], ENamedThreads::GameThread_Local);
+		}
+	}
+
+	ChunkEvents.Reset();
+	NumCompletedChunks = 0;
+	EntityChunks.Reset();
+}
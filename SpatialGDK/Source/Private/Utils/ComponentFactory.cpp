@@ -22,6 +22,7 @@ ComponentFactory::ComponentFactory(FUnresolvedObjectsMap& RepUnresolvedObjectsMa
 	, TypebindingManager(InNetDriver->TypebindingManager)
 	, PendingRepUnresolvedObjectsMap(RepUnresolvedObjectsMap)
 	, PendingHandoverUnresolvedObjectsMap(HandoverUnresolvedObjectsMap)
+	, BytesWritten(0)
 { }
 
 bool ComponentFactory::FillSchemaObject(Schema_Object* ComponentObject, UObject* Object, const FRepChangeState& Changes, ESchemaComponentType PropertyGroup, bool bIsInitialData, TArray<Schema_FieldId>* ClearedIds /*= nullptr*/)
@@ -380,7 +381,11 @@ Worker_ComponentUpdate ComponentFactory::CreateComponentUpdate(Worker_ComponentI
 		Schema_AddComponentUpdateClearedField(ComponentUpdate.schema_type, Id);
 	}
 
-	if (!bWroteSomething)
+	if (bWroteSomething)
+	{
+		BytesWritten += Schema_GetWriteBufferLength(ComponentObject);
+	}
+	else
 	{
 		Schema_DestroyComponentUpdate(ComponentUpdate.schema_type);
 	}
@@ -405,7 +410,11 @@ Worker_ComponentUpdate ComponentFactory::CreateHandoverComponentUpdate(Worker_Co
 		Schema_AddComponentUpdateClearedField(ComponentUpdate.schema_type, Id);
 	}
 
-	if (!bWroteSomething)
+	if (bWroteSomething)
+	{
+		BytesWritten += Schema_GetWriteBufferLength(ComponentObject);
+	}
+	else
 	{
 		Schema_DestroyComponentUpdate(ComponentUpdate.schema_type);
 	}
@@ -10,11 +10,71 @@
 #include "EngineClasses/SpatialNetBitReader.h"
 #include "Interop/SpatialConditionMapFilter.h"
 #include "SpatialConstants.h"
+#include "Utils/ComponentDecoder.h"
 #include "Utils/SchemaUtils.h"
 #include "Utils/RepLayoutUtils.h"
 
 DEFINE_LOG_CATEGORY(LogSpatialComponentReader);
 
+namespace
+{
+	// Field accessors for both kinds of TFieldSource, mirroring the Schema_Index* functions.
+	template <typename T>
+	T IndexScalar(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index)
+	{
+		const FDecodedSchemaField* Field = DecodedData->FindField(Id);
+		check(Field);
+		T Value;
+		FMemory::Memcpy(&Value, &Field->Scalars[Index], sizeof(T));
+		return Value;
+	}
+
+	FORCEINLINE bool IndexBool(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return Schema_IndexBool(Object, Id, Index) != 0; }
+	FORCEINLINE bool IndexBool(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return IndexScalar<uint8>(DecodedData, Id, Index) != 0; }
+
+	FORCEINLINE float IndexFloat(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return Schema_IndexFloat(Object, Id, Index); }
+	FORCEINLINE float IndexFloat(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return IndexScalar<float>(DecodedData, Id, Index); }
+
+	FORCEINLINE double IndexDouble(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return Schema_IndexDouble(Object, Id, Index); }
+	FORCEINLINE double IndexDouble(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return IndexScalar<double>(DecodedData, Id, Index); }
+
+	FORCEINLINE int32 IndexInt32(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return Schema_IndexInt32(Object, Id, Index); }
+	FORCEINLINE int32 IndexInt32(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return IndexScalar<int32>(DecodedData, Id, Index); }
+
+	FORCEINLINE int64 IndexInt64(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return Schema_IndexInt64(Object, Id, Index); }
+	FORCEINLINE int64 IndexInt64(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return IndexScalar<int64>(DecodedData, Id, Index); }
+
+	FORCEINLINE uint32 IndexUint32(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return Schema_IndexUint32(Object, Id, Index); }
+	FORCEINLINE uint32 IndexUint32(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return IndexScalar<uint32>(DecodedData, Id, Index); }
+
+	FORCEINLINE uint64 IndexUint64(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return Schema_IndexUint64(Object, Id, Index); }
+	FORCEINLINE uint64 IndexUint64(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return IndexScalar<uint64>(DecodedData, Id, Index); }
+
+	FORCEINLINE FSchemaPayloadView IndexPayload(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return improbable::IndexPayloadViewFromSchema(Object, Id, Index); }
+	FORCEINLINE FSchemaPayloadView IndexPayload(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return DecodedData->FindField(Id)->Payloads[Index]; }
+
+	FORCEINLINE FString IndexString(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return improbable::IndexStringFromSchema(Object, Id, Index); }
+	FORCEINLINE const FString& IndexString(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return DecodedData->FindField(Id)->Strings[Index]; }
+
+	FORCEINLINE FUnrealObjectRef IndexObjectRef(Schema_Object* Object, Schema_FieldId Id, uint32 Index) { return improbable::IndexObjectRefFromSchema(Object, Id, Index); }
+	FORCEINLINE const FUnrealObjectRef& IndexObjectRef(const FDecodedComponentData* DecodedData, Schema_FieldId Id, uint32 Index) { return DecodedData->FindField(Id)->ObjectRefs[Index]; }
+
+	void GetFieldIds(Schema_Object* Object, TArray<uint32>& OutFieldIds)
+	{
+		OutFieldIds.SetNum(Schema_GetUniqueFieldIdCount(Object));
+		Schema_GetUniqueFieldIds(Object, OutFieldIds.GetData());
+	}
+
+	void GetFieldIds(const FDecodedComponentData* DecodedData, TArray<uint32>& OutFieldIds)
+	{
+		OutFieldIds.Reset(DecodedData->Fields.Num());
+		for (const FDecodedSchemaField& Field : DecodedData->Fields)
+		{
+			OutFieldIds.Add(Field.FieldId);
+		}
+	}
+}
+
 namespace improbable
 {
 
@@ -59,13 +119,25 @@ void ComponentReader::ApplyComponentUpdate(const Worker_ComponentUpdate& Compone
 	}
 }
 
-void ComponentReader::ApplySchemaObject(Schema_Object* ComponentObject, UObject* Object, USpatialActorChannel* Channel, bool bIsInitialData, TArray<Schema_FieldId>* ClearedIds)
+void ComponentReader::ApplyDecodedComponentData(const FDecodedComponentData& DecodedData, UObject* Object, USpatialActorChannel* Channel, bool bIsHandover)
+{
+	if (bIsHandover)
+	{
+		ApplyHandoverSchemaObject(&DecodedData, Object, Channel, true);
+	}
+	else
+	{
+		ApplySchemaObject(&DecodedData, Object, Channel, true);
+	}
+}
+
+template <typename TFieldSource>
+void ComponentReader::ApplySchemaObject(TFieldSource ComponentObject, UObject* Object, USpatialActorChannel* Channel, bool bIsInitialData, TArray<Schema_FieldId>* ClearedIds)
 {
 	bool bAutonomousProxy = Channel->IsClientAutonomousProxy();
 
 	TArray<uint32> UpdateFields;
-	UpdateFields.SetNum(Schema_GetUniqueFieldIdCount(ComponentObject));
-	Schema_GetUniqueFieldIds(ComponentObject, UpdateFields.GetData());
+	GetFieldIds(ComponentObject, UpdateFields);
 
 	if (UpdateFields.Num() == 0)
 	{
@@ -190,11 +262,11 @@ void ComponentReader::ApplySchemaObject(Schema_Object* ComponentObject, UObject*
 	Channel->PostReceiveSpatialUpdate(Object, RepNotifies);
 }
 
-void ComponentReader::ApplyHandoverSchemaObject(Schema_Object* ComponentObject, UObject* Object, USpatialActorChannel* Channel, bool bIsInitialData, TArray<Schema_FieldId>* ClearedIds)
+template <typename TFieldSource>
+void ComponentReader::ApplyHandoverSchemaObject(TFieldSource ComponentObject, UObject* Object, USpatialActorChannel* Channel, bool bIsInitialData, TArray<Schema_FieldId>* ClearedIds)
 {
 	TArray<uint32> UpdateFields;
-	UpdateFields.SetNum(Schema_GetUniqueFieldIdCount(ComponentObject));
-	Schema_GetUniqueFieldIds(ComponentObject, UpdateFields.GetData());
+	GetFieldIds(ComponentObject, UpdateFields);
 
 	if (UpdateFields.Num() == 0)
 	{
@@ -230,22 +302,24 @@ void ComponentReader::ApplyHandoverSchemaObject(Schema_Object* ComponentObject,
 	Channel->PostReceiveSpatialUpdate(Object, TArray<UProperty*>());
 }
 
-void ComponentReader::ApplyProperty(Schema_Object* Object, Schema_FieldId FieldId, FObjectReferencesMap& InObjectReferencesMap, uint32 Index, UProperty* Property, uint8* Data, int32 Offset, int32 ParentIndex)
+template <typename TFieldSource>
+void ComponentReader::ApplyProperty(TFieldSource Object, Schema_FieldId FieldId, FObjectReferencesMap& InObjectReferencesMap, uint32 Index, UProperty* Property, uint8* Data, int32 Offset, int32 ParentIndex)
 {
 	if (UStructProperty* StructProperty = Cast<UStructProperty>(Property))
 	{
-		TArray<uint8> ValueData = IndexPayloadFromSchema(Object, FieldId, Index);
+		FSchemaPayloadView ValueData = IndexPayload(Object, FieldId, Index);
 		// A bit hacky, we should probably include the number of bits with the data instead.
 		int64 CountBits = ValueData.Num() * 8;
 		TSet<FUnrealObjectRef> NewUnresolvedRefs;
-		FSpatialNetBitReader ValueDataReader(PackageMap, ValueData.GetData(), CountBits, NewUnresolvedRefs);
+		FSpatialNetBitReader ValueDataReader(PackageMap, ValueData, CountBits, NewUnresolvedRefs);
 		bool bHasUnmapped = false;
 
 		ReadStructProperty(ValueDataReader, StructProperty, NetDriver, Data, bHasUnmapped);
 
 		if (bHasUnmapped)
 		{
-			InObjectReferencesMap.Add(Offset, FObjectReferences(ValueData, CountBits, NewUnresolvedRefs, ParentIndex, Property));
+			// Only structs left waiting on refs keep a copy of their payload.
+			InObjectReferencesMap.Add(Offset, FObjectReferences(TArray<uint8>(ValueData.GetData(), ValueData.Num()), CountBits, NewUnresolvedRefs, ParentIndex, Property));
 			UnresolvedRefs.Append(NewUnresolvedRefs);
 		}
 		else if (InObjectReferencesMap.Find(Offset))
@@ -255,51 +329,51 @@ void ComponentReader::ApplyProperty(Schema_Object* Object, Schema_FieldId FieldI
 	}
 	else if (UBoolProperty* BoolProperty = Cast<UBoolProperty>(Property))
 	{
-		BoolProperty->SetPropertyValue(Data, Schema_IndexBool(Object, FieldId, Index) != 0);
+		BoolProperty->SetPropertyValue(Data, IndexBool(Object, FieldId, Index));
 	}
 	else if (UFloatProperty* FloatProperty = Cast<UFloatProperty>(Property))
 	{
-		FloatProperty->SetPropertyValue(Data, Schema_IndexFloat(Object, FieldId, Index));
+		FloatProperty->SetPropertyValue(Data, IndexFloat(Object, FieldId, Index));
 	}
 	else if (UDoubleProperty* DoubleProperty = Cast<UDoubleProperty>(Property))
 	{
-		DoubleProperty->SetPropertyValue(Data, Schema_IndexDouble(Object, FieldId, Index));
+		DoubleProperty->SetPropertyValue(Data, IndexDouble(Object, FieldId, Index));
 	}
 	else if (UInt8Property* Int8Property = Cast<UInt8Property>(Property))
 	{
-		Int8Property->SetPropertyValue(Data, (int8)Schema_IndexInt32(Object, FieldId, Index));
+		Int8Property->SetPropertyValue(Data, (int8)IndexInt32(Object, FieldId, Index));
 	}
 	else if (UInt16Property* Int16Property = Cast<UInt16Property>(Property))
 	{
-		Int16Property->SetPropertyValue(Data, (int16)Schema_IndexInt32(Object, FieldId, Index));
+		Int16Property->SetPropertyValue(Data, (int16)IndexInt32(Object, FieldId, Index));
 	}
 	else if (UIntProperty* IntProperty = Cast<UIntProperty>(Property))
 	{
-		IntProperty->SetPropertyValue(Data, Schema_IndexInt32(Object, FieldId, Index));
+		IntProperty->SetPropertyValue(Data, IndexInt32(Object, FieldId, Index));
 	}
 	else if (UInt64Property* Int64Property = Cast<UInt64Property>(Property))
 	{
-		Int64Property->SetPropertyValue(Data, Schema_IndexInt64(Object, FieldId, Index));
+		Int64Property->SetPropertyValue(Data, IndexInt64(Object, FieldId, Index));
 	}
 	else if (UByteProperty* ByteProperty = Cast<UByteProperty>(Property))
 	{
-		ByteProperty->SetPropertyValue(Data, (uint8)Schema_IndexUint32(Object, FieldId, Index));
+		ByteProperty->SetPropertyValue(Data, (uint8)IndexUint32(Object, FieldId, Index));
 	}
 	else if (UUInt16Property* UInt16Property = Cast<UUInt16Property>(Property))
 	{
-		UInt16Property->SetPropertyValue(Data, (uint16)Schema_IndexUint32(Object, FieldId, Index));
+		UInt16Property->SetPropertyValue(Data, (uint16)IndexUint32(Object, FieldId, Index));
 	}
 	else if (UUInt32Property* UInt32Property = Cast<UUInt32Property>(Property))
 	{
-		UInt32Property->SetPropertyValue(Data, Schema_IndexUint32(Object, FieldId, Index));
+		UInt32Property->SetPropertyValue(Data, IndexUint32(Object, FieldId, Index));
 	}
 	else if (UUInt64Property* UInt64Property = Cast<UUInt64Property>(Property))
 	{
-		UInt64Property->SetPropertyValue(Data, Schema_IndexUint64(Object, FieldId, Index));
+		UInt64Property->SetPropertyValue(Data, IndexUint64(Object, FieldId, Index));
 	}
 	else if (UObjectPropertyBase* ObjectProperty = Cast<UObjectPropertyBase>(Property))
 	{
-		FUnrealObjectRef ObjectRef = IndexObjectRefFromSchema(Object, FieldId, Index);
+		const FUnrealObjectRef& ObjectRef = IndexObjectRef(Object, FieldId, Index);
 		check(ObjectRef != SpatialConstants::UNRESOLVED_OBJECT_REF);
 		bool bUnresolved = false;
 
@@ -342,21 +416,21 @@ void ComponentReader::ApplyProperty(Schema_Object* Object, Schema_FieldId FieldI
 	}
 	else if (UNameProperty* NameProperty = Cast<UNameProperty>(Property))
 	{
-		NameProperty->SetPropertyValue(Data, FName(*IndexStringFromSchema(Object, FieldId, Index)));
+		NameProperty->SetPropertyValue(Data, FName(*IndexString(Object, FieldId, Index)));
 	}
 	else if (UStrProperty* StrProperty = Cast<UStrProperty>(Property))
 	{
-		StrProperty->SetPropertyValue(Data, IndexStringFromSchema(Object, FieldId, Index));
+		StrProperty->SetPropertyValue(Data, IndexString(Object, FieldId, Index));
 	}
 	else if (UTextProperty* TextProperty = Cast<UTextProperty>(Property))
 	{
-		TextProperty->SetPropertyValue(Data, FText::FromString(IndexStringFromSchema(Object, FieldId, Index)));
+		TextProperty->SetPropertyValue(Data, FText::FromString(IndexString(Object, FieldId, Index)));
 	}
 	else if (UEnumProperty* EnumProperty = Cast<UEnumProperty>(Property))
 	{
 		if (EnumProperty->ElementSize < 4)
 		{
-			EnumProperty->GetUnderlyingProperty()->SetIntPropertyValue(Data, (uint64)Schema_IndexUint32(Object, FieldId, Index));
+			EnumProperty->GetUnderlyingProperty()->SetIntPropertyValue(Data, (uint64)IndexUint32(Object, FieldId, Index));
 		}
 		else
 		{
@@ -369,7 +443,8 @@ void ComponentReader::ApplyProperty(Schema_Object* Object, Schema_FieldId FieldI
 	}
 }
 
-void ComponentReader::ApplyArray(Schema_Object* Object, Schema_FieldId FieldId, FObjectReferencesMap& InObjectReferencesMap, UArrayProperty* Property, uint8* Data, int32 Offset, int32 ParentIndex)
+template <typename TFieldSource>
+void ComponentReader::ApplyArray(TFieldSource Object, Schema_FieldId FieldId, FObjectReferencesMap& InObjectReferencesMap, UArrayProperty* Property, uint8* Data, int32 Offset, int32 ParentIndex)
 {
 	FObjectReferencesMap* ArrayObjectReferences;
 	bool bNewArrayMap = false;
@@ -417,6 +492,13 @@ void ComponentReader::ApplyArray(Schema_Object* Object, Schema_FieldId FieldId,
 	}
 }
 
+uint32 ComponentReader::GetPropertyCount(const FDecodedComponentData* DecodedData, Schema_FieldId FieldId, UProperty* Property)
+{
+	// A field only ever holds values of its property's type, so there's no need to look at the property.
+	const FDecodedSchemaField* Field = DecodedData->FindField(FieldId);
+	return Field != nullptr ? Field->Num() : 0;
+}
+
 uint32 ComponentReader::GetPropertyCount(const Schema_Object* Object, Schema_FieldId FieldId, UProperty* Property)
 {
 	if (UStructProperty* StructProperty = Cast<UStructProperty>(Property))
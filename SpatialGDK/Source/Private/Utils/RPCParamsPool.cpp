@@ -0,0 +1,136 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "Utils/RPCParamsPool.h"
+
+#include "UObject/Class.h"
+#include "UObject/UnrealType.h"
+
+#include "Interop/Connection/SpatialWorkerConnection.h"
+#include "SpatialConstants.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Client RPC param buffers allocated"), STAT_SpatialClientRPCParamAllocations, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Server RPC param buffers allocated"), STAT_SpatialServerRPCParamAllocations, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("CrossServer RPC param buffers allocated"), STAT_SpatialCrossServerRPCParamAllocations, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Multicast RPC param buffers allocated"), STAT_SpatialMulticastRPCParamAllocations, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPC param buffers reused"), STAT_SpatialRPCParamBuffersReused, STATGROUP_SpatialNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPC params copied with memcpy"), STAT_SpatialPlainOldDataRPCParams, STATGROUP_SpatialNet);
+DECLARE_MEMORY_STAT(TEXT("RPC param buffers"), STAT_SpatialRPCParamBufferMemory, STATGROUP_SpatialNet);
+
+namespace
+{
+	void CountAllocation(const UFunction* Function)
+	{
+		// Same precedence as the RPC types in USpatialTypebindingManager.
+		if (Function->HasAnyFunctionFlags(FUNC_NetClient))
+		{
+			INC_DWORD_STAT(STAT_SpatialClientRPCParamAllocations);
+		}
+		else if (Function->HasAnyFunctionFlags(FUNC_NetServer))
+		{
+			INC_DWORD_STAT(STAT_SpatialServerRPCParamAllocations);
+		}
+		else if (Function->HasAnyFunctionFlags(FUNC_NetCrossServer))
+		{
+			INC_DWORD_STAT(STAT_SpatialCrossServerRPCParamAllocations);
+		}
+		else if (Function->HasAnyFunctionFlags(FUNC_NetMulticast))
+		{
+			INC_DWORD_STAT(STAT_SpatialMulticastRPCParamAllocations);
+		}
+	}
+}
+
+FRPCParamsPool::~FRPCParamsPool()
+{
+	for (auto& Pair : FunctionPools)
+	{
+		for (uint8* Buffer : Pair.Value.FreeBuffers)
+		{
+			FMemory::Free(Buffer);
+		}
+		DEC_MEMORY_STAT_BY(STAT_SpatialRPCParamBufferMemory, Pair.Value.FreeBuffers.Num() * Pair.Value.BufferSize);
+	}
+}
+
+FRPCParamsPool::FFunctionPool& FRPCParamsPool::FindOrAddFunctionPool(UFunction* Function)
+{
+	if (FFunctionPool* Pool = FunctionPools.Find(Function))
+	{
+		return *Pool;
+	}
+
+	FFunctionPool& Pool = FunctionPools.Add(Function);
+	Pool.BufferSize = FMath::Max(Function->ParmsSize, 1);
+	Pool.bIsPlainOldData = true;
+	for (TFieldIterator<UProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
+	{
+		if (!It->HasAnyPropertyFlags(CPF_IsPlainOldData))
+		{
+			Pool.bIsPlainOldData = false;
+			break;
+		}
+	}
+
+	return Pool;
+}
+
+uint8* FRPCParamsPool::Acquire(UFunction* Function, void* InParameters)
+{
+	check(IsInGameThread());
+
+	FFunctionPool& Pool = FindOrAddFunctionPool(Function);
+
+	uint8* Buffer;
+	if (Pool.FreeBuffers.Num() > 0)
+	{
+		Buffer = Pool.FreeBuffers.Pop(/* bAllowShrinking */ false);
+		INC_DWORD_STAT(STAT_SpatialRPCParamBuffersReused);
+	}
+	else
+	{
+		Buffer = (uint8*)FMemory::Malloc(Pool.BufferSize, Function->GetMinAlignment());
+		INC_MEMORY_STAT_BY(STAT_SpatialRPCParamBufferMemory, Pool.BufferSize);
+		CountAllocation(Function);
+	}
+
+	if (Pool.bIsPlainOldData)
+	{
+		FMemory::Memcpy(Buffer, InParameters, Function->ParmsSize);
+		INC_DWORD_STAT(STAT_SpatialPlainOldDataRPCParams);
+		return Buffer;
+	}
+
+	FMemory::Memzero(Buffer, Function->ParmsSize);
+	for (TFieldIterator<UProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
+	{
+		It->InitializeValue_InContainer(Buffer);
+		It->CopyCompleteValue_InContainer(Buffer, InParameters);
+	}
+
+	return Buffer;
+}
+
+void FRPCParamsPool::Release(UFunction* Function, uint8* Buffer)
+{
+	check(IsInGameThread());
+
+	FFunctionPool& Pool = FindOrAddFunctionPool(Function);
+
+	if (!Pool.bIsPlainOldData)
+	{
+		for (TFieldIterator<UProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
+		{
+			It->DestroyValue_InContainer(Buffer);
+		}
+	}
+
+	if (Pool.FreeBuffers.Num() < SpatialConstants::RPC_PARAMS_POOL_MAX_FREE_BUFFERS_PER_FUNCTION)
+	{
+		Pool.FreeBuffers.Add(Buffer);
+	}
+	else
+	{
+		FMemory::Free(Buffer);
+		DEC_MEMORY_STAT_BY(STAT_SpatialRPCParamBufferMemory, Pool.BufferSize);
+	}
+}
@@ -23,4 +23,58 @@ void GetFullPathFromUnrealObjectReference(const FUnrealObjectRef& ObjectRef, FSt
 	OutPath.Append(*ObjectRef.Path);
 }
 
+void MergeComponentUpdate(Schema_ComponentUpdate* Target, Schema_ComponentUpdate* Update)
+{
+	Schema_Object* TargetFields = Schema_GetComponentUpdateFields(Target);
+	Schema_Object* UpdateFields = Schema_GetComponentUpdateFields(Update);
+
+	TArray<Schema_FieldId> UpdatedIds;
+	UpdatedIds.SetNum(Schema_GetUniqueFieldIdCount(UpdateFields));
+	Schema_GetUniqueFieldIds(UpdateFields, UpdatedIds.GetData());
+
+	// Drop the old values first, merging only appends and would turn singular fields into lists.
+	for (Schema_FieldId FieldId : UpdatedIds)
+	{
+		Schema_ClearField(TargetFields, FieldId);
+	}
+
+	if (UpdatedIds.Num() > 0)
+	{
+		uint32 Length = Schema_GetWriteBufferLength(UpdateFields);
+		uint8* Buffer = Schema_AllocateBuffer(TargetFields, Length);
+		Schema_WriteToBuffer(UpdateFields, Buffer);
+		Schema_MergeFromBuffer(TargetFields, Buffer, Length);
+	}
+
+	TArray<Schema_FieldId> TargetClearedIds;
+	TargetClearedIds.SetNum(Schema_GetComponentUpdateClearedFieldCount(Target));
+	Schema_GetComponentUpdateClearedFieldList(Target, TargetClearedIds.GetData());
+
+	TArray<Schema_FieldId> ClearedIds;
+	ClearedIds.SetNum(Schema_GetComponentUpdateClearedFieldCount(Update));
+	Schema_GetComponentUpdateClearedFieldList(Update, ClearedIds.GetData());
+
+	for (Schema_FieldId FieldId : ClearedIds)
+	{
+		// A list cleared by the later update loses anything the earlier one added to it.
+		Schema_ClearField(TargetFields, FieldId);
+
+		if (!TargetClearedIds.Contains(FieldId))
+		{
+			Schema_AddComponentUpdateClearedField(Target, FieldId);
+		}
+	}
+
+	// Events are never coalesced, every occurrence is kept in order.
+	Schema_Object* UpdateEvents = Schema_GetComponentUpdateEvents(Update);
+	if (Schema_GetUniqueFieldIdCount(UpdateEvents) > 0)
+	{
+		Schema_Object* TargetEvents = Schema_GetComponentUpdateEvents(Target);
+		uint32 Length = Schema_GetWriteBufferLength(UpdateEvents);
+		uint8* Buffer = Schema_AllocateBuffer(TargetEvents, Length);
+		Schema_WriteToBuffer(UpdateEvents, Buffer);
+		Schema_MergeFromBuffer(TargetEvents, Buffer, Length);
+	}
+}
+
 }  // namespace improbable
@@ -0,0 +1,165 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#include "Utils/SpatialPositionIndex.h"
+
+FSpatialPositionIndex::FSpatialPositionIndex(double InCellSize)
+	: CellSize(InCellSize)
+	, InvCellSize(1.0 / InCellSize)
+{
+	check(InCellSize > 0.0);
+}
+
+FIntPoint FSpatialPositionIndex::GetCell(double X, double Z) const
+{
+	// Clamp so entities far outside the world can't overflow the cell coordinates.
+	const double MaxCell = double(MAX_int32 / 2);
+	return FIntPoint(
+		int32(FMath::Clamp(FMath::FloorToDouble(X * InvCellSize), -MaxCell, MaxCell)),
+		int32(FMath::Clamp(FMath::FloorToDouble(Z * InvCellSize), -MaxCell, MaxCell)));
+}
+
+void FSpatialPositionIndex::AddOrUpdate(Worker_EntityId EntityId, const improbable::Coordinates& Coords)
+{
+	const FIntPoint NewCell = GetCell(Coords.X, Coords.Z);
+
+	if (FEntry* Entry = Entries.Find(EntityId))
+	{
+		Entry->Coords = Coords;
+
+		if (Entry->Cell == NewCell)
+		{
+			return;
+		}
+
+		TArray<Worker_EntityId>& OldCellEntities = Cells.FindChecked(Entry->Cell);
+		OldCellEntities.RemoveSingleSwap(EntityId, false);
+		if (OldCellEntities.Num() == 0)
+		{
+			Cells.Remove(Entry->Cell);
+		}
+
+		Entry->Cell = NewCell;
+	}
+	else
+	{
+		Entries.Add(EntityId, FEntry{ Coords, NewCell });
+	}
+
+	Cells.FindOrAdd(NewCell).Add(EntityId);
+}
+
+void FSpatialPositionIndex::Remove(Worker_EntityId EntityId)
+{
+	FEntry Entry;
+	if (!Entries.RemoveAndCopyValue(EntityId, Entry))
+	{
+		return;
+	}
+
+	TArray<Worker_EntityId>& CellEntities = Cells.FindChecked(Entry.Cell);
+	CellEntities.RemoveSingleSwap(EntityId, false);
+	if (CellEntities.Num() == 0)
+	{
+		Cells.Remove(Entry.Cell);
+	}
+}
+
+void FSpatialPositionIndex::Reset()
+{
+	Entries.Reset();
+	Cells.Reset();
+}
+
+template <typename Predicate>
+void FSpatialPositionIndex::Query(const improbable::Coordinates& Min, const improbable::Coordinates& Max, Predicate&& IsInside, TArray<Worker_EntityId>& OutEntityIds) const
+{
+	if (Min.X > Max.X || Min.Y > Max.Y || Min.Z > Max.Z)
+	{
+		return;
+	}
+
+	const FIntPoint MinCell = GetCell(Min.X, Min.Z);
+	const FIntPoint MaxCell = GetCell(Max.X, Max.Z);
+	const int64 NumQueryCells = int64(MaxCell.X - MinCell.X + 1) * int64(MaxCell.Y - MinCell.Y + 1);
+
+	// For queries covering more cells than are occupied, walking the occupied cells is cheaper.
+	if (NumQueryCells > Cells.Num())
+	{
+		for (const auto& Pair : Cells)
+		{
+			if (Pair.Key.X < MinCell.X || Pair.Key.X > MaxCell.X || Pair.Key.Y < MinCell.Y || Pair.Key.Y > MaxCell.Y)
+			{
+				continue;
+			}
+
+			for (Worker_EntityId EntityId : Pair.Value)
+			{
+				if (IsInside(Entries.FindChecked(EntityId).Coords))
+				{
+					OutEntityIds.Add(EntityId);
+				}
+			}
+		}
+		return;
+	}
+
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+	{
+		for (int32 CellZ = MinCell.Y; CellZ <= MaxCell.Y; CellZ++)
+		{
+			const TArray<Worker_EntityId>* CellEntities = Cells.Find(FIntPoint(CellX, CellZ));
+			if (CellEntities == nullptr)
+			{
+				continue;
+			}
+
+			for (Worker_EntityId EntityId : *CellEntities)
+			{
+				if (IsInside(Entries.FindChecked(EntityId).Coords))
+				{
+					OutEntityIds.Add(EntityId);
+				}
+			}
+		}
+	}
+}
+
+void FSpatialPositionIndex::QueryRadius(const improbable::Coordinates& Center, double Radius, TArray<Worker_EntityId>& OutEntityIds) const
+{
+	if (Radius < 0.0)
+	{
+		return;
+	}
+
+	const improbable::Coordinates Min{ Center.X - Radius, Center.Y - Radius, Center.Z - Radius };
+	const improbable::Coordinates Max{ Center.X + Radius, Center.Y + Radius, Center.Z + Radius };
+	const double RadiusSquared = Radius * Radius;
+
+	Query(Min, Max, [&Center, RadiusSquared](const improbable::Coordinates& Coords)
+	{
+		const double DX = Coords.X - Center.X;
+		const double DY = Coords.Y - Center.Y;
+		const double DZ = Coords.Z - Center.Z;
+		return DX * DX + DY * DY + DZ * DZ <= RadiusSquared;
+	}, OutEntityIds);
+}
+
+void FSpatialPositionIndex::QueryBox(const improbable::Coordinates& Min, const improbable::Coordinates& Max, TArray<Worker_EntityId>& OutEntityIds) const
+{
+	Query(Min, Max, [&Min, &Max](const improbable::Coordinates& Coords)
+	{
+		return Coords.X >= Min.X && Coords.X <= Max.X
+			&& Coords.Y >= Min.Y && Coords.Y <= Max.Y
+			&& Coords.Z >= Min.Z && Coords.Z <= Max.Z;
+	}, OutEntityIds);
+}
+
+SIZE_T FSpatialPositionIndex::GetAllocatedSize() const
+{
+	SIZE_T Size = Entries.GetAllocatedSize() + Cells.GetAllocatedSize();
+	for (const auto& Pair : Cells)
+	{
+		Size += Pair.Value.GetAllocatedSize();
+	}
+	return Size;
+}
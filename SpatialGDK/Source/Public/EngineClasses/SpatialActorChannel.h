@@ -95,7 +95,13 @@ public:
 	// For an object that is replicated by this channel (i.e. this channel's actor or its component), find out whether a given handle is an array.
 	bool IsDynamicArrayHandle(UObject* Object, uint16 Handle);
 
-	void SpatialViewTick();
+	// Re-evaluates net ownership and updates ACLs or component interest if it changed.
+	// Only called for channels marked dirty, see USpatialNetDriver::MarkOwnershipDirty. Returns true if it needs to be called again.
+	bool SpatialViewTick();
+	FORCEINLINE bool IsNetOwned() const { return bNetOwned; }
+
+	// Cheap check for a new owner or, for player controllers, a new player state. Marks the channel dirty if either changed.
+	void CheckOwnershipChanged();
 	FObjectReplicator& PreReceiveSpatialUpdate(UObject* TargetObject);
 	void PostReceiveSpatialUpdate(UObject* TargetObject, const TArray<UProperty*>& RepNotifies);
 
@@ -124,6 +130,10 @@ private:
 	bool bFirstTick;
 	bool bNetOwned;
 
+	// Used by CheckOwnershipChanged. Weak, so an owner that was garbage collected still compares as a change.
+	TWeakObjectPtr<AActor> CachedOwner;
+	bool bCachedHasPlayerState;
+
 	UPROPERTY(transient)
 	USpatialNetDriver* NetDriver;
 
@@ -135,6 +145,7 @@ private:
 
 	FVector LastSpatialPosition;
 	FRotator LastSpatialRotation;
+	FSpatialTransformReplicationSettings TransformSettings;
 
 	// Shadow data for Handover properties.
 	// For each object with handover properties, we store a blob of memory which contains
@@ -145,4 +156,8 @@ private:
 
 	// If this actor channel is responsible for creating a new entity, this will be set to true during initial replication.
 	bool bCreatingNewEntity;
+
+	// Bytes of component data written by the current ReplicateActor call: the entity creation request, or the updates
+	// of the actor, its subobjects and its position and rotation.
+	uint32 ReplicationBytesWritten;
 };
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/ArrayView.h"
 #include "UObject/CoreNet.h"
 
 #include "UObject/improbable/UnrealObjectRef.h"
@@ -16,6 +17,9 @@ class SPATIALGDK_API FSpatialNetBitReader : public FNetBitReader
 public:
 	FSpatialNetBitReader(USpatialPackageMapClient* InPackageMap, uint8* Source, int64 CountBits, TSet<FUnrealObjectRef>& InUnresolvedRefs);
 
+	// Reads straight from a payload view, e.g. one pointing into SDK-owned schema data, without staging it in a TArray first.
+	FSpatialNetBitReader(USpatialPackageMapClient* InPackageMap, TArrayView<const uint8> Source, int64 CountBits, TSet<FUnrealObjectRef>& InUnresolvedRefs);
+
 	using FArchive::operator<<; // For visibility of the overloads we don't override
 
 	virtual FArchive& operator<<(UObject*& Value) override;
@@ -3,12 +3,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/Future.h"
 #include "IpNetDriver.h"
 #include "OnlineSubsystemNames.h"
 #include "UObject/CoreOnline.h"
 
+#include "EngineClasses/SpatialReplicationSettings.h"
 #include "Interop/Connection/ConnectionConfig.h"
 #include "Interop/SpatialOutputDevice.h"
+#include "Interop/SpatialViewCache.h"
 #include "SpatialConstants.h"
 
 #include <WorkerSDK/improbable/c_worker.h>
@@ -28,6 +31,8 @@ class UGlobalStateManager;
 class USpatialPlayerSpawner;
 class USpatialStaticComponentView;
 class USnapshotManager;
+class USpatialActorPool;
+class USpatialRetryScheduler;
 
 class UEntityRegistry;
 
@@ -68,10 +73,14 @@ public:
 	virtual void TickFlush(float DeltaTime) override;
 	virtual bool IsLevelInitializedForActor(const AActor* InActor, const UNetConnection* InConnection) const override;
 	virtual void NotifyActorDestroyed(AActor* Actor, bool IsSeamlessTravel = false) override;
+	virtual void Shutdown() override;
 	// End UNetDriver interface.
 
 #if !UE_BUILD_SHIPPING
 	bool HandleNetDumpCrossServerRPCCommand(const TCHAR* Cmd, FOutputDevice& Ar);
+	bool HandleRecordOpsCommand(const TCHAR* Cmd, FOutputDevice& Ar);
+	bool HandleOpStatsCommand(const TCHAR* Cmd, FOutputDevice& Ar);
+	bool HandleViewBenchmarkCommand(const TCHAR* Cmd, FOutputDevice& Ar);
 #endif
 
 	// Returns the "100% reliable" connection to SpatialOS.
@@ -83,6 +92,9 @@ public:
 
 	UEntityRegistry* GetEntityRegistry() { return EntityRegistry; }
 
+	// From the -replicationSettings asset if there is one, the defaults otherwise.
+	const FSpatialTransformReplicationSettings& GetTransformReplicationSettings(const UClass* ActorClass) const;
+
 	// When the AcceptingPlayers state on the GSM has changed this method will be called.
 	void OnAcceptingPlayersChanged(bool bAcceptingPlayers);
 
@@ -94,6 +106,13 @@ public:
 
 	USpatialActorChannel* GetActorChannelByEntityId(Worker_EntityId EntityId) const;
 
+	// Ownership changes are tracked per channel instead of checking every channel each tick, with a sweep over every
+	// channel every SpatialConstants::OWNERSHIP_SWEEP_INTERVAL_SECONDS as a fallback. Dirty channels are re-evaluated (ACLs on servers, component interest on clients) by ProcessOwnershipChanges.
+	void MarkOwnershipDirty(USpatialActorChannel* Channel);
+	void OnChannelOwnerChanged(USpatialActorChannel* Channel, const TWeakObjectPtr<AActor>& OldOwner, AActor* NewOwner);
+	void RemoveOwnershipTracking(USpatialActorChannel* Channel, const TWeakObjectPtr<AActor>& Owner);
+	void ProcessOwnershipChanges();
+
 	DECLARE_DELEGATE(PostWorldWipeDelegate);
 
 	void WipeWorld(const USpatialNetDriver::PostWorldWipeDelegate& LoadSnapshotAfterWorldWipe);
@@ -120,6 +139,12 @@ public:
 	UEntityRegistry* EntityRegistry;
 	UPROPERTY()
 	USnapshotManager* SnapshotManager;
+	UPROPERTY()
+	USpatialActorPool* ActorPool;
+	UPROPERTY()
+	USpatialRetryScheduler* RetryScheduler;
+	UPROPERTY()
+	USpatialReplicationSettings* ReplicationSettings;
 
 	TMap<UClass*, TPair<AActor*, USpatialActorChannel*>> SingletonActorChannels;
 
@@ -132,15 +157,37 @@ private:
 
 	TMap<Worker_EntityId_Key, USpatialActorChannel*> EntityToActorChannel;
 
+	// Channels are removed from these in USpatialActorChannel::CleanUp.
+	TSet<USpatialActorChannel*> OwnershipDirtyChannels;
+	TMap<TWeakObjectPtr<AActor>, TSet<USpatialActorChannel*>> ChannelsByOwner;
+	double LastOwnershipSweepTime;
+
 	// Timer manager.
 	FTimerManager* TimerManager;
 
+	// Warm-start cache of the static component view, enabled with -viewCacheFile.
+	FString ViewCacheFilePath;
+	FString ViewCacheMapName;
+	TUniquePtr<FSpatialViewCache> ViewCache;
+	FTimerHandle ViewCacheSaveTimer;
+	FTimerHandle ViewCacheReleaseTimer;
+	// The periodic save writes its snapshot out on the thread pool, at most one at a time.
+	TFuture<bool> ViewCacheWriteTask;
+
 	bool bAuthoritativeDestruction;
 	bool bConnectAsClient;
 	bool bPersistSpatialConnection;
 	bool bWaitingForAcceptingPlayersToSpawn;
 	FString SnapshotToLoad;
 
+	// Replication budget, shared by all connections. Actors that don't fit in a tick keep their priority for the next one:
+	// DeferredPriorities collects them and becomes CarriedOverPriorities at the start of the next tick, which drops
+	// whatever the tick before didn't use.
+	int32 ReplicationBytesPerTick;
+	int64 ReplicationBytesThisTick;
+	TMap<TWeakObjectPtr<AActor>, int32> CarriedOverPriorities;
+	TMap<TWeakObjectPtr<AActor>, int32> DeferredPriorities;
+
 	UFUNCTION()
 	void OnMapLoaded(UWorld* LoadedWorld);
 
@@ -152,6 +199,11 @@ private:
 	UFUNCTION()
 	void OnConnectFailed(const FString& Reason);
 
+	void InitViewCache();
+	void SaveViewCache();
+	void SaveViewCacheAsync();
+	void ReleaseViewCache();
+
 	static void SpatialProcessServerTravel(const FString& URL, bool bAbsolute, AGameModeBase* GameMode);
 		
 #if WITH_SERVER_CODE
@@ -160,6 +212,7 @@ private:
 	int32 ServerReplicateActors_PrepConnections(const float DeltaSeconds);
 	int32 ServerReplicateActors_PrioritizeActors(UNetConnection* Connection, const TArray<FNetViewer>& ConnectionViewers, const TArray<FNetworkObjectInfo*> ConsiderList, const bool bCPUSaturated, FActorPriority*& OutPriorityList, FActorPriority**& OutPriorityActors);
 	int32 ServerReplicateActors_ProcessPrioritizedActors(UNetConnection* Connection, const TArray<FNetViewer>& ConnectionViewers, FActorPriority** PriorityActors, const int32 FinalSortedCount, int32& OutUpdated);
+	bool IsReplicationBudgetSpent() const;
 #endif
 
 	friend class USpatialNetConnection;
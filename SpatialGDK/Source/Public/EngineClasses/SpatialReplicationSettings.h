@@ -0,0 +1,47 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "GameFramework/Actor.h"
+
+#include "SpatialConstants.h"
+
+#include "SpatialReplicationSettings.generated.h"
+
+// How closely the Position and Rotation components of an actor's entity follow the actor.
+USTRUCT(BlueprintType)
+struct SPATIALGDK_API FSpatialTransformReplicationSettings
+{
+	GENERATED_BODY()
+
+	// Distance in cm the actor has to move before its Position is updated. Load balancing hands entities over by Position.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SpatialOS", meta = (ClampMin = "0.0"))
+	float PositionThreshold = SpatialConstants::POSITION_UPDATE_DEFAULT_THRESHOLD_CM;
+
+	// Angle in radians the actor has to turn before its Rotation is updated.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SpatialOS", meta = (ClampMin = "0.0"))
+	float RotationThreshold = SpatialConstants::ROTATION_UPDATE_DEFAULT_THRESHOLD_RADIANS;
+
+	// Round Rotation to 16 bits per axis, also sent packed into one field that readers prefer over the floats.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SpatialOS")
+	bool bQuantizeRotation = false;
+};
+
+// Per-class transform replication settings, picked up by servers from the asset passed as -replicationSettings=<AssetPath>.
+UCLASS(BlueprintType)
+class SPATIALGDK_API USpatialReplicationSettings : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Settings of the closest class up ActorClass's hierarchy that has an entry, or the defaults.
+	const FSpatialTransformReplicationSettings& GetTransformSettings(const UClass* ActorClass) const;
+
+	UPROPERTY(EditAnywhere, Category = "SpatialOS")
+	FSpatialTransformReplicationSettings DefaultTransformSettings;
+
+	UPROPERTY(EditAnywhere, Category = "SpatialOS")
+	TMap<TSubclassOf<AActor>, FSpatialTransformReplicationSettings> ClassTransformSettings;
+};
@@ -15,12 +15,14 @@ struct FConnectionConfig
 		: UseExternalIp(false)
 		, EnableProtocolLoggingAtStartup(false)
 		, LinkProtocol(WORKER_NETWORK_CONNECTION_TYPE_RAKNET)
+		, UseOpListThread(false)
 	{
 		const TCHAR* CommandLine = FCommandLine::Get();
 
 		FParse::Value(CommandLine, TEXT("workerType"), WorkerType);
 		FParse::Value(CommandLine, TEXT("workerId"), WorkerId);
 		FParse::Bool(CommandLine, TEXT("useExternalIpForBridge"), UseExternalIp);
+		FParse::Bool(CommandLine, TEXT("useOpListThread"), UseOpListThread);
 
 		FString LinkProtocolString;
 		FParse::Value(CommandLine, TEXT("linkProtocol"), LinkProtocolString);
@@ -33,6 +35,9 @@ struct FConnectionConfig
 	bool EnableProtocolLoggingAtStartup;
 	Worker_NetworkConnectionType LinkProtocol;
 	Worker_ConnectionParameters ConnectionParams;
+
+	// Drain op lists on a dedicated thread instead of polling the connection from TickDispatch.
+	bool UseOpListThread;
 };
 
 struct FReceptionistConfig : public FConnectionConfig
@@ -40,15 +45,22 @@ struct FReceptionistConfig : public FConnectionConfig
 	FReceptionistConfig()
 		: ReceptionistHost(SpatialConstants::LOCAL_HOST)
 		, ReceptionistPort(SpatialConstants::DEFAULT_PORT)
+		, ExitAfterOpListReplay(false)
 	{
 		const TCHAR* CommandLine = FCommandLine::Get();
 
 		FParse::Value(CommandLine, TEXT("receptionistHost"), ReceptionistHost);
 		FParse::Value(CommandLine, TEXT("receptionistPort"), ReceptionistPort);
+		FParse::Value(CommandLine, TEXT("replayOpListFile"), ReplayOpListFile);
+		FParse::Bool(CommandLine, TEXT("exitAfterOpListReplay"), ExitAfterOpListReplay);
 	}
 
 	FString ReceptionistHost;
 	uint16 ReceptionistPort;
+
+	// When set, no connection is made and op lists are read from this recording instead (see FOpListRecorder).
+	FString ReplayOpListFile;
+	bool ExitAfterOpListReplay;
 };
 
 struct FLocatorConfig : public FConnectionConfig
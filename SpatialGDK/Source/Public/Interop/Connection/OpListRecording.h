@@ -0,0 +1,97 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <WorkerSDK/improbable/c_schema.h>
+#include <WorkerSDK/improbable/c_worker.h>
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSpatialOpListRecording, Log, All);
+
+class FArchive;
+
+// Writes every op list handed to RecordOpList into a binary file, preserving op list boundaries.
+// Schema objects are stored in their serialized wire form, so the file can be replayed by FOpListReplayer
+// without a SpatialOS runtime. Metrics ops are not recorded.
+class SPATIALGDK_API FOpListRecorder
+{
+public:
+	~FOpListRecorder();
+
+	bool Open(const FString& FilePath, const FString& WorkerId);
+	void Close();
+
+	FORCEINLINE bool IsRecording() const { return Writer.IsValid(); }
+
+	void RecordOpList(const Worker_OpList* OpList);
+
+private:
+	void WriteOp(const Worker_Op& Op);
+	void WriteString(const char* String);
+	void WriteEntityId(Worker_EntityId EntityId);
+	void WriteRequestId(Worker_RequestId RequestId);
+	void WriteSchemaObject(Schema_Object* Object);
+	void WriteComponentData(const Worker_ComponentData& Data);
+	void WriteComponentUpdate(const Worker_ComponentUpdate& Update);
+
+	TUniquePtr<FArchive> Writer;
+	FString RecordingPath;
+
+	double StartTime = 0.0;
+	uint32 NumOpListsRecorded = 0;
+	uint64 NumOpsRecorded = 0;
+
+	TArray<uint8> ScratchBuffer;
+};
+
+// Reads a file written by FOpListRecorder back into op lists that can be passed to USpatialDispatcher::QueueOpList.
+// All memory referenced by a replayed op list, including schema objects, is owned by the replayer.
+class SPATIALGDK_API FOpListReplayer
+{
+public:
+	~FOpListReplayer();
+
+	bool Open(const FString& FilePath);
+
+	FORCEINLINE const FString& GetRecordedWorkerId() const { return RecordedWorkerId; }
+	FORCEINLINE bool IsFinished() const { return bFinished; }
+	FORCEINLINE uint32 GetNumOpListsReplayed() const { return NumOpListsReplayed; }
+	FORCEINLINE uint64 GetNumOpsReplayed() const { return NumOpsReplayed; }
+	FORCEINLINE double GetRecordedDuration() const { return LastRecordedTime; }
+
+	// Returns the next recorded op list, or nullptr once the recording is exhausted.
+	// The op list stays valid until ReleaseOpList or the next call to ReadNextOpList.
+	Worker_OpList* ReadNextOpList();
+	void ReleaseOpList();
+
+private:
+	bool ReadOp(Worker_Op& Op);
+	const char* ReadString();
+	Worker_EntityId ReadEntityId();
+	Worker_RequestId ReadRequestId();
+	bool ReadSchemaObject(Schema_Object* Object);
+	bool ReadComponentData(Worker_ComponentData& OutData);
+	bool ReadComponentUpdate(Worker_ComponentUpdate& OutUpdate);
+
+	TUniquePtr<FArchive> Reader;
+	FString RecordedWorkerId;
+	bool bFinished = false;
+
+	uint32 NumOpListsReplayed = 0;
+	uint64 NumOpsReplayed = 0;
+	double LastRecordedTime = 0.0;
+
+	// Storage backing the op list currently handed out.
+	Worker_OpList CurrentOpList = {};
+	TArray<Worker_Op> Ops;
+	TArray<TArray<ANSICHAR>> Strings;
+	TArray<TArray<const char*>> AttributeSets;
+	TArray<TArray<Worker_Entity>> QueryResults;
+	TArray<TArray<Worker_ComponentData>> QueryComponents;
+
+	TArray<Schema_ComponentData*> SchemaComponentDatas;
+	TArray<Schema_ComponentUpdate*> SchemaComponentUpdates;
+	TArray<Schema_CommandRequest*> SchemaCommandRequests;
+	TArray<Schema_CommandResponse*> SchemaCommandResponses;
+};
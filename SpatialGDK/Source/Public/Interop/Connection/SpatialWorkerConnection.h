@@ -1,7 +1,12 @@
 // Copyright (c) Improbable Worlds Ltd, All Rights Reserved
 #pragma once
 
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "Interop/Connection/ConnectionConfig.h"
+#include "Interop/Connection/OpListRecording.h"
 
 #include <WorkerSDK/improbable/c_schema.h>
 #include <WorkerSDK/improbable/c_worker.h>
@@ -10,11 +15,15 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogSpatialWorkerConnection, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("SpatialNet"), STATGROUP_SpatialNet, STATCAT_Advanced);
+
+class FRunnableThread;
+
 DECLARE_DELEGATE(FOnConnectedDelegate);
 DECLARE_DELEGATE_OneParam(FOnConnectFailedDelegate, const FString&);
 
 UCLASS()
-class SPATIALGDK_API USpatialWorkerConnection : public UObject
+class SPATIALGDK_API USpatialWorkerConnection : public UObject, public FRunnable
 {
 
 	GENERATED_BODY()
@@ -27,8 +36,23 @@ public:
 
 	FORCEINLINE bool IsConnected() { return bIsConnected; }
 
+	// True when op lists are drained by the ingest thread and must be read with DequeueOpLists instead of GetOpList.
+	FORCEINLINE bool IsUsingOpListThread() const { return OpListThread != nullptr; }
+
+	// Moves every op list queued by the ingest thread into OutOpLists, oldest first. The caller owns the op lists.
+	void DequeueOpLists(TArray<Worker_OpList*>& OutOpLists);
+
+	// Begin FRunnable interface, only used by the op list ingest thread.
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	// End FRunnable interface
+
+	// True when op lists come from a recording rather than a SpatialOS runtime. Outgoing messages are dropped.
+	FORCEINLINE bool IsReplayingOpLists() const { return OpListReplayer.IsValid(); }
+
 	// Worker Connection Interface
 	Worker_OpList* GetOpList();
+	void DestroyOpList(Worker_OpList* OpList);
 	Worker_RequestId SendReserveEntityIdRequest();
 	Worker_RequestId SendReserveEntityIdsRequest(uint32_t NumOfEntities);
 	Worker_RequestId SendCreateEntityRequest(uint32_t ComponentCount, const Worker_ComponentData* Components, const Worker_EntityId* EntityId);
@@ -56,8 +80,34 @@ private:
 
 	void GetAndPrintConnectionFailureMessage();
 
+	void OnConnectionSucceeded();
+
+	void StartOpListReplay();
+	Worker_OpList* GetReplayedOpList();
+
+	void StartOpListThread();
+	void StopOpListThread();
+
 	Worker_Connection* WorkerConnection;
 	Worker_Locator* WorkerLocator;
 
 	bool bIsConnected;
+
+	struct FQueuedOpList
+	{
+		Worker_OpList* OpList;
+		double EnqueueTime;
+	};
+
+	// Produced by the ingest thread, consumed by the game thread.
+	TQueue<FQueuedOpList, EQueueMode::Spsc> QueuedOpLists;
+	FThreadSafeCounter NumQueuedOpLists;
+
+	FRunnableThread* OpListThread;
+	FThreadSafeBool bOpListThreadRunning;
+
+	TUniquePtr<FOpListReplayer> OpListReplayer;
+	Worker_OpList EmptyReplayOpList;
+	Worker_RequestId NextReplayRequestId;
+	double ReplayStartTime;
 };
@@ -0,0 +1,78 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+
+#include "SpatialActorPool.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSpatialActorPool, Log, All);
+
+class USpatialNetDriver;
+
+UINTERFACE(MinimalAPI)
+class USpatialPoolableActor : public UInterface
+{
+	GENERATED_BODY()
+};
+
+// Implemented by actor classes that opt in to pooling. When an entity of such a class leaves a client's view, its actor is
+// deactivated and kept for the next entity of the same class instead of being destroyed. Pooled actors don't go through
+// EndPlay/BeginPlay again, so anything a fresh spawn wouldn't have needs to be reset in these hooks. Blueprints can implement
+// it too, so call the hooks through Execute_ rather than casting.
+class SPATIALGDK_API ISpatialPoolableActor
+{
+	GENERATED_BODY()
+
+public:
+	// Called before the actor is hidden and put back into the pool.
+	UFUNCTION(BlueprintNativeEvent, Category = "SpatialOS")
+	void OnReturnedToPool();
+	virtual void OnReturnedToPool_Implementation() {}
+
+	// Called when the actor is handed out for a new entity, before its initial component data is applied.
+	UFUNCTION(BlueprintNativeEvent, Category = "SpatialOS")
+	void OnTakenFromPool();
+	virtual void OnTakenFromPool_Implementation() {}
+};
+
+// Per-class pools of inactive actors the receiver draws from when checking out entities, enabled with -actorPooling.
+// Only used on clients: servers would start replicating inactive actors they have authority over.
+UCLASS()
+class SPATIALGDK_API USpatialActorPool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// Also pre-spawns the classes listed in -actorPoolPrewarm=<ClassPath>:<Count>,...
+	void Init(USpatialNetDriver* InNetDriver);
+
+	bool IsPoolable(const AActor* Actor) const;
+
+	// Returns an inactive actor of exactly ActorClass moved to Transform, or nullptr if there is none.
+	AActor* AcquireActor(UClass* ActorClass, const FTransform& Transform);
+
+	// Deactivates the actor and keeps it for later. Returns false if the class's pool is full, the actor should be destroyed then.
+	bool ReleaseActor(AActor* Actor);
+
+	void Prewarm(UClass* ActorClass, int32 Count);
+
+	// Hides the actor and turns off its collision and ticking, or restores them to the class defaults.
+	static void SetActorActive(AActor* Actor, bool bActive);
+
+private:
+	bool IsPoolableClass(const UClass* ActorClass) const;
+
+	UPROPERTY()
+	USpatialNetDriver* NetDriver;
+
+	UPROPERTY()
+	UWorld* World;
+
+	// Pooled actors stay in the level, which keeps them alive. Weak pointers in case the level goes away first.
+	TMap<const UClass*, TArray<TWeakObjectPtr<AActor>>> InactiveActors;
+
+	bool bEnabled;
+	int32 MaxActorsPerClass;
+};
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 
+#include "Interop/Connection/OpListRecording.h"
+#include "Interop/SpatialOpStats.h"
 #include "Schema/Component.h"
 #include "Schema/StandardLibrary.h"
 #include "Schema/UnrealMetadata.h"
@@ -27,7 +29,27 @@ class SPATIALGDK_API USpatialDispatcher : public UObject
 
 public:
 	void Init(USpatialNetDriver* NetDriver);
-	void ProcessOps(Worker_OpList* OpList);
+	// Destroys the op lists still queued without processing them, called when the net driver shuts down.
+	void Shutdown();
+
+	// Takes ownership of OpList. It is destroyed through the worker connection once all of its ops have been processed.
+	void QueueOpList(Worker_OpList* OpList);
+
+	// Processes queued ops until the per-tick budget (-opProcessingBudgetMs, unlimited by default) runs out.
+	// Critical sections are never split, but spawning the actors they check out can be spread over several ticks. Until
+	// an entity's actor is spawned, the view doesn't see the entity, and no later ops are processed.
+	// Whatever is left over is processed first on the next call.
+	void ProcessOps();
+
+	// True if ops from a previous tick are still waiting to be processed.
+	bool HasPendingOps() const;
+
+	// Records every op list passed to QueueOpList into FilePath until StopRecording is called.
+	bool StartRecording(const FString& FilePath);
+	void StopRecording();
+	FORCEINLINE bool IsRecording() const { return OpListRecorder.IsRecording(); }
+
+	FORCEINLINE FSpatialOpStats& GetOpStats() { return OpStats; }
 
 private:
 	UPROPERTY()
@@ -38,4 +60,38 @@ private:
 
 	UPROPERTY()
 	USpatialStaticComponentView* StaticComponentView;
+
+	void ProcessOp(Worker_Op* Op);
+	// Continues applying the Receiver's critical section, followed by the component updates received inside it.
+	bool ApplyCriticalSection(uint64 DeadlineCycles);
+	void QueueComponentUpdate(Worker_Op* Op, uint64 OpStartCycles);
+	void ApplyQueuedComponentUpdates();
+	void UpdateBacklogStats();
+
+	FOpListRecorder OpListRecorder;
+	FSpatialOpStats OpStats;
+
+	// Op lists that haven't been fully processed yet, oldest first. NextOpIndex indexes into the first one.
+	TArray<Worker_OpList*> PendingOpLists;
+	TArray<double> PendingOpListQueueTimes;
+	uint32 NextOpIndex;
+	bool bInCriticalSection;
+
+	struct FQueuedComponentUpdate
+	{
+		Worker_ComponentUpdateOp Op;
+		// Set once other updates have been merged into it, Op.update.schema_type is then a copy owned by the dispatcher.
+		bool bOwnsUpdate;
+		uint64 Cycles;
+	};
+
+	// Component updates are queued until the next op of another type, or until the critical section they are in has been
+	// applied, so a run of updates to the same entity component can be coalesced into one.
+	TArray<FQueuedComponentUpdate> QueuedComponentUpdates;
+	// Per entity, the index of the queued update that later updates of its component are merged into. Closed by an
+	// update of another component of the entity, and for all entities by an op of another type.
+	TMap<Worker_EntityId_Key, int32> OpenComponentUpdates;
+
+	float OpProcessingBudgetMs;
+	uint32 NumTicksOverBudget;
 };
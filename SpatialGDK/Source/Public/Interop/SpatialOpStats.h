@@ -0,0 +1,74 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <WorkerSDK/improbable/c_worker.h>
+
+class FOutputDevice;
+
+// Log-scale latency histogram, each power of two microseconds is split into four buckets.
+// Percentiles are therefore accurate to within ~20%, which is enough to tell spikes from steady-state cost.
+struct FSpatialLatencyHistogram
+{
+	static const int32 BUCKETS_PER_OCTAVE = 4;
+	static const int32 NUM_BUCKETS = 30 * BUCKETS_PER_OCTAVE;
+
+	void Add(double Microseconds);
+	double GetPercentile(float Percentile) const;
+	void Reset();
+
+	uint32 Buckets[NUM_BUCKETS] = {};
+	uint64 NumSamples = 0;
+};
+
+struct FSpatialOpTimingStats
+{
+	void Add(double Seconds);
+	void Reset();
+
+	uint64 Count = 0;
+	double TotalSeconds = 0.0;
+	double MaxSeconds = 0.0;
+	FSpatialLatencyHistogram Histogram;
+};
+
+// Per-op-type timing for USpatialDispatcher::ProcessOps, with component updates also broken down per component.
+// Dumped by the SPATIALOPSTATS console command.
+class SPATIALGDK_API FSpatialOpStats
+{
+public:
+	// Worker_OpType values are small and contiguous, leave room for new ones.
+	static const int32 MAX_OP_TYPES = 32;
+
+	void RecordOp(uint8 OpType, double Seconds);
+	void RecordComponentUpdate(Worker_ComponentId ComponentId, double Seconds);
+	void RecordWorkerMetrics(const Worker_Metrics& Metrics);
+	void RecordBacklog(uint32 NumPendingOps, int32 NumPendingSpawns, double OldestBacklogAge, uint32 NumTicksOverBudget);
+
+	FORCEINLINE void SetProcessingBudgetMs(float InProcessingBudgetMs) { ProcessingBudgetMs = InProcessingBudgetMs; }
+
+	void Dump(FOutputDevice& Ar) const;
+	void Reset();
+
+	static const TCHAR* GetOpTypeName(uint8 OpType);
+
+private:
+	FSpatialOpTimingStats OpTypeStats[MAX_OP_TYPES];
+	TMap<Worker_ComponentId, FSpatialOpTimingStats> ComponentUpdateStats;
+
+	// Latest values reported by the Worker SDK in WORKER_OP_TYPE_METRICS ops.
+	TMap<FString, double> WorkerGaugeMetrics;
+	double WorkerLoad = -1.0;
+
+	// Op processing backlog left over at the end of ProcessOps, see -opProcessingBudgetMs.
+	float ProcessingBudgetMs = 0.0f;
+	uint32 MaxPendingOps = 0;
+	int32 MaxPendingSpawns = 0;
+	double MaxBacklogAge = 0.0;
+	uint32 TicksOverBudgetAtReset = 0;
+	uint32 TicksOverBudget = 0;
+
+	double StartTime = FPlatformTime::Seconds();
+};
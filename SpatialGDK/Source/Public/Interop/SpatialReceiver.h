@@ -10,6 +10,7 @@
 #include "Interop/SpatialTypebindingManager.h"
 #include "Schema/StandardLibrary.h"
 #include "Schema/Rotation.h"
+#include "Utils/ComponentDecoder.h"
 #include "UObject/improbable/UnrealObjectRef.h"
 
 #include <WorkerSDK/improbable/c_schema.h>
@@ -21,12 +22,15 @@ DECLARE_LOG_CATEGORY_EXTERN(LogSpatialReceiver, Log, All);
 
 class USpatialSender;
 class UGlobalStateManager;
+class USpatialActorPool;
 
 using FChannelObjectPair = TPair<TWeakObjectPtr<USpatialActorChannel>, TWeakObjectPtr<UObject>>;
 using FUnresolvedObjectsMap = TMap<Schema_FieldId, TSet<const UObject*>>;
 struct FObjectReferences;
 using FObjectReferencesMap = TMap<int32, FObjectReferences>;
-using FReliableRPCMap = TMap<Worker_RequestId, TSharedRef<struct FPendingRPCParams>>;
+// The reliable RPCs sent in one command request, more than one if they were batched.
+using FReliableRPCBatch = TArray<TSharedRef<struct FPendingRPCParams>>;
+using FReliableRPCMap = TMap<Worker_RequestId, FReliableRPCBatch>;
 
 struct PendingAddComponentWrapper
 {
@@ -37,6 +41,34 @@ struct PendingAddComponentWrapper
 	Worker_EntityId EntityId;
 	Worker_ComponentId ComponentId;
 	TSharedPtr<improbable::Component> Data;
+
+	// Set when the component is part of a checkout large enough to be decoded by FSpatialComponentDecoder.
+	TSharedPtr<FDecodedComponentData> DecodedData;
+};
+
+// Components added during a critical section, grouped per entity so spawning an entity's actor only looks at its own components.
+// The per-entity arrays are kept and reused by the next critical section.
+class FPendingAddComponentBuffer
+{
+public:
+	void Add(Worker_EntityId EntityId, Worker_ComponentId ComponentId, const TSharedPtr<improbable::Component>& Data);
+	const TArray<PendingAddComponentWrapper>* Find(Worker_EntityId EntityId) const;
+	TArray<PendingAddComponentWrapper>* Find(Worker_EntityId EntityId);
+	void Reset();
+
+	FORCEINLINE int32 Num() const { return NumComponents; }
+
+#if !UE_BUILD_SHIPPING
+	// Times adding and looking up NumComponentsPerEntity components for checkouts of up to NumEntities entities,
+	// against the flat array the receiver used to scan.
+	static void RunBenchmark(int32 NumEntities, int32 NumComponentsPerEntity, FOutputDevice& Ar);
+#endif
+
+private:
+	TMap<Worker_EntityId_Key, int32> EntityIndices;
+	TArray<TArray<PendingAddComponentWrapper>> ComponentLists;
+	int32 NumUsedLists = 0;
+	int32 NumComponents = 0;
 };
 
 struct FObjectReferences
@@ -79,18 +111,68 @@ struct FObjectReferences
 
 struct FPendingIncomingRPC
 {
-	FPendingIncomingRPC(const TSet<FUnrealObjectRef>& InUnresolvedRefs, UObject* InTargetObject, UFunction* InFunction, const TArray<uint8>& InPayloadData, int64 InCountBits)
-		: UnresolvedRefs(InUnresolvedRefs), TargetObject(InTargetObject), Function(InFunction), PayloadData(InPayloadData), CountBits(InCountBits) {}
+	FPendingIncomingRPC(const TSet<FUnrealObjectRef>& InUnresolvedRefs, UObject* InTargetObject, UFunction* InFunction, FSchemaPayloadView InPayloadData, int64 InCountBits, Worker_EntityId InEntityId)
+		: UnresolvedRefs(InUnresolvedRefs), TargetObject(InTargetObject), Function(InFunction), PayloadData(InPayloadData.GetData(), InPayloadData.Num()), CountBits(InCountBits), EntityId(InEntityId)
+		, QueuedTime(FPlatformTime::Seconds()), bReliable(InFunction->HasAnyFunctionFlags(FUNC_NetReliable)) {}
 
 	TSet<FUnrealObjectRef> UnresolvedRefs;
 	TWeakObjectPtr<UObject> TargetObject;
 	UFunction* Function;
 	TArray<uint8> PayloadData;
 	int64 CountBits;
+	Worker_EntityId EntityId;
+	double QueuedTime;
+	bool bReliable;
 };
 
 using FIncomingRPCArray = TArray<TSharedPtr<FPendingIncomingRPC>>;
 
+// The RPCs waiting on unresolved refs for one target object, in the order they arrived.
+struct FIncomingRPCQueue
+{
+	FIncomingRPCArray RPCs;
+	int32 NumBytes = 0;
+};
+
+// The unresolved properties of one replicated object.
+struct FPendingIncomingProperties
+{
+	FObjectReferencesMap ObjectReferencesMap;
+
+	// Refs this object is listed under in USpatialReceiver::IncomingRefDependents.
+	TArray<FUnrealObjectRef> RegisteredRefs;
+
+	Worker_EntityId EntityId = SpatialConstants::INVALID_ENTITY_ID;
+	bool bTrackedByEntity = false;
+};
+
+// Everything waiting on one unresolved object ref. A node lives as long as something depends on the ref.
+struct FIncomingRefDependents
+{
+	bool IsEmpty() const { return Properties.Num() == 0 && RPCs.Num() == 0; }
+
+	// For each dependent object, the top-level offsets in its FObjectReferencesMap that reference the ref.
+	TMap<FChannelObjectPair, TArray<int32, TInlineAllocator<2>>> Properties;
+	FIncomingRPCArray RPCs;
+};
+
+// Pending incoming operations per entity, so they can be dropped when the entity goes away.
+struct FPendingEntityOperations
+{
+	bool IsEmpty() const { return Objects.Num() == 0 && RPCs.Num() == 0; }
+
+	TArray<FChannelObjectPair> Objects;
+	FIncomingRPCArray RPCs;
+};
+
+// Ops of an entity held back while its critical section is applied. They point into the critical section's op list,
+// which the dispatcher keeps alive until the section has been applied.
+struct FPendingEntityOps
+{
+	TArray<Worker_AddComponentOp> AddComponents;
+	TArray<Worker_AuthorityChangeOp> AuthorityChanges;
+};
+
 DECLARE_DELEGATE_OneParam(EntityQueryDelegate, Worker_EntityQueryResponseOp&);
 DECLARE_DELEGATE_OneParam(ReserveEntityIDsDelegate, Worker_ReserveEntityIdsResponseOp&);
 
@@ -101,6 +183,8 @@ class USpatialReceiver : public UObject
 
 public:
 	void Init(USpatialNetDriver* NetDriver, FTimerManager* InTimerManager);
+	// Stops the receiver's timers and waits for component decoding, called when the net driver shuts down.
+	void Shutdown();
 
 	// Dispatcher Calls
 	void OnCriticalSection(bool InCriticalSection);
@@ -117,8 +201,20 @@ public:
 	void OnReserveEntityIdsResponse(Worker_ReserveEntityIdsResponseOp& Op);
 	void OnCreateEntityResponse(Worker_CreateEntityResponseOp& Op);
 
+	// Leaving a critical section checks out its actors, authority changes and removals. Spawning the actors can be spread
+	// over several calls: each call spawns at least one actor and stops once DeadlineCycles has passed.
+	// Returns true once everything from the critical section has been applied.
+	bool ApplyCriticalSection(uint64 DeadlineCycles = MAX_uint64);
+	FORCEINLINE bool IsApplyingCriticalSection() const { return bApplyingCriticalSection; }
+	FORCEINLINE int32 GetNumPendingSpawns() const { return bApplyingCriticalSection ? PendingAddEntities.Num() - NextPendingAddEntityIndex : 0; }
+
 	void AddPendingActorRequest(Worker_RequestId RequestId, USpatialActorChannel* Channel);
 	void AddPendingReliableRPC(Worker_RequestId RequestId, TSharedRef<struct FPendingRPCParams> Params);
+	void AddPendingReliableRPCs(Worker_RequestId RequestId, FReliableRPCBatch&& ReliableRPCs);
+
+	// Applies an RPC the sender short-circuited because this worker is authoritative over its component. Unlike RPCs
+	// received from the runtime, it runs straight away inside the caller's stack, before the RPC call returns.
+	void ApplyLocalRPC(UObject* TargetObject, UFunction* Function, FSchemaPayloadView PayloadData);
 
 	void AddEntityQueryDelegate(Worker_RequestId RequestId, EntityQueryDelegate Delegate);
 	void AddReserveEntityIdsDelegate(Worker_RequestId RequestId, ReserveEntityIDsDelegate Delegate);
@@ -129,35 +225,77 @@ public:
 
 	void ResolvePendingOperations(UObject* Object, const FUnrealObjectRef& ObjectRef);
 
+	// Publishes the size of the unresolved reference graph to the SpatialNet stat group.
+	void UpdateUnresolvedRefStats();
+
 private:
 	void EnterCriticalSection();
 	void LeaveCriticalSection();
+	void DispatchComponentDecode();
 
 	void ReceiveActor(Worker_EntityId EntityId);
 	void RemoveActor(Worker_EntityId EntityId);
+	void DestroyActor(AActor* Actor, Worker_EntityId EntityId);
 	AActor* CreateActor(improbable::Position* Position, struct improbable::Rotation* Rotation, UClass* ActorClass, bool bDeferred);
 
 	void HandleActorAuthority(Worker_AuthorityChangeOp& Op);
 
-	void ApplyComponentData(Worker_EntityId EntityId, Worker_ComponentData& Data, USpatialActorChannel* Channel);
+	// Applies the ops of EntityId held back during the critical section, checking out its actor if it was added in it.
+	void ApplyPendingEntityOps(Worker_EntityId EntityId, FPendingEntityOps& EntityOps, bool bCheckOutActor);
+
+	void ApplyComponentData(Worker_EntityId EntityId, Worker_ComponentData& Data, USpatialActorChannel* Channel, const FDecodedComponentData* DecodedData = nullptr);
 	void ApplyComponentUpdate(const Worker_ComponentUpdate& ComponentUpdate, UObject* TargetObject, USpatialActorChannel* Channel, bool bIsHandover);
 
-	void ReceiveRPCCommandRequest(const Worker_CommandRequest& CommandRequest, UObject* TargetObject, UFunction* Function);
+	void ReceiveRPCCommandRequest(const Worker_CommandRequest& CommandRequest, UObject* TargetObject, UFunction* Function, const TArray<UFunction*>& RPCArray);
 	void ReceiveMulticastUpdate(const Worker_ComponentUpdate& ComponentUpdate, UObject* TargetObject, const TArray<UFunction*>& RPCArray);
-	void ApplyRPC(UObject* TargetObject, UFunction* Function, TArray<uint8>& PayloadData, int64 CountBits);
+	// PayloadData is only copied if the RPC has to wait for unresolved refs.
+	void ReceiveRingBufferUpdate(Worker_EntityId EntityId, const Worker_ComponentUpdate& ComponentUpdate, UObject* TargetObject, const FClassInfo& Info, ESchemaComponentType Category);
+	void ApplyCheckedOutRingBufferRPCs(Worker_EntityId EntityId, const TArray<PendingAddComponentWrapper>& EntityComponents);
+	void ApplyRingBufferRPCs(Worker_EntityId EntityId, Schema_Object* FieldsObject, UObject* TargetObject, const FClassInfo& Info, ESchemaComponentType Category);
+	bool IsRingBufferRPCComponent(Worker_ComponentId ComponentId);
+	void ApplyRPC(UObject* TargetObject, UFunction* Function, FSchemaPayloadView PayloadData, int64 CountBits);
 
 	void ReceiveCommandResponse(Worker_CommandResponseOp& Op);
 
-	void QueueIncomingRepUpdates(FChannelObjectPair ChannelObjectPair, const FObjectReferencesMap& ObjectReferencesMap, const TSet<FUnrealObjectRef>& UnresolvedRefs);
-	void QueueIncomingRPC(const TSet<FUnrealObjectRef>& UnresolvedRefs, UObject* TargetObject, UFunction* Function, const TArray<uint8>& PayloadData, int64 CountBits);
+	FPendingIncomingProperties& FindOrAddPendingIncomingProperties(const FChannelObjectPair& ChannelObjectPair, Worker_EntityId EntityId);
+	void QueueIncomingRepUpdates(const FChannelObjectPair& ChannelObjectPair, FPendingIncomingProperties& PendingProperties, const TSet<FUnrealObjectRef>& UnresolvedRefs);
+	void QueueIncomingRPC(const TSet<FUnrealObjectRef>& UnresolvedRefs, UObject* TargetObject, UFunction* Function, FSchemaPayloadView PayloadData, int64 CountBits);
+
+	void RegisterIncomingProperties(const FChannelObjectPair& ChannelObjectPair, FPendingIncomingProperties& PendingProperties);
+	void UnregisterIncomingProperties(const FChannelObjectPair& ChannelObjectPair, FPendingIncomingProperties& PendingProperties);
+	void RemovePendingIncomingProperties(const FChannelObjectPair& ChannelObjectPair);
+	void RemovePendingIncomingRPC(const TSharedPtr<FPendingIncomingRPC>& IncomingRPC);
+	void RemoveRefDependentsIfEmpty(const FUnrealObjectRef& ObjectRef);
+	void PurgePendingIncomingOperations(Worker_EntityId EntityId);
+
+	// Drops queued RPCs of TargetObject until one more of NumBytes fits. Unreliable RPCs go first, and a new unreliable RPC
+	// is dropped rather than a queued reliable one. Returns false if the new RPC should be dropped.
+	bool MakeRoomForIncomingRPC(UObject* TargetObject, bool bReliable, int32 NumBytes);
+	// Drops RPCs queued for longer than -incomingRPCTimeToLive and publishes the age of the oldest one left, runs on a timer.
+	void ExpireIncomingRPCs();
+	// Counts a queued RPC as delivered and records how long it waited. Called before it is removed from its queue.
+	void TrackQueuedRPCDelivery(const FPendingIncomingRPC& IncomingRPC);
 
 	void ResolvePendingOperations_Internal(UObject* Object, const FUnrealObjectRef& ObjectRef);
 	void ResolveIncomingOperations(UObject* Object, const FUnrealObjectRef& ObjectRef);
 	void ResolveIncomingRPCs(UObject* Object, const FUnrealObjectRef& ObjectRef);
 	void ResolveObjectReferences(FRepLayout& RepLayout, UObject* ReplicatedObject, FObjectReferencesMap& ObjectReferencesMap, uint8* RESTRICT StoredData, uint8* RESTRICT Data, int32 MaxAbsOffset, TArray<UProperty*>& RepNotifies, bool& bOutSomeObjectsWereMapped, bool& bOutStillHasUnresolved);
 
+	// Resolves what it can of a single entry of an FObjectReferencesMap. Returns true once the entry has no unresolved refs left.
+	bool ResolveObjectReference(FRepLayout& RepLayout, UObject* ReplicatedObject, int32 AbsOffset, FObjectReferences& ObjectReferences, uint8* RESTRICT StoredData, uint8* RESTRICT Data, TArray<UProperty*>& RepNotifies, bool& bOutSomeObjectsWereMapped, bool& bOutStillHasUnresolved);
+
 	void ProcessQueuedResolvedObjects();
 
+	// Removal cache: on clients, actors of entities that leave the view are kept hidden for -removalCacheWindow seconds
+	// together with their channel, so an entity bouncing on the edge of the interest radius doesn't get respawned.
+	// The channel's shadow state is what makes the re-applied initial data only notify the properties that changed.
+	// While dormant, the actor is out of the entity registry and package map, so references to its entity stay unresolved.
+	void MakeActorDormant(AActor* Actor, Worker_EntityId EntityId);
+	bool ReviveDormantActor(Worker_EntityId EntityId, improbable::Position* Position, improbable::Rotation* Rotation);
+	void ReleaseDormantActor(Worker_EntityId EntityId);
+	void ReleaseExpiredDormantActors();
+	void UpdateRemovalCacheStats() const;
+
 	USpatialActorChannel* PopPendingActorRequest(Worker_RequestId RequestId);
 
 private:
@@ -185,21 +323,57 @@ private:
 	UPROPERTY()
 	UGlobalStateManager* GlobalStateManager;
 
+	UPROPERTY()
+	USpatialActorPool* ActorPool;
+
 	FTimerManager* TimerManager;
 
-	// TODO: Figure out how to remove entries when Channel/Actor gets deleted - UNR:100
-	TMap<FUnrealObjectRef, TSet<FChannelObjectPair>> IncomingRefsMap;
-	TMap<FChannelObjectPair, FObjectReferencesMap> UnresolvedRefsMap;
+	// Dependency graph of incoming operations waiting on unresolved refs, indexed both ways: by the ref they wait on,
+	// and by the entity they belong to. Entries of an entity are purged in CleanupDeletedEntity.
+	TMap<FUnrealObjectRef, FIncomingRefDependents> IncomingRefDependents;
+	TMap<FChannelObjectPair, FPendingIncomingProperties> UnresolvedRefsMap;
+	TMap<Worker_EntityId_Key, FPendingEntityOperations> PendingOperationsByEntity;
 	TArray<TPair<UObject*, FUnrealObjectRef>> ResolvedObjectQueue;
-
-	TMap<FUnrealObjectRef, FIncomingRPCArray> IncomingRPCMap;
+	int32 NumPendingIncomingRPCs;
+	double LastRefGraphMemoryStatTime;
 
 	bool bInCriticalSection;
+	bool bApplyingCriticalSection;
+	int32 NextPendingAddEntityIndex;
 	TArray<Worker_EntityId> PendingAddEntities;
-	TArray<Worker_AuthorityChangeOp> PendingAuthorityChanges;
-	TArray<PendingAddComponentWrapper> PendingAddComponents;
+	// The view is only given an entity's components and authority when its actor is checked out, so game code never
+	// sees an entity of a critical section that is still being spawned.
+	TMap<Worker_EntityId_Key, FPendingEntityOps> PendingEntityOps;
+	FPendingAddComponentBuffer PendingAddComponents;
+	// Declared after PendingAddComponents, so it is destroyed first and waits for the tasks decoding into them.
+	FSpatialComponentDecoder ComponentDecoder;
 	TArray<Worker_EntityId> PendingRemoveEntities;
 
+	struct FDormantActor
+	{
+		TWeakObjectPtr<AActor> Actor;
+		double RemovalTime;
+	};
+
+	TMap<Worker_EntityId_Key, FDormantActor> DormantActors;
+	bool bRemovalCacheEnabled;
+	float RemovalCacheWindowSeconds;
+	int32 RemovalCacheMaxEntities;
+	uint32 NumRemovalCacheHits;
+	uint32 NumRemovalCacheMisses;
+	FTimerHandle RemovalCacheTimerHandle;
+
+	TMap<TWeakObjectPtr<UObject>, FIncomingRPCQueue> IncomingRPCQueues;
+	float IncomingRPCTimeToLive;
+	int32 MaxQueuedRPCsPerObject;
+	int32 MaxQueuedRPCBytesPerObject;
+	// Payload bytes of all queued RPCs, kept up to date as RPCs are queued and removed.
+	int32 QueuedIncomingRPCBytes;
+	FTimerHandle IncomingRPCExpiryTimerHandle;
+	double TotalQueuedRPCLatency;
+	double MaxQueuedRPCLatency;
+	uint32 NumDeliveredQueuedRPCs;
+
 	TMap<Worker_RequestId, USpatialActorChannel*> PendingActorRequests;
 	FReliableRPCMap PendingReliableRPCs;
 
@@ -0,0 +1,80 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "UObject/NoExportTypes.h"
+
+#include "SpatialConstants.h"
+
+#include <WorkerSDK/improbable/c_worker.h>
+
+#include "SpatialRetryScheduler.generated.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSpatialRetryScheduler, Log, All);
+
+class FTimerManager;
+class USpatialNetDriver;
+
+// Runs every command retry off one timing wheel instead of a timer per retry, so a burst of failures doesn't come back
+// as a burst of retries. Delays get random jitter and a per-target backoff, and no more than -retryBudgetPerSecond
+// retries are sent per second; the rest are pushed back a tick at a time.
+UCLASS()
+class SPATIALGDK_API USpatialRetryScheduler : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	void Init(USpatialNetDriver* InNetDriver, FTimerManager* InTimerManager);
+	// Stops the wheel and drops the retries still on it, called when the net driver shuts down.
+	void Shutdown();
+
+	// Calls Retry after roughly Delay seconds. If Target is a valid entity, the delay is at least the backoff earned by
+	// its recent failures, so different commands to the same struggling worker back off together.
+	void ScheduleRetry(Worker_EntityId Target, float Delay, TFunction<void()>&& Retry);
+
+	// Grows the backoff of Target after a command to it failed.
+	void ReportFailure(Worker_EntityId Target);
+	// Clears the backoff of Target after a command to it succeeded.
+	void ReportSuccess(Worker_EntityId Target);
+
+	FORCEINLINE int32 GetNumInFlight() const { return NumInFlight; }
+
+private:
+	struct FScheduledRetry
+	{
+		TFunction<void()> Retry;
+		// Full turns of the wheel left before the retry is due.
+		int32 Rounds;
+	};
+
+	struct FTargetBackoff
+	{
+		uint32 NumFailures = 0;
+		double LastFailureTime = 0.0;
+	};
+
+	float GetTargetBackoff(Worker_EntityId Target) const;
+
+	void Tick();
+	void AdvanceSlot();
+	void PruneTargetBackoffs();
+
+	UPROPERTY()
+	USpatialNetDriver* NetDriver;
+
+	FTimerManager* TimerManager;
+	FTimerHandle TickTimerHandle;
+
+	TArray<TArray<FScheduledRetry>> Slots;
+	int32 CurrentSlot;
+	double NextTickTime;
+	int32 NumInFlight;
+
+	TMap<Worker_EntityId_Key, FTargetBackoff> TargetBackoffs;
+
+	float Jitter;
+	float BudgetPerSecond;
+	float BudgetTokens;
+};
@@ -6,6 +6,7 @@
 
 #include "SpatialTypebindingManager.h"
 #include "Utils/RepDataUtils.h"
+#include "Utils/RPCParamsPool.h"
 
 #include <WorkerSDK/improbable/c_schema.h>
 #include <WorkerSDK/improbable/c_worker.h>
@@ -25,13 +26,71 @@ class USpatialWorkerConnection;
 
 struct FPendingRPCParams
 {
-	FPendingRPCParams(UObject* InTargetObject, UFunction* InFunction, void* InParameters);
+	FPendingRPCParams(UObject* InTargetObject, UFunction* InFunction, void* InParameters, const TSharedRef<FRPCParamsPool>& InPool);
 	~FPendingRPCParams();
 
+	FPendingRPCParams(const FPendingRPCParams&) = delete;
+	FPendingRPCParams& operator=(const FPendingRPCParams&) = delete;
+
 	TWeakObjectPtr<UObject> TargetObject;
 	UFunction* Function;
-	TArray<uint8> Parameters;
+	// Function->ParmsSize bytes from Pool, handed back when the RPC is done with.
+	uint8* Parameters;
 	int Attempts; // For reliable RPCs
+
+private:
+	TSharedRef<FRPCParamsPool> Pool;
+};
+
+// RPCs to one entity's RPC component, sent together as a single command request with -batchRPCs. Each entity has at most
+// one open batch: an RPC to another of its RPC components sends the open batch first, so call order is kept per entity.
+struct FOutgoingRPCBatch
+{
+	struct FBatchedRPC
+	{
+		FBatchedRPC(Schema_FieldId InCommandIndex, TArray<uint8>&& InPayload, TSharedRef<FPendingRPCParams> InParams)
+			: CommandIndex(InCommandIndex), Payload(MoveTemp(InPayload)), Params(InParams) {}
+
+		Schema_FieldId CommandIndex;
+		TArray<uint8> Payload;
+		TSharedRef<FPendingRPCParams> Params;
+	};
+
+	Worker_EntityId EntityId;
+	Worker_ComponentId ComponentId;
+	// In the order the RPCs were called.
+	TArray<FBatchedRPC> RPCs;
+};
+
+struct FRingBufferedRPC
+{
+	uint64 RPCId;
+	Schema_FieldId CommandIndex;
+	TArray<uint8> Payload;
+};
+
+// A command request carrying RPCs, until its response comes back or, if it failed, until its reliable RPCs are resent.
+struct FInFlightRPCRequest
+{
+	Worker_EntityId EntityId;
+	Worker_ComponentId ComponentId;
+	int32 NumRPCs;
+};
+
+// What we write into one RPC component we are authoritative over: the RPCs we sent through it, and the ack for the RPCs
+// we applied from the ring buffer of the component for the other direction. For ring components another worker writes,
+// only the ids, so we can carry on from there if we are given authority over them.
+struct FRPCRingBuffer
+{
+	uint64 LastSentRPCId = 0;
+	// Sent but not acknowledged yet, at most RPC_RING_BUFFER_CAPACITY of them. Resent with every update until acked.
+	TArray<FRingBufferedRPC> UnackedRPCs;
+	// Reliable RPCs waiting for acks to free up room in the ring.
+	TArray<FRingBufferedRPC> OverflowRPCs;
+	uint64 LastAppliedIncomingRPCId = 0;
+	// The rpcs list and last_acked_rpc_id to write with the next flush.
+	bool bDirty = false;
+	bool bAckDirty = false;
 };
 
 // TODO: Clear TMap entries when USpatialActorChannel gets deleted - UNR:100
@@ -50,35 +109,72 @@ class SPATIALGDK_API USpatialSender : public UObject
 
 public:
 	void Init(USpatialNetDriver* InNetDriver);
+	// Sends the component updates still queued, or frees them if we are no longer connected.
+	void Shutdown();
 
 	// Actor Updates
-	void SendComponentUpdates(UObject* Object, FClassInfo* Info, USpatialActorChannel* Channel, const FRepChangeState* RepChanges, const FHandoverChangeState* HandoverChanges);
+	// Returns the number of bytes written into the updates.
+	uint32 SendComponentUpdates(UObject* Object, FClassInfo* Info, USpatialActorChannel* Channel, const FRepChangeState* RepChanges, const FHandoverChangeState* HandoverChanges);
 	void SendComponentInterest(AActor* Actor, Worker_EntityId EntityId);
-	void SendPositionUpdate(Worker_EntityId EntityId, const FVector& Location);
-	void SendRotationUpdate(Worker_EntityId EntityId, const FRotator& Rotation);
+	// Like SendComponentUpdates, these return the number of bytes written so they count against the replication budget.
+	uint32 SendPositionUpdate(Worker_EntityId EntityId, const FVector& Location);
+	uint32 SendRotationUpdate(Worker_EntityId EntityId, const FRotator& Rotation, bool bQuantize = false);
+	// Sends the component updates queued up since the last flush, called from TickFlush.
+	void FlushComponentUpdates();
 	void SendRPC(TSharedRef<FPendingRPCParams> Params);
+	TSharedRef<FPendingRPCParams> CreateRPCParams(UObject* TargetObject, UFunction* Function, void* Parameters);
+	// Sends the command RPCs batched up since the last flush, called from TickFlush.
+	void FlushRPCBatches();
+
+	// Ring buffer transport, see ERPCTransport::RingBuffer. ComponentId is always the RPC component we are authoritative over.
+	void FlushRingBufferRPCs();
+	uint64 GetLastAppliedRingBufferRPCId(Worker_EntityId EntityId, Worker_ComponentId ComponentId) const;
+	void AckRingBufferRPCs(Worker_EntityId EntityId, Worker_ComponentId ComponentId, uint64 LastAppliedRPCId);
+	void OnRingBufferRPCsAcked(Worker_EntityId EntityId, Worker_ComponentId ComponentId, uint64 LastAckedRPCId);
+	// Records the ids in a ring component written by another worker.
+	void MirrorRingBuffer(Worker_EntityId EntityId, Worker_ComponentId ComponentId, Schema_Object* Fields);
+	// IncomingComponentId is the ring buffer whose RPCs we now ack.
+	void OnRingBufferAuthorityGained(Worker_EntityId EntityId, Worker_ComponentId ComponentId, Worker_ComponentId IncomingComponentId);
+	void RemoveRingBuffers(Worker_EntityId EntityId);
 	void SendCommandResponse(Worker_RequestId request_id, Worker_CommandResponse& Response);
 
 	void SendReserveEntityIdRequest(USpatialActorChannel* Channel);
-	void SendCreateEntityRequest(USpatialActorChannel* Channel);
+	// Returns the number of bytes of component data in the request.
+	uint32 SendCreateEntityRequest(USpatialActorChannel* Channel);
 	void SendDeleteEntityRequest(Worker_EntityId EntityId);
 
 	void ResolveOutgoingOperations(UObject* Object, bool bIsHandover);
 	void ResolveOutgoingRPCs(UObject* Object);
 
+	// NumRetried of the request's RPCs are resent once their retry is due, which OnRPCRetryDue has to be called for first.
+	void OnRPCCommandResponse(Worker_RequestId RequestId, int32 NumRetried);
+	void OnRPCRetryDue(Worker_RequestId RequestId);
+
 	bool UpdateEntityACLs(AActor* Actor, Worker_EntityId EntityId);
 private:
 	// Actor Lifecycle
-	Worker_RequestId CreateEntity(USpatialActorChannel* Channel);
+	Worker_RequestId CreateEntity(USpatialActorChannel* Channel, uint32& OutBytesWritten);
 
 	// Queuing
 	void ResetOutgoingUpdate(USpatialActorChannel* DependentChannel, UObject* ReplicatedObject, int16 Handle, bool bIsHandover);
 	void QueueOutgoingUpdate(USpatialActorChannel* DependentChannel, UObject* ReplicatedObject, int16 Handle, const TSet<const UObject*>& UnresolvedObjects, bool bIsHandover);
 	void QueueOutgoingRPC(const UObject* UnresolvedObject, TSharedRef<FPendingRPCParams> Params);
 
+	// Takes ownership of the update. With -coalesceComponentUpdates (on by default) it's held until FlushComponentUpdates,
+	// merged with any later update to the same component of the same entity.
+	void QueueComponentUpdate(Worker_EntityId EntityId, Worker_ComponentUpdate& Update);
+
 	// RPC Construction
 	Worker_CommandRequest CreateRPCCommandRequest(UObject* TargetObject, UFunction* Function, void* Parameters, Worker_ComponentId ComponentId, Schema_FieldId CommandIndex, Worker_EntityId& OutEntityId, const UObject*& OutUnresolvedObject);
+	bool SerializeRPCPayload(UObject* TargetObject, UFunction* Function, void* Parameters, TArray<uint8>& OutPayload, Worker_EntityId& OutEntityId, const UObject*& OutUnresolvedObject);
+	void AddRPCToBatch(UObject* TargetObject, TSharedRef<FPendingRPCParams> Params, Worker_ComponentId ComponentId, Schema_FieldId CommandIndex, const UObject*& OutUnresolvedObject);
+	void SendRPCBatch(const FOutgoingRPCBatch& Batch);
+	// Returns false if we aren't authoritative over the ring buffer component, the RPC should be sent as a command then.
+	bool SendRingBufferRPC(UObject* TargetObject, TSharedRef<FPendingRPCParams> Params, Worker_ComponentId RingBufferComponentId, Schema_FieldId CommandIndex, const UObject*& OutUnresolvedObject);
 	Worker_ComponentUpdate CreateMulticastUpdate(UObject* TargetObject, UFunction* Function, void* Parameters, Worker_ComponentId ComponentId, Schema_FieldId EventIndex, Worker_EntityId& OutEntityId, const UObject*& OutUnresolvedObject);
+	// True if earlier RPCs of RPCType to the entity are still batched, waiting for a command response or retry, or in a ring buffer.
+	bool HasQueuedRPCs(Worker_EntityId EntityId, const FClassInfo& Info, ESchemaComponentType RPCType) const;
+	void AddInFlightRPCs(Worker_EntityId EntityId, Worker_ComponentId ComponentId, int32 NumRPCs);
 
 	TArray<Worker_InterestOverride> CreateComponentInterest(AActor* Actor);
 	FString GetOwnerWorkerAttribute(AActor* Actor);
@@ -109,6 +205,26 @@ private:
 	FOutgoingRepUpdates HandoverObjectToUnresolved;
 
 	FOutgoingRPCMap OutgoingRPCs;
+	// The unresolved object the latest RPC queued for each target waits on. Later command RPCs to the target are queued
+	// behind it, so they don't overtake it.
+	TMap<TWeakObjectPtr<UObject>, const UObject*> OutgoingRPCBlockers;
+
+	// Command RPCs per entity RPC component from when they are batched or sent until they are done with, see FInFlightRPCRequest.
+	TMap<TPair<Worker_EntityId_Key, Worker_ComponentId>, int32> NumInFlightRPCs;
+	TMap<Worker_RequestId, FInFlightRPCRequest> InFlightRPCRequests;
+
+	// Shared with every FPendingRPCParams created from it, so it outlives the ones still queued when we go away.
+	TSharedPtr<FRPCParamsPool> RPCParamsPool;
+
+	bool bCoalesceComponentUpdates;
+	// In the order each component was first updated this frame.
+	TArray<TPair<Worker_EntityId, Worker_ComponentUpdate>> QueuedComponentUpdates;
+	TMap<TPair<Worker_EntityId_Key, Worker_ComponentId>, int32> QueuedComponentUpdateIndices;
+
+	bool bBatchRPCs;
+	TMap<Worker_EntityId_Key, FOutgoingRPCBatch> OutgoingRPCBatches;
+
+	TMap<Worker_EntityId_Key, TMap<Worker_ComponentId, FRPCRingBuffer>> RPCRingBuffers;
 
 	TMap<Worker_RequestId, USpatialActorChannel*> PendingActorRequests;
 };
@@ -8,12 +8,128 @@
 #include "Schema/StandardLibrary.h"
 #include "Schema/UnrealMetadata.h"
 #include "SpatialConstants.h"
+#include "Utils/SpatialPositionIndex.h"
 
 #include <WorkerSDK/improbable/c_schema.h>
 #include <WorkerSDK/improbable/c_worker.h>
 
 #include "SpatialStaticComponentView.generated.h"
 
+class FSpatialViewCache;
+
+// Components whose data is kept by USpatialStaticComponentView. Each one is stored in its own dense array,
+// and their authority is packed into two bits per slot.
+enum EStaticComponentSlot : int32
+{
+	STATIC_Invalid = -1,
+	STATIC_EntityAcl,
+	STATIC_Metadata,
+	STATIC_Position,
+	STATIC_Persistence,
+	STATIC_Rotation,
+	STATIC_Singleton,
+	STATIC_UnrealMetadata,
+	STATIC_Count
+};
+
+constexpr EStaticComponentSlot GetStaticComponentSlot(Worker_ComponentId ComponentId)
+{
+	switch (ComponentId)
+	{
+	case SpatialConstants::ENTITY_ACL_COMPONENT_ID:
+		return STATIC_EntityAcl;
+	case SpatialConstants::METADATA_COMPONENT_ID:
+		return STATIC_Metadata;
+	case SpatialConstants::POSITION_COMPONENT_ID:
+		return STATIC_Position;
+	case SpatialConstants::PERSISTENCE_COMPONENT_ID:
+		return STATIC_Persistence;
+	case SpatialConstants::ROTATION_COMPONENT_ID:
+		return STATIC_Rotation;
+	case SpatialConstants::SINGLETON_COMPONENT_ID:
+		return STATIC_Singleton;
+	case SpatialConstants::UNREAL_METADATA_COMPONENT_ID:
+		return STATIC_UnrealMetadata;
+	default:
+		return STATIC_Invalid;
+	}
+}
+
+class FStaticComponentStoreBase
+{
+public:
+	virtual ~FStaticComponentStoreBase() {}
+
+	// Removes the component at Index by moving the last one into its place.
+	// Returns the entity record index of the moved component, or INDEX_NONE if nothing moved.
+	virtual int32 RemoveAtSwap(int32 Index) = 0;
+	virtual void SetEntityIndex(int32 Index, int32 EntityIndex) = 0;
+	virtual int32 Num() const = 0;
+	virtual SIZE_T GetAllocatedSize() const = 0;
+};
+
+template <typename T>
+class TStaticComponentStore : public FStaticComponentStoreBase
+{
+public:
+	FORCEINLINE T& Get(int32 Index) { return Components[Index]; }
+
+	int32 Add(T&& Component, int32 EntityIndex)
+	{
+		EntityIndices.Add(EntityIndex);
+		return Components.Add(MoveTemp(Component));
+	}
+
+	int32 RemoveAtSwap(int32 Index) override
+	{
+		const int32 LastIndex = Components.Num() - 1;
+		Components.RemoveAtSwap(Index, 1, false);
+		EntityIndices.RemoveAtSwap(Index, 1, false);
+		return Index != LastIndex ? EntityIndices[Index] : INDEX_NONE;
+	}
+
+	void SetEntityIndex(int32 Index, int32 EntityIndex) override { EntityIndices[Index] = EntityIndex; }
+	int32 Num() const override { return Components.Num(); }
+	SIZE_T GetAllocatedSize() const override { return Components.GetAllocatedSize() + EntityIndices.GetAllocatedSize(); }
+
+private:
+	TArray<T> Components;
+	TArray<int32> EntityIndices;
+};
+
+struct FStaticEntityRecord
+{
+	explicit FStaticEntityRecord(Worker_EntityId InEntityId)
+		: EntityId(InEntityId)
+		, StaticAuthority(0)
+	{
+		for (int32& ComponentIndex : ComponentIndices)
+		{
+			ComponentIndex = INDEX_NONE;
+		}
+	}
+
+	FORCEINLINE Worker_Authority GetStaticAuthority(EStaticComponentSlot Slot) const
+	{
+		return (Worker_Authority)((StaticAuthority >> (Slot * 2)) & 0x3);
+	}
+
+	FORCEINLINE void SetStaticAuthority(EStaticComponentSlot Slot, Worker_Authority Authority)
+	{
+		StaticAuthority = (StaticAuthority & ~(0x3u << (Slot * 2))) | ((uint32(Authority) & 0x3) << (Slot * 2));
+	}
+
+	Worker_EntityId EntityId;
+
+	// Index into the dense store of each static component, INDEX_NONE if the entity doesn't have it.
+	int32 ComponentIndices[STATIC_Count];
+
+	uint32 StaticAuthority;
+
+	// Authority over every other component, usually only a handful per entity.
+	TArray<TPair<Worker_ComponentId, Worker_Authority>, TInlineAllocator<4>> OtherAuthority;
+};
+
 UCLASS()
 class SPATIALGDK_API USpatialStaticComponentView : public UObject
 {
@@ -23,26 +139,84 @@ public:
 	Worker_Authority GetAuthority(Worker_EntityId EntityId, Worker_ComponentId ComponentId);
 	bool HasAuthority(Worker_EntityId EntityId, Worker_ComponentId ComponentId);
 
+	// The pointer is into a dense store: any component of the same type being added or removed can move the data,
+	// so don't hold on to it across ops or anything that can run game code. Use CopyComponentData for that.
 	template <typename T>
 	T* GetComponentData(Worker_EntityId EntityId)
 	{
-		if (TMap<Worker_ComponentId, TUniquePtr<improbable::ComponentStorageBase>>* ComponentStorageMap = EntityComponentMap.Find(EntityId))
+		constexpr EStaticComponentSlot Slot = GetStaticComponentSlot(T::ComponentId);
+		static_assert(Slot != STATIC_Invalid, "Only the static components are kept by USpatialStaticComponentView.");
+
+		if (const int32* EntityIndex = EntityIndexMap.Find(EntityId))
 		{
-			if (TUniquePtr<improbable::ComponentStorageBase>* Component = ComponentStorageMap->Find(T::ComponentId))
+			const int32 ComponentIndex = EntityRecords[*EntityIndex].ComponentIndices[Slot];
+			if (ComponentIndex != INDEX_NONE)
 			{
-				return &(static_cast<improbable::ComponentStorage<T>*>(Component->Get())->Get());
+				return &static_cast<TStaticComponentStore<T>*>(ComponentStores[Slot].Get())->Get(ComponentIndex);
 			}
 		}
 
 		return nullptr;
 	}
 
+	template <typename T>
+	bool CopyComponentData(Worker_EntityId EntityId, T& OutData)
+	{
+		if (T* Data = GetComponentData<T>(EntityId))
+		{
+			OutData = *Data;
+			return true;
+		}
+
+		return false;
+	}
+
 	void OnAddComponent(const Worker_AddComponentOp& Op);
 	void OnRemoveEntity(const Worker_RemoveEntityOp& Op);
 	void OnComponentUpdate(const Worker_ComponentUpdateOp& Op);
 	void OnAuthorityChange(const Worker_AuthorityChangeOp& Op);
 
+	void GetEntityIds(TArray<Worker_EntityId>& OutEntityIds) const;
+
+	// While set, every static component added to the view is checked against the warm-start cache.
+	FORCEINLINE void SetWarmStartCache(FSpatialViewCache* InWarmStartCache) { WarmStartCache = InWarmStartCache; }
+
+	// Spatial queries over the Position component of every checked-out entity, in SpatialOS coordinates.
+	void GetEntitiesInRadius(const improbable::Coordinates& Center, double Radius, TArray<Worker_EntityId>& OutEntityIds) const;
+	void GetEntitiesInBox(const improbable::Coordinates& Min, const improbable::Coordinates& Max, TArray<Worker_EntityId>& OutEntityIds) const;
+
+	// Same as above, in Unreal world space (centimeters).
+	void GetEntitiesInRadius(const FVector& Center, float Radius, TArray<Worker_EntityId>& OutEntityIds) const;
+
+	// Rebuilds the position index with a new cell size in SpatialOS units. Defaults to 50, or -positionIndexCellSize.
+	void SetPositionIndexCellSize(double CellSize);
+
+	// Publishes the memory used by each of the view's containers to the SpatialNet stat group.
+	void UpdateMemoryStats() const;
+	SIZE_T GetAllocatedSize() const;
+
+#if !UE_BUILD_SHIPPING
+	// Compares GetComponentData and HasAuthority against the nested TMap layout this view used to have.
+	static void RunLookupBenchmark(int32 NumEntities, int32 NumIterations, FOutputDevice& Ar);
+
+	// Drives NumCycles entity add/remove cycles through a fresh view and logs its memory use along the way.
+	static void RunChurnSoak(int32 NumCycles, int32 NumLiveEntities, FOutputDevice& Ar);
+#endif
+
 private:
-	TMap<Worker_EntityId_Key, TMap<Worker_ComponentId, Worker_Authority>> EntityComponentAuthorityMap;
-	TMap<Worker_EntityId_Key, TMap<Worker_ComponentId, TUniquePtr<improbable::ComponentStorageBase>>> EntityComponentMap;
+	template <typename T>
+	void AddComponent(Worker_EntityId EntityId, const Worker_ComponentData& Data);
+
+	int32 FindOrAddEntityRecord(Worker_EntityId EntityId);
+	void RemoveEntityRecord(int32 EntityIndex);
+
+	// Entity records are kept dense as well, EntityIndexMap is the only hash lookup on the read path.
+	TMap<Worker_EntityId_Key, int32> EntityIndexMap;
+	TArray<FStaticEntityRecord> EntityRecords;
+
+	TUniquePtr<FStaticComponentStoreBase> ComponentStores[STATIC_Count];
+
+	FSpatialPositionIndex PositionIndex;
+
+	FSpatialViewCache* WarmStartCache = nullptr;
 };
@@ -29,6 +29,23 @@ FORCEINLINE ESchemaComponentType GetGroupFromCondition(ELifetimeCondition Condit
 	}
 }
 
+// How RPCs of one type are sent, selected per RPC type with -ringBufferRPCs=Client,Server. This only affects sending:
+// ring buffer data is applied whatever the receiving worker's own flag says, so workers don't need to agree on it.
+enum class ERPCTransport : uint8
+{
+	// An entity command per RPC, or per batch with -batchRPCs.
+	Command,
+	// Sequence-numbered entries in the ring buffer of the RPC component for the other direction, acknowledged by the receiver.
+	RingBuffer,
+};
+
+// Client RPCs are written into the server RPC component, which the server is authoritative over, and the other way around.
+FORCEINLINE ESchemaComponentType GetRingBufferComponentType(ESchemaComponentType RPCType)
+{
+	check(RPCType == SCHEMA_ClientRPC || RPCType == SCHEMA_ServerRPC);
+	return RPCType == SCHEMA_ClientRPC ? SCHEMA_ServerRPC : SCHEMA_ClientRPC;
+}
+
 struct FRPCInfo
 {
 	ESchemaComponentType Type;
@@ -57,6 +74,10 @@ struct FClassInfo
 
 	Worker_ComponentId SchemaComponents[ESchemaComponentType::SCHEMA_Count] = {};
 
+	ERPCTransport RPCTransports[ESchemaComponentType::SCHEMA_Count] = {};
+	// Both the client and server RPC components exist, so either side may write RPCs or acks into them.
+	bool bHasRPCRingBuffers = false;
+
 	FName SubobjectName;
 
 	TMap<uint32, TSharedPtr<FClassInfo>> SubobjectInfo;
@@ -88,6 +109,7 @@ public:
 private:
 	void FindSupportedClasses();
 	void CreateTypebindings();
+	void SelectRPCTransports(FClassInfo& Info) const;
 
 private:
 	UPROPERTY()
@@ -105,4 +127,6 @@ private:
 	TMap<Worker_ComponentId, UClass*> ComponentToClassMap;
 	TMap<Worker_ComponentId, uint32> ComponentToOffsetMap;
 	TMap<Worker_ComponentId, ESchemaComponentType> ComponentToCategoryMap;
+
+	bool bRingBufferRPCTypes[ESchemaComponentType::SCHEMA_Count];
 };
@@ -0,0 +1,59 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Interop/SpatialStaticComponentView.h"
+
+#include <WorkerSDK/improbable/c_schema.h>
+#include <WorkerSDK/improbable/c_worker.h>
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSpatialViewCache, Log, All);
+
+class UEntityRegistry;
+class USpatialTypebindingManager;
+
+// On-disk snapshot of USpatialStaticComponentView plus the entity ids the UEntityRegistry had actors for,
+// used to warm up a restarting worker. Components are stored in their serialized schema form.
+// While a loaded cache is attached to the view, incoming AddComponent ops are compared against it.
+class SPATIALGDK_API FSpatialViewCache
+{
+public:
+	static bool Save(const FString& FilePath, const FString& MapName, USpatialStaticComponentView* View, UEntityRegistry* EntityRegistry);
+
+	// Save split in two: serializing the view has to happen on the game thread, writing the result out doesn't.
+	static TArray<uint8> Snapshot(const FString& MapName, USpatialStaticComponentView* View, UEntityRegistry* EntityRegistry);
+	static bool WriteToFile(const FString& FilePath, const TArray<uint8>& SnapshotBytes);
+
+	bool Load(const FString& FilePath, const FString& MapName);
+
+	// Loads and resolves the actor classes of every cached entity, so their class info is ready before the checkout arrives.
+	void PrewarmClasses(USpatialTypebindingManager* TypebindingManager);
+
+	// Compares a freshly received static component against the cached one.
+	void ValidateAddComponent(const Worker_AddComponentOp& Op);
+
+	// Logs how well the cache matched what has been received so far.
+	void LogValidationSummary() const;
+
+	FORCEINLINE int32 Num() const { return CachedEntities.Num(); }
+
+private:
+	struct FCachedEntity
+	{
+		TArray<uint8> ComponentBytes[STATIC_Count];
+		uint8 ComponentMask = 0;
+		uint8 ValidatedMask = 0;
+		bool bHadActor = false;
+	};
+
+	TMap<Worker_EntityId_Key, FCachedEntity> CachedEntities;
+	FString CacheFilePath;
+
+	uint32 NumMatched = 0;
+	uint32 NumChanged = 0;
+	uint32 NumUncached = 0;
+
+	TArray<uint8> ScratchBuffer;
+};
@@ -28,6 +28,12 @@ struct Rotation : Component
 	{
 		Schema_Object* ComponentObject = Schema_GetComponentDataFields(Data.schema_type);
 
+		if (Schema_GetUint64Count(ComponentObject, 4) == 1)
+		{
+			Dequantize(Schema_GetUint64(ComponentObject, 4));
+			return;
+		}
+
 		Pitch = Schema_GetFloat(ComponentObject, 1);
 		Yaw = Schema_GetFloat(ComponentObject, 2);
 		Roll = Schema_GetFloat(ComponentObject, 3);
@@ -63,12 +69,39 @@ struct Rotation : Component
 		Schema_AddFloat(ComponentObject, 2, Yaw);
 		Schema_AddFloat(ComponentObject, 3, Roll);
 
+		// The quantized field takes precedence, so drop any left over from an earlier quantized update.
+		Schema_AddComponentUpdateClearedField(ComponentUpdate.schema_type, 4);
+
+		return ComponentUpdate;
+	}
+
+	// Sets the quantized field, and the floats to the same rounded values so readers of either agree.
+	Worker_ComponentUpdate CreateQuantizedRotationUpdate()
+	{
+		Worker_ComponentUpdate ComponentUpdate = {};
+		ComponentUpdate.component_id = ComponentId;
+		ComponentUpdate.schema_type = Schema_CreateComponentUpdate(ComponentId);
+		Schema_Object* ComponentObject = Schema_GetComponentUpdateFields(ComponentUpdate.schema_type);
+
+		const uint64 Quantized = Quantize();
+		Dequantize(Quantized);
+
+		Schema_AddFloat(ComponentObject, 1, Pitch);
+		Schema_AddFloat(ComponentObject, 2, Yaw);
+		Schema_AddFloat(ComponentObject, 3, Roll);
+		Schema_AddUint64(ComponentObject, 4, Quantized);
+
 		return ComponentUpdate;
 	}
 
 	void ApplyComponentUpdate(const Worker_ComponentUpdate& Update)
 	{
 		Schema_Object* ComponentObject = Schema_GetComponentUpdateFields(Update.schema_type);
+		if (Schema_GetUint64Count(ComponentObject, 4) == 1)
+		{
+			Dequantize(Schema_GetUint64(ComponentObject, 4));
+			return;
+		}
 		if (Schema_GetFloatCount(ComponentObject, 1) == 1)
 		{
 			Pitch = Schema_GetFloat(ComponentObject, 1);
@@ -83,6 +116,20 @@ struct Rotation : Component
 		}
 	}
 
+	uint64 Quantize() const
+	{
+		return uint64(FRotator::CompressAxisToShort(Pitch))
+			| (uint64(FRotator::CompressAxisToShort(Yaw)) << 16)
+			| (uint64(FRotator::CompressAxisToShort(Roll)) << 32);
+	}
+
+	void Dequantize(uint64 Quantized)
+	{
+		Pitch = FRotator::DecompressAxisFromShort(uint16(Quantized));
+		Yaw = FRotator::DecompressAxisFromShort(uint16(Quantized >> 16));
+		Roll = FRotator::DecompressAxisFromShort(uint16(Quantized >> 32));
+	}
+
 	float Pitch;
 	float Yaw;
 	float Roll;
@@ -65,6 +65,17 @@ namespace SpatialConstants
 	const Schema_FieldId GLOBAL_STATE_MANAGER_MAP_URL_ID			= 1;
 	const Schema_FieldId GLOBAL_STATE_MANAGER_ACCEPTING_PLAYERS_ID	= 2;
 
+	const Schema_FieldId UNREAL_RPC_PAYLOAD_ID						= 1;
+	const Schema_FieldId UNREAL_RPC_BATCHED_RPCS_ID					= 2;
+	const Schema_FieldId UNREAL_BATCHED_RPC_COMMAND_INDEX_ID		= 1;
+	const Schema_FieldId UNREAL_BATCHED_RPC_PAYLOAD_ID				= 2;
+
+	const Schema_FieldId UNREAL_RPC_RING_BUFFER_RPCS_ID				= 1;
+	const Schema_FieldId UNREAL_RPC_RING_BUFFER_LAST_ACKED_ID		= 2;
+	const Schema_FieldId UNREAL_RING_BUFFERED_RPC_ID_ID				= 1;
+	const Schema_FieldId UNREAL_RING_BUFFERED_RPC_COMMAND_INDEX_ID	= 2;
+	const Schema_FieldId UNREAL_RING_BUFFERED_RPC_PAYLOAD_ID		= 3;
+
 	const float FIRST_COMMAND_RETRY_WAIT_SECONDS = 0.2f;
 	const float REPLICATED_STABLY_NAMED_ACTORS_DELETION_TIMEOUT_SECONDS = 5.0f;
 	const uint32 MAX_NUMBER_COMMAND_ATTEMPTS = 5u;
@@ -89,4 +100,58 @@ namespace SpatialConstants
 	const uint16 DEFAULT_PORT = 7777;
 
 	const float ENTITY_QUERY_RETRY_WAIT_SECONDS = 3.0f;
+
+	// How long a loaded view cache is kept around to validate the initial checkout against, and how often it's rewritten by default.
+	const float VIEW_CACHE_VALIDATION_WINDOW_SECONDS = 30.0f;
+	const float VIEW_CACHE_DEFAULT_SAVE_INTERVAL_SECONDS = 60.0f;
+
+	// Owner changes are picked up when a channel replicates or receives an update. Every channel is also checked this often,
+	// which catches owner changes on dormant actors and actors that rarely replicate.
+	const float OWNERSHIP_SWEEP_INTERVAL_SECONDS = 1.0f;
+
+	// Default cap on inactive actors USpatialActorPool keeps per class, overridden with -actorPoolMaxPerClass.
+	const int32 ACTOR_POOL_DEFAULT_MAX_ACTORS_PER_CLASS = 64;
+
+	// Default cap on actors the receiver keeps dormant after their entity leaves the view, overridden with -removalCacheMaxEntities.
+	const int32 REMOVAL_CACHE_DEFAULT_MAX_ENTITIES = 256;
+
+	// Checkouts of at least this many entities have their component data decoded on task graph threads, in chunks of this many entities.
+	const int32 COMPONENT_DECODE_MIN_BATCH_ENTITIES = 64;
+	const int32 COMPONENT_DECODE_ENTITIES_PER_TASK = 32;
+
+	// Limits on incoming RPCs waiting on unresolved refs, overridden with -incomingRPCTimeToLive, -maxQueuedRPCsPerObject and -maxQueuedRPCBytesPerObject.
+	const float INCOMING_RPC_DEFAULT_TIME_TO_LIVE_SECONDS = 30.0f;
+	const int32 INCOMING_RPC_DEFAULT_MAX_QUEUED_PER_OBJECT = 64;
+	const int32 INCOMING_RPC_DEFAULT_MAX_QUEUED_BYTES_PER_OBJECT = 64 * 1024;
+	const float INCOMING_RPC_EXPIRY_CHECK_INTERVAL_SECONDS = 1.0f;
+	// Sizing the unresolved ref graph for its memory stat walks all of it, so it is done at most this often.
+	const float UNRESOLVED_REF_GRAPH_MEMORY_STAT_INTERVAL_SECONDS = 1.0f;
+
+	// Timing wheel of USpatialRetryScheduler: tick length and number of slots, so delays up to 12.8s need a single pass.
+	const float RETRY_SCHEDULER_TICK_SECONDS = 0.05f;
+	const int32 RETRY_SCHEDULER_NUM_SLOTS = 256;
+	// Defaults for -retryJitter (fraction of the delay added or removed at random) and -retryBudgetPerSecond (0 is unlimited).
+	const float RETRY_SCHEDULER_DEFAULT_JITTER = 0.25f;
+	const float RETRY_SCHEDULER_DEFAULT_BUDGET_PER_SECOND = 200.0f;
+	// A target's backoff starts over once it has gone this long without a failure.
+	const float RETRY_SCHEDULER_TARGET_BACKOFF_RESET_SECONDS = 30.0f;
+
+	// With -batchRPCs, a batch of RPCs to one entity's RPC component is sent early once it holds this many RPCs.
+	const int32 RPC_BATCH_MAX_RPCS = 32;
+
+	// Number of unacknowledged RPCs a ring buffer holds. Further reliable RPCs wait for acks, unreliable ones are dropped.
+	const int32 RPC_RING_BUFFER_CAPACITY = 32;
+
+	// Parameter buffers FRPCParamsPool keeps per RPC function for reuse, any more are freed when released.
+	const int32 RPC_PARAMS_POOL_MAX_FREE_BUFFERS_PER_FUNCTION = 16;
+
+	// Default for -replicationBytesPerTick, the bytes of component updates a server replicates per tick (0 is unlimited).
+	const int32 REPLICATION_DEFAULT_BYTES_PER_TICK = 0;
+
+	// Defaults of FSpatialTransformReplicationSettings, for classes without an entry in the replication settings asset.
+	const float POSITION_UPDATE_DEFAULT_THRESHOLD_CM = 100.0f;
+	const float ROTATION_UPDATE_DEFAULT_THRESHOLD_RADIANS = 0.1f;
+
+	// How long the op list ingest thread blocks in Worker_Connection_GetOpList before checking whether it should stop.
+	const uint32 OP_LIST_THREAD_GET_OP_LIST_TIMEOUT_MILLIS = 10u;
 }
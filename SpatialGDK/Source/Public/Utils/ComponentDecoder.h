@@ -0,0 +1,103 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+
+#include "SpatialConstants.h"
+#include "UObject/improbable/UnrealObjectRef.h"
+
+#include <WorkerSDK/improbable/c_schema.h>
+#include <WorkerSDK/improbable/c_worker.h>
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSpatialComponentDecoder, Log, All);
+
+class USpatialNetDriver;
+class USpatialTypebindingManager;
+class UProperty;
+
+// Values of one schema field, in the form ComponentReader would read them out of the Schema_Object.
+struct FDecodedSchemaField
+{
+	Schema_FieldId FieldId = 0;
+
+	// Bools, integers, floats and doubles, each copied into the low bytes of a uint64.
+	TArray<uint64> Scalars;
+	// Names, strings and texts.
+	TArray<FString> Strings;
+	// Serialized structs, still to be read with an FSpatialNetBitReader.
+	TArray<TArray<uint8>> Payloads;
+	TArray<FUnrealObjectRef> ObjectRefs;
+
+	FORCEINLINE uint32 Num() const { return Scalars.Num() + Strings.Num() + Payloads.Num() + ObjectRefs.Num(); }
+};
+
+// The fields of a Worker_ComponentData decoded off the game thread, sorted by field id.
+// Nothing in here touches UObjects: object refs are resolved when the data is applied.
+struct FDecodedComponentData
+{
+	TArray<FDecodedSchemaField> Fields;
+
+	const FDecodedSchemaField* FindField(Schema_FieldId FieldId) const;
+};
+
+namespace improbable
+{
+
+// FieldProperties[FieldId - 1] is the property a field is read into. Safe to call from any thread.
+void DecodeSchemaObject(Schema_Object* Object, const TArray<UProperty*>& FieldProperties, FDecodedComponentData& OutDecodedData);
+
+}
+
+// Decodes the initial component data of a batch of checked-out entities on task graph worker threads, so the game thread
+// only has to copy the values into the spawned actors. Entities are decoded in chunks, in the order they were added.
+class FSpatialComponentDecoder
+{
+public:
+	// Waits for the decode tasks still running, they write into data owned by whoever added the components.
+	~FSpatialComponentDecoder();
+
+	void Init(USpatialNetDriver* InNetDriver);
+
+	// Game thread only. Returns false if the component has no replicated fields to decode, in which case OutDecodedData is left alone.
+	// The component data and OutDecodedData have to stay alive until the entity has been waited for.
+	bool Add(Worker_EntityId EntityId, const Worker_ComponentData& Data, FDecodedComponentData& OutDecodedData);
+
+	// Starts decoding everything added since the last dispatch.
+	void Dispatch();
+
+	// Blocks until the components of EntityId have been decoded.
+	void WaitForEntity(Worker_EntityId EntityId);
+	void WaitForAll();
+
+	FORCEINLINE bool IsEnabled() const { return bEnabled; }
+
+private:
+	struct FDecodeJob
+	{
+		Schema_Object* Object;
+		const TArray<UProperty*>* FieldProperties;
+		FDecodedComponentData* DecodedData;
+	};
+
+	void DispatchPendingJobs();
+
+	const TArray<UProperty*>* FindOrAddFieldProperties(Worker_ComponentId ComponentId);
+
+	USpatialNetDriver* NetDriver = nullptr;
+	USpatialTypebindingManager* TypebindingManager = nullptr;
+	bool bEnabled = false;
+
+	// Per component id, the property each field is read into. Built on the game thread, only read by the decode tasks.
+	// The arrays are heap allocated so the pointers held by in-flight jobs survive the map growing.
+	TMap<Worker_ComponentId, TUniquePtr<TArray<UProperty*>>> FieldPropertiesCache;
+
+	TArray<FDecodeJob> PendingJobs;
+	int32 NumPendingEntities = 0;
+	Worker_EntityId LastAddedEntityId = SpatialConstants::INVALID_ENTITY_ID;
+
+	TArray<FGraphEventRef> ChunkEvents;
+	int32 NumCompletedChunks = 0;
+	TMap<Worker_EntityId_Key, int32> EntityChunks;
+};
@@ -33,6 +33,9 @@ public:
 
 	static Worker_ComponentData CreateEmptyComponentData(Worker_ComponentId ComponentId);
 
+	// Serialized size of the fields of every update created so far, what the replication budget is charged.
+	FORCEINLINE uint32 GetBytesWritten() const { return BytesWritten; }
+
 private:
 	Worker_ComponentData CreateComponentData(Worker_ComponentId ComponentId, UObject* Object, const FRepChangeState& Changes, ESchemaComponentType PropertyGroup);
 	Worker_ComponentUpdate CreateComponentUpdate(Worker_ComponentId ComponentId, UObject* Object, const FRepChangeState& Changes, ESchemaComponentType PropertyGroup, bool& bWroteSomething);
@@ -52,6 +55,8 @@ private:
 
 	FUnresolvedObjectsMap& PendingRepUnresolvedObjectsMap;
 	FUnresolvedObjectsMap& PendingHandoverUnresolvedObjectsMap;
+
+	uint32 BytesWritten;
 };
 
 }
@@ -0,0 +1,35 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UFunction;
+
+// Per-function free lists of the buffers FPendingRPCParams copies RPC parameters into, so high-frequency RPCs don't
+// hit the allocator on every call. Functions whose parameters are all plain old data are copied with a memcpy instead
+// of being initialized, copied and destroyed property by property. Game thread only.
+class SPATIALGDK_API FRPCParamsPool
+{
+public:
+	~FRPCParamsPool();
+
+	// Returns a buffer of Function->ParmsSize bytes holding a copy of the parameters in InParameters.
+	uint8* Acquire(UFunction* Function, void* InParameters);
+
+	// Destroys the parameters in Buffer and keeps it for the next call of the same function.
+	void Release(UFunction* Function, uint8* Buffer);
+
+private:
+	struct FFunctionPool
+	{
+		TArray<uint8*> FreeBuffers;
+		int32 BufferSize = 0;
+		bool bIsPlainOldData = false;
+	};
+
+	FFunctionPool& FindOrAddFunctionPool(UFunction* Function);
+
+	// Weak keys, so a function reloaded at the same address gets a new pool instead of buffers sized for the old one.
+	TMap<TWeakObjectPtr<UFunction>, FFunctionPool> FunctionPools;
+};
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "Containers/ArrayView.h"
 #include "EngineClasses/SpatialNetBitWriter.h"
 #include "UObject/improbable/UnrealObjectRef.h"
 
@@ -13,6 +14,9 @@ using WorkerRequirementSet = TArray<WorkerAttributeSet>;
 
 using StringToEntityMap = TMap<FString, Worker_EntityId>;
 
+// A bytes field read in place. It points into the schema data it was read from and is only valid as long as that is.
+using FSchemaPayloadView = TArrayView<const uint8>;
+
 namespace improbable
 {
 
@@ -44,6 +48,13 @@ inline void AddPayloadToSchema(Schema_Object* Object, Schema_FieldId Id, FSpatia
 	Schema_AddBytes(Object, Id, PayloadBuffer, sizeof(char) * PayloadSize);
 }
 
+inline void AddPayloadToSchema(Schema_Object* Object, Schema_FieldId Id, FSchemaPayloadView Payload)
+{
+	uint8* PayloadBuffer = Schema_AllocateBuffer(Object, sizeof(char) * Payload.Num());
+	FMemory::Memcpy(PayloadBuffer, Payload.GetData(), sizeof(char) * Payload.Num());
+	Schema_AddBytes(Object, Id, PayloadBuffer, sizeof(char) * Payload.Num());
+}
+
 inline TArray<uint8> IndexPayloadFromSchema(const Schema_Object* Object, Schema_FieldId Id, uint32 Index)
 {
 	int32 PayloadSize = (int32)Schema_IndexBytesLength(Object, Id, Index);
@@ -55,6 +66,16 @@ inline TArray<uint8> GetPayloadFromSchema(const Schema_Object* Object, Schema_Fi
 	return IndexPayloadFromSchema(Object, Id, 0);
 }
 
+inline FSchemaPayloadView IndexPayloadViewFromSchema(const Schema_Object* Object, Schema_FieldId Id, uint32 Index)
+{
+	return FSchemaPayloadView((const uint8*)Schema_IndexBytes(Object, Id, Index), (int32)Schema_IndexBytesLength(Object, Id, Index));
+}
+
+inline FSchemaPayloadView GetPayloadViewFromSchema(const Schema_Object* Object, Schema_FieldId Id)
+{
+	return IndexPayloadViewFromSchema(Object, Id, 0);
+}
+
 inline void AddWorkerRequirementSetToSchema(Schema_Object* Object, Schema_FieldId Id, const WorkerRequirementSet& Value)
 {
 	Schema_Object* RequirementSetObject = Schema_AddObject(Object, Id);
@@ -183,6 +204,10 @@ inline Schema_ComponentData* DeepCopyComponentData(Schema_ComponentData* Source)
 	return Copy;
 }
 
+// Merges Update into Target as if Update had been applied after it: fields set or cleared in Update replace the
+// ones in Target and Update's events are appended after Target's. Update itself is left untouched.
+void MergeComponentUpdate(Schema_ComponentUpdate* Target, Schema_ComponentUpdate* Update);
+
 // Generates the full path from an ObjectRef, if it has paths. Writes the result to OutPath.
 // Does not clear OutPath first.
 void GetFullPathFromUnrealObjectReference(const FUnrealObjectRef& ObjectRef, FString& OutPath);
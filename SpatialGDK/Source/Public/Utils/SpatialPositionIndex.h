@@ -0,0 +1,51 @@
+// Copyright (c) Improbable Worlds Ltd, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Schema/StandardLibrary.h"
+#include "SpatialConstants.h"
+
+#include <WorkerSDK/improbable/c_worker.h>
+
+// Uniform grid over the X/Z plane of SpatialOS coordinates, used to find checked-out entities near a point
+// without scanning every entity. Cells are columns, Y is only checked against the query bounds.
+class SPATIALGDK_API FSpatialPositionIndex
+{
+public:
+	explicit FSpatialPositionIndex(double InCellSize = 50.0);
+
+	void AddOrUpdate(Worker_EntityId EntityId, const improbable::Coordinates& Coords);
+	void Remove(Worker_EntityId EntityId);
+	void Reset();
+
+	// Appends every indexed entity within Radius of Center (inclusive) to OutEntityIds, in no particular order.
+	void QueryRadius(const improbable::Coordinates& Center, double Radius, TArray<Worker_EntityId>& OutEntityIds) const;
+
+	// Appends every indexed entity inside the axis-aligned box [Min, Max] to OutEntityIds, in no particular order.
+	void QueryBox(const improbable::Coordinates& Min, const improbable::Coordinates& Max, TArray<Worker_EntityId>& OutEntityIds) const;
+
+	FORCEINLINE int32 Num() const { return Entries.Num(); }
+	FORCEINLINE int32 GetNumCells() const { return Cells.Num(); }
+	FORCEINLINE double GetCellSize() const { return CellSize; }
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FEntry
+	{
+		improbable::Coordinates Coords;
+		FIntPoint Cell;
+	};
+
+	FIntPoint GetCell(double X, double Z) const;
+
+	template <typename Predicate>
+	void Query(const improbable::Coordinates& Min, const improbable::Coordinates& Max, Predicate&& IsInside, TArray<Worker_EntityId>& OutEntityIds) const;
+
+	double CellSize;
+	double InvCellSize;
+
+	TMap<Worker_EntityId_Key, FEntry> Entries;
+	TMap<FIntPoint, TArray<Worker_EntityId>> Cells;
+};
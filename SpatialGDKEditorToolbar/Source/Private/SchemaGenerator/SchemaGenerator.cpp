@@ -363,7 +363,8 @@ int GenerateActorSchema(int ComponentId, UClass* Class, TSharedPtr<FUnrealType>
 
 	for (auto Group : GetRPCTypes())
 	{
-		if (RPCsByType[Group].Num() == 0 && Group != RPC_Client)
+		// Client and server RPC components are always generated, as they hold each other's RPC ring buffers.
+		if (RPCsByType[Group].Num() == 0 && Group != RPC_Client && Group != RPC_Server)
 		{
 			continue;
 		}
@@ -376,6 +377,11 @@ int GenerateActorSchema(int ComponentId, UClass* Class, TSharedPtr<FUnrealType>
 
 		ActorSchemaData.SchemaComponents[RPCTypeToSchemaComponentType(Group)] = IdGenerator.GetCurrentId();
 
+		if (Group == RPC_Client || Group == RPC_Server)
+		{
+			Writer.Print("data UnrealRPCRingBuffer;");
+		}
+
 		for (auto& RPC : RPCsByType[Group])
 		{
 			if (Group == ERPCType::RPC_NetMulticast)
@@ -460,9 +466,12 @@ FSubobjectSchemaData GenerateSubobjectSpecificSchema(FCodeWriter& Writer, FCompo
 
 	FUnrealRPCsByType RPCsByType = GetAllRPCsByType(TypeInfo);
 
+	const bool bHasClientOrServerRPCs = RPCsByType[RPC_Client].Num() > 0 || RPCsByType[RPC_Server].Num() > 0;
+
 	for (auto Group : GetRPCTypes())
 	{
-		if (RPCsByType[Group].Num() == 0)
+		const bool bIsClientOrServer = Group == RPC_Client || Group == RPC_Server;
+		if (RPCsByType[Group].Num() == 0 && !(bIsClientOrServer && bHasClientOrServerRPCs))
 		{
 			continue;
 		}
@@ -473,6 +482,10 @@ FSubobjectSchemaData GenerateSubobjectSpecificSchema(FCodeWriter& Writer, FCompo
 		Writer.Printf("component {0} {", *ComponentName);
 		Writer.Indent();
 		Writer.Printf("id = {0};", IdGenerator.GetNextAvailableId());
+		if (bIsClientOrServer)
+		{
+			Writer.Print("data UnrealRPCRingBuffer;");
+		}
 		for (auto& RPC : RPCsByType[Group])
 		{
 			if (Group == ERPCType::RPC_NetMulticast)